@@ -46,6 +46,11 @@
 #include "traceswo.h"
 #endif
 
+#if PC_HOSTED == 1
+#include "freq_profile.h"
+#include "mem_codec.h"
+#endif
+
 #if defined(_WIN32)
 #include <malloc.h>
 #else
@@ -80,6 +85,8 @@ static bool cmd_debug_bmp(target_s *t, int argc, const char **argv);
 #endif
 #if PC_HOSTED == 1
 static bool cmd_shutdown_bmda(target_s *t, int argc, const char **argv);
+static bool cmd_freq_calibrate(target_s *t, int argc, const char **argv);
+static bool cmd_mem_compress(target_s *t, int argc, const char **argv);
 #endif
 
 const command_s cmd_list[] = {
@@ -103,7 +110,7 @@ const command_s cmd_list[] = {
 #ifdef ENABLE_RTT
 	{"rtt", cmd_rtt,
 		"[enable|disable|status|channel [0..15 ...]|ident [STR]|cblock|ram [RAM_START RAM_END]|poll [MAXMS MINMS "
-		"MAXERR]]"},
+		"MAXERR]|mode [raw|framed]]"},
 #endif
 #ifdef PLATFORM_HAS_TRACESWO
 #if defined TRACESWO_PROTOCOL && TRACESWO_PROTOCOL == 2
@@ -118,6 +125,9 @@ const command_s cmd_list[] = {
 #endif
 #if PC_HOSTED == 1
 	{"shutdown_bmda", cmd_shutdown_bmda, "Tell the BMDA server to shut down when the GDB connection closes"},
+	{"freq_calibrate", cmd_freq_calibrate,
+		"Find and remember the fastest reliable interface frequency for the attached target"},
+	{"mem_compress", cmd_mem_compress, "Compress large RAM writes and expand them on the target: [enable|disable]"},
 #endif
 	{NULL, NULL, NULL},
 };
@@ -514,12 +524,18 @@ static bool cmd_rtt(target_s *t, int argc, const char **argv)
 	if (argc == 1 || (argc == 2 && strncmp(argv[1], "enabled", command_len) == 0)) {
 		rtt_enabled = true;
 		rtt_found = false;
+		rtt_stop_reason = NULL;
 		memset(rtt_channel, 0, sizeof(rtt_channel));
 	} else if (argc == 2 && strncmp(argv[1], "disabled", command_len) == 0) {
 		rtt_enabled = false;
 		rtt_found = false;
+		rtt_stop_reason = NULL;
 	} else if (argc == 2 && strncmp(argv[1], "status", command_len) == 0) {
-		gdb_outf("rtt: %s found: %s ident: ", on_or_off(rtt_enabled), rtt_found ? "yes" : "no");
+		/* rtt can turn itself off while GDB is waiting on the target, where it can't say so, so report that here */
+		gdb_outf("rtt: %s", on_or_off(rtt_enabled));
+		if (!rtt_enabled && rtt_stop_reason)
+			gdb_outf(" (%s)", rtt_stop_reason);
+		gdb_outf(" found: %s ident: ", rtt_found ? "yes" : "no");
 		if (rtt_ident[0] == '\0')
 			gdb_out("off");
 		else
@@ -536,6 +552,8 @@ static bool cmd_rtt(target_s *t, int argc, const char **argv)
 			gdb_outf("ram: 0x%08" PRIx32 " 0x%08" PRIx32, rtt_ram_start, rtt_ram_end);
 		gdb_outf("\nmax poll ms: %" PRIu32 " min poll ms: %" PRIu32 " max errs: %" PRIu32 "\n", rtt_max_poll_ms,
 			rtt_min_poll_ms, rtt_max_poll_errs);
+		gdb_outf("mode: %s up dropped: %" PRIu32 " up full: %" PRIu32 " down dropped: %" PRIu32 "\n",
+			rtt_flag_framed ? "framed" : "raw", rtt_up_dropped, rtt_up_full, rtt_down_dropped);
 	} else if (argc >= 2 && strncmp(argv[1], "channel", command_len) == 0) {
 		/* mon rtt channel switches to auto rtt channel selection
 		   mon rtt channel number... selects channels given */
@@ -555,7 +573,17 @@ static bool cmd_rtt(target_s *t, int argc, const char **argv)
 		rtt_ident[0] = '\0';
 	else if (argc == 2 && strncmp(argv[1], "poll", command_len) == 0)
 		gdb_outf("%" PRIu32 " %" PRIu32 " %" PRIu32 "\n", rtt_max_poll_ms, rtt_min_poll_ms, rtt_max_poll_errs);
-	else if (argc == 2 && strncmp(argv[1], "cblock", command_len) == 0) {
+	else if (argc == 2 && strncmp(argv[1], "mode", command_len) == 0)
+		gdb_outf("%s\n", rtt_flag_framed ? "framed" : "raw");
+	else if (argc == 3 && strncmp(argv[1], "mode", command_len) == 0) {
+		const size_t mode_len = strlen(argv[2]);
+		if (strncmp(argv[2], "framed", mode_len) == 0)
+			rtt_flag_framed = true;
+		else if (strncmp(argv[2], "raw", mode_len) == 0)
+			rtt_flag_framed = false;
+		else
+			gdb_out("mode?\n");
+	} else if (argc == 2 && strncmp(argv[1], "cblock", command_len) == 0) {
 		gdb_outf("cbaddr: 0x%08" PRIx32 "\n", rtt_cbaddr);
 		gdb_out("ch ena i/o buffer@      size   head   tail flag\n");
 		for (uint32_t i = 0; i < rtt_num_up_chan + rtt_num_down_chan; ++i) {
@@ -668,6 +696,35 @@ static bool cmd_shutdown_bmda(target_s *t, int argc, const char **argv)
 	shutdown_bmda = true;
 	return true;
 }
+
+static bool cmd_freq_calibrate(target_s *t, int argc, const char **argv)
+{
+	(void)argc;
+	(void)argv;
+	if (!t) {
+		gdb_out("Attach to a target first\n");
+		return false;
+	}
+	if (!freq_calibrate(t)) {
+		gdb_out("Frequency calibration failed\n");
+		return false;
+	}
+	gdb_outf("Frequency calibrated to %" PRIu32 "Hz\n", platform_max_frequency_get());
+	return true;
+}
+
+static bool cmd_mem_compress(target_s *t, int argc, const char **argv)
+{
+	(void)t;
+	if (argc == 2 && !parse_enable_or_disable(argv[1], &mem_codec_enabled))
+		return false;
+	if (argc > 2) {
+		gdb_out("Unrecognized command format\n");
+		return false;
+	}
+	gdb_outf("Compressed RAM writes: %s\n", mem_codec_enabled ? "enabled" : "disabled");
+	return true;
+}
 #endif
 
 /*
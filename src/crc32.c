@@ -100,6 +100,15 @@ static uint32_t crc32_calc(const uint32_t crc, const uint8_t data)
 	return (crc << 8U) ^ crc32_table[((crc >> 24U) ^ data) & 0xffU];
 }
 
+#if PC_HOSTED == 1
+uint32_t crc32_update(uint32_t crc, const uint8_t *const data, const size_t len)
+{
+	for (size_t i = 0; i < len; ++i)
+		crc = crc32_calc(crc, data[i]);
+	return crc;
+}
+#endif
+
 bool generic_crc32(target_s *const target, uint32_t *const result, const uint32_t base, const size_t len)
 {
 	uint32_t crc = 0xffffffffU;
@@ -186,3 +195,15 @@ bool generic_crc32(target_s *const target, uint32_t *const result, const uint32_
 	return true;
 }
 #endif
+
+/* Accumulate a block of data into an IEEE 802.3 (zlib) CRC-32, start with a CRC of 0 */
+uint32_t crc32_ieee_update(uint32_t crc, const uint8_t *const data, const size_t len)
+{
+	crc = ~crc;
+	for (size_t offset = 0; offset < len; ++offset) {
+		crc ^= data[offset];
+		for (size_t i = 0; i < 8U; ++i)
+			crc = (crc >> 1U) ^ (0xedb88320U & -(crc & 1U));
+	}
+	return ~crc;
+}
@@ -35,7 +35,6 @@
 #include "target.h"
 #include "target_internal.h"
 #include "command.h"
-#include "crc32.h"
 #include "morse.h"
 #ifdef ENABLE_RTT
 #include "rtt.h"
@@ -160,11 +159,11 @@ int gdb_main_loop(target_controller_s *tc, char *pbuf, size_t pbuf_size, size_t
 			break;
 		}
 		DEBUG_GDB("m packet: addr = %" PRIx32 ", len = %" PRIx32 "\n", addr, len);
-		uint8_t mem[len];
-		if (target_mem_read(cur_target, mem, addr, len))
+		/* Read straight into the (aligned) packet buffer and expand the data to hex where it lies */
+		if (target_mem_read(cur_target, pbuf, addr, len))
 			gdb_putpacketz("E01");
 		else
-			gdb_putpacket(hexify(pbuf, mem, len), len * 2U);
+			gdb_putpacket(hexify_in_place(pbuf, len), len * 2U);
 		break;
 	}
 	case 'G': { /* 'G XX': Write general registers */
@@ -493,7 +492,7 @@ static void exec_q_crc(const char *packet, const size_t length)
 			return;
 		}
 		uint32_t crc;
-		if (!generic_crc32(cur_target, &crc, addr, addr_length))
+		if (!target_crc32(cur_target, &crc, addr, addr_length))
 			gdb_putpacketz("E03");
 		else
 			gdb_putpacket_f("C%" PRIx32, crc);
@@ -28,6 +28,10 @@
 #include "gdb_packet.h"
 #include "hex_utils.h"
 #include "remote.h"
+#if defined(ENABLE_RTT) && PC_HOSTED == 0
+#include "gdb_main.h"
+#include "rtt.h"
+#endif
 
 #include <stdarg.h>
 
@@ -114,6 +118,24 @@ packet_state_e consume_remote_packet(char *const packet, const size_t size)
 #endif
 }
 
+#if defined(ENABLE_RTT) && PC_HOSTED == 0
+/*
+ * While waiting for GDB to start a packet, keep RTT serviced so it does not stall with the target halted.
+ * BMDA is left out as its GDB server only accepts a new connection from the blocking gdb_if_getchar().
+ */
+static char gdb_packet_idle_getchar(void)
+{
+	while (rtt_enabled && cur_target) {
+		const char rx_char = gdb_if_getchar_to(1);
+		/* A timeout reads as 0xff, which is never the start of a packet */
+		if (rx_char != '\xff')
+			return rx_char;
+		poll_rtt_idle(cur_target);
+	}
+	return gdb_if_getchar();
+}
+#endif
+
 size_t gdb_getpacket(char *const packet, const size_t size)
 {
 	packet_state_e state = PACKET_IDLE; /* State of the packet capture */
@@ -123,7 +145,11 @@ size_t gdb_getpacket(char *const packet, const size_t size)
 	uint8_t rx_checksum = 0;
 
 	while (true) {
+#if defined(ENABLE_RTT) && PC_HOSTED == 0
+		const char rx_char = state == PACKET_IDLE ? gdb_packet_idle_getchar() : gdb_if_getchar();
+#else
 		const char rx_char = gdb_if_getchar();
+#endif
 
 		switch (state) {
 		case PACKET_IDLE:
@@ -20,48 +20,175 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-/* Convenience functions to convert to/from ascii strings of hex digits. */
+/*
+ * Convenience functions to convert to/from ascii strings of hex digits.
+ *
+ * These sit on every byte of every GDB memory and register packet and every remote protocol
+ * memory transaction, so rather than going a nibble at a time they work in steps of several
+ * bytes: 16 at a time using SSE2 on hosted builds that have it, and otherwise a word at a time
+ * using SWAR (SIMD-within-a-register) arithmetic which suits the Cortex-M firmware well.
+ * A plain byte-at-a-time fallback is kept for big-endian hosts.
+ */
 
 #include "general.h"
 #include "hex_utils.h"
 
+#if PC_HOSTED == 1 && defined(__SSE2__)
+#include <emmintrin.h>
+#define HEX_STEP_SSE2
+#define HEX_STEP 16U
+#elif defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define HEX_STEP_SWAR
+#define HEX_STEP 4U
+#else
+#define HEX_STEP 1U
+#endif
+
+static const char hex_digits[16] = "0123456789ABCDEF";
+
 char hex_digit(const uint8_t value)
 {
-	char digit = (char)value;
-	if (value > 9U)
-		digit += 'A' - '0' - 10U;
-	digit += '0';
-	return digit;
+	return hex_digits[value & 0xfU];
+}
+
+uint8_t unhex_digit(const char hex)
+{
+	/* For '0'-'9' bit 6 is clear, for 'A'-'F' and 'a'-'f' it's set and the low nibble is 1-6 */
+	const uint8_t value = (uint8_t)hex;
+	return (value & 0xfU) + ((value >> 6U) & 1U) * 9U;
+}
+
+#if defined(HEX_STEP_SSE2)
+static inline __m128i hex_nibbles_to_ascii(const __m128i nibbles)
+{
+	/* '0' + n, plus another 7 for nibbles of 10 and up to land in 'A'-'F' */
+	const __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)), _mm_set1_epi8(7));
+	return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), letters);
+}
+
+/* Encode HEX_STEP bytes from src into 2 * HEX_STEP characters at dst. All input is consumed before any output */
+static inline void hex_encode_step(char *const dst, const uint8_t *const src)
+{
+	const __m128i data = _mm_loadu_si128((const __m128i *)src);
+	const __m128i mask = _mm_set1_epi8(0x0f);
+	const __m128i high = hex_nibbles_to_ascii(_mm_and_si128(_mm_srli_epi16(data, 4), mask));
+	const __m128i low = hex_nibbles_to_ascii(_mm_and_si128(data, mask));
+	/* Interleave the high and low nibble characters back into byte order */
+	_mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi8(high, low));
+	_mm_storeu_si128((__m128i *)(dst + 16U), _mm_unpackhi_epi8(high, low));
 }
 
+static inline __m128i hex_decode_half(const char *const hex)
+{
+	const __m128i chars = _mm_loadu_si128((const __m128i *)hex);
+	const __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('9')), _mm_set1_epi8(9));
+	const __m128i nibbles = _mm_add_epi8(_mm_and_si128(chars, _mm_set1_epi8(0x0f)), letters);
+	/* Each 16-bit lane holds the high nibble in its low byte and the low nibble in its high byte */
+	return _mm_or_si128(
+		_mm_slli_epi16(_mm_and_si128(nibbles, _mm_set1_epi16(0x00ff)), 4), _mm_srli_epi16(nibbles, 8));
+}
+
+/* Decode 2 * HEX_STEP characters from hex into HEX_STEP bytes at dst */
+static inline void hex_decode_step(uint8_t *const dst, const char *const hex)
+{
+	const __m128i first = hex_decode_half(hex);
+	const __m128i second = hex_decode_half(hex + 16U);
+	_mm_storeu_si128((__m128i *)dst, _mm_packus_epi16(first, second));
+}
+#elif defined(HEX_STEP_SWAR)
+/* Encode the two bytes in the bottom half of value into four characters, in memory order */
+static inline uint32_t hex_encode_pair(const uint32_t value)
+{
+	/* Give each byte its own 16-bit lane */
+	const uint32_t spread = (value & 0xffU) | ((value & 0xff00U) << 8U);
+	/* Move the high nibble of each byte to the low byte of its lane and the low nibble to the high byte */
+	const uint32_t nibbles = ((spread >> 4U) & 0x000f000fU) | ((spread & 0x000f000fU) << 8U);
+	/* '0' + n, plus another 7 for nibbles of 10 and up (which carry into bit 4 when 6 is added) */
+	const uint32_t letters = ((nibbles + 0x06060606U) >> 4U) & 0x01010101U;
+	return nibbles + 0x30303030U + letters * 7U;
+}
+
+/* Decode four characters, in memory order, into two bytes */
+static inline uint32_t hex_decode_quad(const uint32_t chars)
+{
+	const uint32_t nibbles = (chars & 0x0f0f0f0fU) + ((chars >> 6U) & 0x01010101U) * 9U;
+	const uint32_t bytes = ((nibbles & 0x000f000fU) << 4U) | ((nibbles >> 8U) & 0x000f000fU);
+	return (bytes & 0xffU) | ((bytes >> 8U) & 0xff00U);
+}
+
+/* Encode HEX_STEP bytes from src into 2 * HEX_STEP characters at dst. All input is consumed before any output */
+static inline void hex_encode_step(char *const dst, const uint8_t *const src)
+{
+	uint32_t value;
+	memcpy(&value, src, sizeof(value));
+	const uint32_t chars[2] = {hex_encode_pair(value), hex_encode_pair(value >> 16U)};
+	memcpy(dst, chars, sizeof(chars));
+}
+
+/* Decode 2 * HEX_STEP characters from hex into HEX_STEP bytes at dst */
+static inline void hex_decode_step(uint8_t *const dst, const char *const hex)
+{
+	uint32_t chars[2];
+	memcpy(chars, hex, sizeof(chars));
+	const uint32_t value = hex_decode_quad(chars[0]) | (hex_decode_quad(chars[1]) << 16U);
+	memcpy(dst, &value, sizeof(value));
+}
+#else
+static inline void hex_encode_step(char *const dst, const uint8_t *const src)
+{
+	const uint8_t value = *src;
+	dst[0] = hex_digit(value >> 4U);
+	dst[1] = hex_digit(value & 0xfU);
+}
+
+static inline void hex_decode_step(uint8_t *const dst, const char *const hex)
+{
+	*dst = (unhex_digit(hex[0]) << 4U) | unhex_digit(hex[1]);
+}
+#endif
+
 char *hexify(char *const hex, const void *const buf, const size_t size)
 {
-	char *dst = hex;
 	const uint8_t *const src = buf;
-
-	for (size_t idx = 0; idx < size; ++idx) {
-		*dst++ = hex_digit(src[idx] >> 4U);
-		*dst++ = hex_digit(src[idx] & 0xfU);
+	size_t idx = 0;
+	for (; idx + HEX_STEP <= size; idx += HEX_STEP)
+		hex_encode_step(hex + (idx * 2U), src + idx);
+	for (; idx < size; ++idx) {
+		hex[idx * 2U] = hex_digit(src[idx] >> 4U);
+		hex[(idx * 2U) + 1U] = hex_digit(src[idx] & 0xfU);
 	}
-	*dst = 0;
-
+	hex[size * 2U] = '\0';
 	return hex;
 }
 
-uint8_t unhex_digit(const char hex)
+char *hexify_in_place(char *const buf, const size_t size)
 {
-	uint8_t tmp = hex - '0';
-	if (tmp > 9U)
-		tmp -= 'A' - '0' - 10U;
-	if (tmp > 16U)
-		tmp -= 'a' - 'A';
-	return tmp;
+	const uint8_t *const src = (const uint8_t *)buf;
+	size_t idx = size;
+	/*
+	 * Work backwards from the end of the data so each step's output lands only on
+	 * input that has already been consumed. Start with the bytes that don't make up a full step.
+	 */
+	while (idx % HEX_STEP) {
+		--idx;
+		const uint8_t value = src[idx];
+		buf[idx * 2U] = hex_digit(value >> 4U);
+		buf[(idx * 2U) + 1U] = hex_digit(value & 0xfU);
+	}
+	while (idx) {
+		idx -= HEX_STEP;
+		hex_encode_step(buf + (idx * 2U), src + idx);
+	}
+	return buf;
 }
 
 char *unhexify(void *const buf, const char *hex, const size_t size)
 {
 	uint8_t *const dst = buf;
-	for (size_t idx = 0; idx < size; ++idx, hex += 2U)
-		dst[idx] = (unhex_digit(hex[0]) << 4U) | unhex_digit(hex[1]);
+	size_t idx = 0;
+	for (; idx + HEX_STEP <= size; idx += HEX_STEP)
+		hex_decode_step(dst + idx, hex + (idx * 2U));
+	for (; idx < size; ++idx)
+		dst[idx] = (unhex_digit(hex[idx * 2U]) << 4U) | unhex_digit(hex[(idx * 2U) + 1U]);
 	return buf;
 }
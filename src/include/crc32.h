@@ -25,5 +25,11 @@
 #include <target.h>
 
 bool generic_crc32(target_s *target, uint32_t *crc, uint32_t base, size_t len);
+#if PC_HOSTED == 1
+/* Accumulate a block of host-side data into a CRC computed the same way as generic_crc32() */
+uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t len);
+#endif
+/* Accumulate a block of data into an IEEE 802.3 (zlib) CRC-32, as computed by some targets' debug units */
+uint32_t crc32_ieee_update(uint32_t crc, const uint8_t *data, size_t len);
 
 #endif /* INCLUDE_CRC32_H */
@@ -28,6 +28,11 @@
 
 char *hexify(char *hex, const void *buf, size_t size);
 char *unhexify(void *buf, const char *hex, size_t size);
+/*
+ * Convert the size bytes of data at the start of buf into 2 * size hex digits in the same buffer,
+ * so data can be read straight into an outgoing packet buffer. Unlike hexify(), no terminating nul is written.
+ */
+char *hexify_in_place(char *buf, size_t size);
 
 char hex_digit(uint8_t value);
 uint8_t unhex_digit(char hex);
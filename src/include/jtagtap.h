@@ -70,6 +70,9 @@ extern jtag_proc_s jtag_proc;
 /* Goto Shift-DR: 1, 0, 0 */
 #define jtagtap_shift_dr() jtag_proc.jtagtap_tms_seq(0x01U, 3)
 
+/* Goto Shift-DR from Exit1-DR via Update-DR, spending cycles in Run-test/Idle on the way: 1, [0 * cycles], 1, 0, 0 */
+#define jtagtap_next_shift_dr(cycles) jtag_proc.jtagtap_tms_seq(0x01U | (0x01U << ((cycles) + 1U)), (cycles) + 4U)
+
 /* Goto Run-test/Idle: 1, 1, 0 */
 #define jtagtap_return_idle(cycles) jtag_proc.jtagtap_tms_seq(0x01, (cycles) + 1U)
 
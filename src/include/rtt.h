@@ -34,6 +34,7 @@
 extern char rtt_ident[16];                     // string
 extern bool rtt_enabled;                       // rtt on/off
 extern bool rtt_found;                         // control block found
+extern const char *rtt_stop_reason;            // why rtt turned itself off, NULL if it did not
 extern uint32_t rtt_cbaddr;                    // control block address
 extern uint32_t rtt_num_up_chan;               // number of 'up' channels
 extern uint32_t rtt_num_down_chan;             // number of 'down' channels
@@ -47,6 +48,10 @@ extern bool rtt_auto_channel;                  // manual or auto channel selecti
 extern bool rtt_flag_skip;                     // skip if host-to-target fifo full
 extern bool rtt_flag_block;                    // block if host-to-target fifo full
 extern bool rtt_channel_enabled[MAX_RTT_CHAN]; // true if user wants to see channel
+extern bool rtt_flag_framed;                   // tag data to and from the host with its channel number
+extern uint32_t rtt_up_dropped;                // bytes from the target the host did not take in time
+extern uint32_t rtt_up_full;                   // polls that found a target 'up' buffer full
+extern uint32_t rtt_down_dropped;              // bytes from the host that could not be given to the target
 
 typedef struct rtt_channel {
 	uint32_t name_addr;
@@ -59,6 +64,19 @@ typedef struct rtt_channel {
 
 extern rtt_channel_s rtt_channel[MAX_RTT_CHAN];
 
+/*
+ * Framed mode: every chunk of data exchanged with the host is sent as [channel][length][payload...].
+ * From the target, channel is the 'up' buffer number; to the target, it is the 'down' buffer number.
+ * Frames are kept shorter than a full-speed USB packet so each one is delivered whole or not at all.
+ * When data from the target had to be dropped, a frame on RTT_FRAME_DROPPED carries the number of
+ * bytes lost since the last such report as a 32-bit little endian value ahead of the next data frame.
+ */
+#define RTT_FRAME_HEADER_LEN  2U
+#define RTT_FRAME_MAX_PAYLOAD 61U
+#define RTT_FRAME_DROPPED     0xffU
+
 void poll_rtt(target_s *cur_target);
+/* Service RTT while waiting on GDB, without sending any console output to it */
+void poll_rtt_idle(target_s *cur_target);
 
 #endif /* INCLUDE_RTT_H */
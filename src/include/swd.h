@@ -35,6 +35,11 @@ typedef struct swd_proc {
 	void (*seq_out)(uint32_t tms_states, size_t clock_cycles);
 	/* Perform a clock_cycles write + parity with the provided data */
 	void (*seq_out_parity)(uint32_t tms_states, size_t clock_cycles);
+	/*
+	 * Optional: perform count back-to-back write transactions with the given request and data, without
+	 * checking ACKs or inserting idle cycles. Only valid with overrun detection enabled on the DP
+	 */
+	void (*seq_write_burst)(uint8_t request, const uint32_t *data, size_t count);
 } swd_proc_s;
 
 extern swd_proc_s swd_proc;
@@ -61,11 +61,19 @@ bool target_mem_map(target_s *target, char *buf, size_t len);
 int target_mem_read(target_s *target, void *dest, target_addr_t src, size_t len);
 int target_mem_write(target_s *target, target_addr_t dest, const void *src, size_t len);
 bool target_mem_access_needs_halt(target_s *target);
+/* Compute the CRC-32 of a range as GDB's qCRC packet expects, using the target's CRC hardware when it can */
+bool target_crc32(target_s *target, uint32_t *result, target_addr_t base, size_t len);
 /* Flash memory access functions */
 bool target_flash_erase(target_s *target, target_addr_t addr, size_t len);
 bool target_flash_write(target_s *target, target_addr_t dest, const void *src, size_t len);
 bool target_flash_complete(target_s *target);
 
+/* Option byte and protection state functions */
+#define TARGET_PROTECTION_MAX_WORDS 16U
+size_t target_protection_words(target_s *target);
+bool target_protection_read(target_s *target, uint32_t *words, size_t count);
+bool target_protection_apply(target_s *target, const uint32_t *words, size_t count);
+
 /* Register access functions */
 size_t target_regs_size(target_s *target);
 const char *target_regs_description(target_s *target);
@@ -0,0 +1 @@
+#define FIRMWARE_VERSION "b039c56-dirty"
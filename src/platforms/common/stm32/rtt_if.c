@@ -74,6 +74,7 @@ void rtt_serial_receive_callback(usbd_device *dev, uint8_t ep)
 
 	/* skip flag: drop packet if not enough free buffer space */
 	if (rtt_flag_skip && len > recv_bytes_free()) {
+		rtt_down_dropped += len;
 		usbd_ep_nak_set(usbdev, CDCACM_UART_ENDPOINT, 0);
 		return;
 	}
@@ -81,8 +82,10 @@ void rtt_serial_receive_callback(usbd_device *dev, uint8_t ep)
 	/* copy data to recv_buf */
 	for (int i = 0; i < len; i++) {
 		uint32_t next_recv_head = (recv_head + 1U) % sizeof(recv_buf);
-		if (next_recv_head == recv_tail)
-			break; /* overflow */
+		if (next_recv_head == recv_tail) {
+			rtt_down_dropped += len - i; /* overflow */
+			break;
+		}
 		recv_buf[recv_head] = usb_buf[i];
 		recv_head = next_recv_head;
 	}
@@ -115,7 +118,7 @@ bool rtt_nodata()
 	return recv_head == recv_tail;
 }
 
-/* rtt target to host: write string */
+/* rtt target to host: write string, returns the number of bytes sent */
 uint32_t rtt_write(const char *buf, uint32_t len)
 {
 	if (len != 0 && usbdev && usb_get_config() && gdb_serial_get_dtr()) {
@@ -124,7 +127,7 @@ uint32_t rtt_write(const char *buf, uint32_t len)
 			uint32_t start_ms = platform_time_ms();
 			while (usbd_ep_write_packet(usbdev, CDCACM_UART_ENDPOINT, buf + p, plen) <= 0) {
 				if (platform_time_ms() - start_ms >= 25)
-					return 0; /* drop silently */
+					return p; /* drop, reporting how much was sent */
 			}
 		}
 		/* flush 64-byte packet on full-speed */
@@ -22,6 +22,9 @@
 #include "platform.h"
 #include "morse.h"
 #include "usb.h"
+#ifdef PLATFORM_HAS_TRACESWO
+#include "traceswo.h"
+#endif
 
 #include <libopencm3/cm3/systick.h>
 #include <libopencm3/cm3/nvic.h>
@@ -90,6 +93,11 @@ void sys_tick_handler(void)
 	} else
 		++morse_tick;
 
+#ifdef PLATFORM_HAS_TRACESWO
+	/* Decode any SWO data captured since the last tick at low priority, away from the capture interrupt */
+	traceswo_decode_poll();
+#endif
+
 #if defined(PLATFORM_HAS_POWER_SWITCH) && defined(STM32F1)
 	/* First check if target power is presently enabled */
 	if (platform_target_get_power()) {
@@ -31,6 +31,7 @@
  * These can be capture directly to RAM by DMA.
  * The core can then process the buffer to extract the frame.
  */
+#include <stdatomic.h>
 #include "general.h"
 #include "platform.h"
 #include "usb.h"
@@ -40,14 +41,29 @@
 #include <libopencm3/stm32/timer.h>
 #include <libopencm3/stm32/rcc.h>
 
+#ifndef TRACE_FIFO_SIZE
+#define TRACE_FIFO_SIZE 1024U
+#endif
+
 /* SWO decoding */
 static bool decoding = false;
 
-static uint8_t trace_usb_buf[64];
-static uint8_t trace_usb_buf_size;
+/* Bytes decoded from the line, waiting to be sent over USB */
+static uint8_t trace_fifo[TRACE_FIFO_SIZE];
+static volatile uint32_t trace_fifo_head;
+static volatile uint32_t trace_fifo_tail;
+/* Set when bytes were dropped, with the FIFO position of the first byte captured after the gap */
+static volatile bool overflowed = false;
+static volatile uint32_t overflow_pos;
 
 void traceswo_init(uint32_t swo_chan_bitmask)
 {
+	/* Start with an empty FIFO, keeping the capture interrupt out of the way if this is a re-init */
+	nvic_disable_irq(TRACE_IRQ);
+	trace_fifo_head = 0;
+	trace_fifo_tail = 0;
+	overflowed = false;
+
 	TRACE_TIM_CLK_EN();
 
 	/* Refer to ST doc RM0008 - STM32F10xx Reference Manual.
@@ -85,32 +101,69 @@ void traceswo_init(uint32_t swo_chan_bitmask)
 	decoding = (swo_chan_bitmask != 0);
 }
 
-void trace_buf_push(uint8_t *buf, int len)
+/* Number of bytes that can be read from the FIFO without wrapping */
+static uint32_t trace_fifo_contiguous(void)
 {
-	if (decoding)
-		traceswo_decode(usbdev, CDCACM_UART_ENDPOINT, buf, len);
-	else if (usbd_ep_write_packet(usbdev, USB_REQ_TYPE_IN | TRACE_ENDPOINT, buf, len) != len) {
-		if (trace_usb_buf_size + len > 64) {
-			/* Stall if upstream to too slow. */
-			usbd_ep_stall_set(usbdev, USB_REQ_TYPE_IN | TRACE_ENDPOINT, 1);
-			trace_usb_buf_size = 0;
-			return;
-		}
-		memcpy(trace_usb_buf + trace_usb_buf_size, buf, len);
-		trace_usb_buf_size += len;
-	}
+	const uint32_t head = trace_fifo_head;
+	if (head >= trace_fifo_tail)
+		return head - trace_fifo_tail;
+	return TRACE_FIFO_SIZE - trace_fifo_tail;
 }
 
 void trace_buf_drain(usbd_device *dev, uint8_t ep)
 {
-	if (!trace_usb_buf_size)
-		return;
+	static atomic_flag reentry_flag = ATOMIC_FLAG_INIT;
 
+	/* Decoding is done from traceswo_decode_poll() instead */
 	if (decoding)
-		traceswo_decode(dev, CDCACM_UART_ENDPOINT, trace_usb_buf, trace_usb_buf_size);
-	else
-		usbd_ep_write_packet(dev, ep, trace_usb_buf, trace_usb_buf_size);
-	trace_usb_buf_size = 0;
+		return;
+	/* If we are already in this routine then we don't need to come in again */
+	if (atomic_flag_test_and_set_explicit(&reentry_flag, memory_order_relaxed))
+		return;
+	if (overflowed && trace_fifo_tail == overflow_pos) {
+		/* Mark where data was lost before sending what was captured after it */
+		static const uint8_t overflow_packet = TRACESWO_OVERFLOW_PACKET;
+		if (usbd_ep_write_packet(dev, ep, &overflow_packet, 1U))
+			overflowed = false;
+	} else {
+		uint32_t len = MIN(trace_fifo_contiguous(), TRACE_ENDPOINT_SIZE);
+		if (overflowed && trace_fifo_tail < overflow_pos)
+			len = MIN(len, overflow_pos - trace_fifo_tail);
+		if (len && usbd_ep_write_packet(dev, ep, &trace_fifo[trace_fifo_tail], len))
+			trace_fifo_tail = (trace_fifo_tail + len) % TRACE_FIFO_SIZE;
+	}
+	atomic_flag_clear_explicit(&reentry_flag, memory_order_relaxed);
+}
+
+void traceswo_decode_poll(void)
+{
+	while (decoding) {
+		const uint32_t len = trace_fifo_contiguous();
+		if (!len)
+			break;
+		traceswo_decode(usbdev, CDCACM_UART_ENDPOINT, &trace_fifo[trace_fifo_tail], len);
+		trace_fifo_tail = (trace_fifo_tail + len) % TRACE_FIFO_SIZE;
+		/* The decoder has no use for the overflow marker, so don't leave it set for a later switch to raw mode */
+		overflowed = false;
+	}
+}
+
+/* Queue bytes from the decoder, dropping what does not fit rather than stalling the endpoint */
+static void trace_buf_push(const uint8_t *const buf, const uint32_t len)
+{
+	for (uint32_t i = 0; i < len; ++i) {
+		const uint32_t next_head = (trace_fifo_head + 1U) % TRACE_FIFO_SIZE;
+		if (next_head == trace_fifo_tail) {
+			if (!overflowed) {
+				overflow_pos = trace_fifo_head;
+				overflowed = true;
+			}
+			break;
+		}
+		trace_fifo[trace_fifo_head] = buf[i];
+		trace_fifo_head = next_head;
+	}
+	trace_buf_drain(usbdev, USB_REQ_TYPE_IN | TRACE_ENDPOINT);
 }
 
 #define ALLOWED_DUTY_ERROR 5
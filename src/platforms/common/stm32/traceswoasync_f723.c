@@ -48,6 +48,9 @@ static volatile uint32_t read_index;  /* Packet currently waiting to transmit to
 static uint8_t trace_rx_buf[NUM_TRACE_PACKETS * TRACE_ENDPOINT_SIZE];
 /* Packet pingpong buffer used for receiving packets */
 static uint8_t pingpong_buf[2 * TRACE_ENDPOINT_SIZE];
+/* Set when packets were dropped, with the index of the first packet captured after the gap */
+static volatile bool overflowed = false;
+static volatile uint32_t overflow_index;
 /* SWO decoding */
 static bool decoding = false;
 
@@ -55,26 +58,50 @@ void trace_buf_drain(usbd_device *dev, uint8_t ep)
 {
 	static atomic_flag reentry_flag = ATOMIC_FLAG_INIT;
 
+	/* Decoding is done from traceswo_decode_poll() instead */
+	if (decoding)
+		return;
 	/* If we are already in this routine then we don't need to come in again */
 	if (atomic_flag_test_and_set_explicit(&reentry_flag, memory_order_relaxed))
 		return;
-	/* Attempt to write everything we buffered */
-	if (write_index != read_index) {
-		uint16_t result;
-		if (decoding)
-			/* write decoded swo packets to the uart port */
-			result = traceswo_decode(
-				dev, CDCACM_UART_ENDPOINT, &trace_rx_buf[read_index * TRACE_ENDPOINT_SIZE], TRACE_ENDPOINT_SIZE);
-		else
-			/* write raw swo packets to the trace port */
-			result =
-				usbd_ep_write_packet(dev, ep, &trace_rx_buf[read_index * TRACE_ENDPOINT_SIZE], TRACE_ENDPOINT_SIZE);
-		if (result)
+	if (overflowed && read_index == overflow_index) {
+		/* mark where data was lost before sending what was captured after it */
+		static const uint8_t overflow_packet = TRACESWO_OVERFLOW_PACKET;
+		if (usbd_ep_write_packet(dev, ep, &overflow_packet, 1U))
+			overflowed = false;
+	} else if (write_index != read_index) {
+		/* write raw swo packets to the trace port */
+		if (usbd_ep_write_packet(dev, ep, &trace_rx_buf[read_index * TRACE_ENDPOINT_SIZE], TRACE_ENDPOINT_SIZE))
 			read_index = (read_index + 1U) % NUM_TRACE_PACKETS;
 	}
 	atomic_flag_clear_explicit(&reentry_flag, memory_order_relaxed);
 }
 
+void traceswo_decode_poll(void)
+{
+	/* write decoded swo packets to the uart port */
+	while (decoding && write_index != read_index) {
+		traceswo_decode(usbdev, CDCACM_UART_ENDPOINT, &trace_rx_buf[read_index * TRACE_ENDPOINT_SIZE],
+			TRACE_ENDPOINT_SIZE);
+		read_index = (read_index + 1U) % NUM_TRACE_PACKETS;
+	}
+}
+
+/* Queue a completed half of the pingpong buffer, dropping it if USB has fallen a whole buffer behind */
+static void trace_buf_queue(const uint8_t *const packet)
+{
+	const uint32_t next_index = (write_index + 1U) % NUM_TRACE_PACKETS;
+	if (next_index == read_index) {
+		if (!overflowed) {
+			overflow_index = write_index;
+			overflowed = true;
+		}
+		return;
+	}
+	memcpy(&trace_rx_buf[write_index * TRACE_ENDPOINT_SIZE], packet, TRACE_ENDPOINT_SIZE);
+	write_index = next_index;
+}
+
 void traceswo_setspeed(uint32_t baudrate)
 {
 	dma_disable_stream(SWO_DMA_BUS, SWO_DMA_STREAM);
@@ -101,6 +128,7 @@ void traceswo_setspeed(uint32_t baudrate)
 	usart_enable(SWO_UART);
 	nvic_enable_irq(SWO_DMA_IRQ);
 	write_index = read_index = 0;
+	overflowed = false;
 	dma_set_memory_address(SWO_DMA_BUS, SWO_DMA_STREAM, (uint32_t)pingpong_buf);
 	dma_set_number_of_data(SWO_DMA_BUS, SWO_DMA_STREAM, 2 * TRACE_ENDPOINT_SIZE);
 	dma_channel_select(SWO_DMA_BUS, SWO_DMA_STREAM, DMA_SxCR_CHSEL_4);
@@ -112,14 +140,12 @@ void SWO_DMA_ISR(void)
 {
 	if (DMA_LISR(SWO_DMA_BUS) & DMA_LISR_HTIF0) {
 		DMA_LIFCR(SWO_DMA_BUS) |= DMA_LISR_HTIF0;
-		memcpy(&trace_rx_buf[write_index * TRACE_ENDPOINT_SIZE], pingpong_buf, TRACE_ENDPOINT_SIZE);
+		trace_buf_queue(pingpong_buf);
 	}
 	if (DMA_LISR(SWO_DMA_BUS) & DMA_LISR_TCIF0) {
 		DMA_LIFCR(SWO_DMA_BUS) |= DMA_LISR_TCIF0;
-		memcpy(
-			&trace_rx_buf[write_index * TRACE_ENDPOINT_SIZE], &pingpong_buf[TRACE_ENDPOINT_SIZE], TRACE_ENDPOINT_SIZE);
+		trace_buf_queue(&pingpong_buf[TRACE_ENDPOINT_SIZE]);
 	}
-	write_index = (write_index + 1) % NUM_TRACE_PACKETS;
 	trace_buf_drain(usbdev, TRACE_ENDPOINT);
 }
 
@@ -44,6 +44,7 @@ static uint32_t swdptap_seq_in(size_t clock_cycles) __attribute__((optimize(3)))
 static bool swdptap_seq_in_parity(uint32_t *ret, size_t clock_cycles) __attribute__((optimize(3)));
 static void swdptap_seq_out(uint32_t tms_states, size_t clock_cycles) __attribute__((optimize(3)));
 static void swdptap_seq_out_parity(uint32_t tms_states, size_t clock_cycles) __attribute__((optimize(3)));
+static void swdptap_seq_write_burst(uint8_t request, const uint32_t *data, size_t count) __attribute__((optimize(3)));
 
 void swdptap_init(void)
 {
@@ -51,6 +52,7 @@ void swdptap_init(void)
 	swd_proc.seq_in_parity = swdptap_seq_in_parity;
 	swd_proc.seq_out = swdptap_seq_out;
 	swd_proc.seq_out_parity = swdptap_seq_out_parity;
+	swd_proc.seq_write_burst = swdptap_seq_write_burst;
 }
 
 static void swdptap_turnaround(const swdio_status_t dir)
@@ -192,3 +194,16 @@ static void swdptap_seq_out_parity(const uint32_t tms_states, const size_t clock
 		continue;
 	gpio_clear(SWCLK_PORT, SWCLK_PIN);
 }
+
+static void swdptap_seq_write_burst(const uint8_t request, const uint32_t *const data, const size_t count)
+{
+	for (size_t i = 0; i < count; ++i) {
+		swdptap_seq_out(request, 8U);
+		/*
+		 * Throw the ACK away - with overrun detection on, any WAIT or FAULT is latched in STICKYORUN
+		 * and the data phase must be clocked out regardless, so there's nothing to branch on here.
+		 */
+		swdptap_seq_in(3U);
+		swdptap_seq_out_parity(data[i], 32U);
+	}
+}
@@ -39,4 +39,13 @@ void traceswo_setmask(uint32_t mask);
 /* Print decoded SWO packet on USB serial */
 uint16_t traceswo_decode(usbd_device *usbd_dev, uint8_t addr, const void *buf, uint16_t len);
 
+/*
+ * ITM overflow packet, sent in the raw stream where captured SWO data
+ * had to be dropped because USB did not keep up
+ */
+#define TRACESWO_OVERFLOW_PACKET 0x70U
+
+/* Decode buffered SWO data, called from a low priority context so decoding never holds up capture */
+void traceswo_decode_poll(void);
+
 #endif /* PLATFORMS_COMMON_TRACESWO_H */
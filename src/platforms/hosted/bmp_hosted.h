@@ -98,6 +98,12 @@ void bmp_ident(bmda_probe_s *info);
 int find_debuggers(bmda_cli_options_s *cl_opts, bmda_probe_s *info);
 void libusb_exit_function(bmda_probe_s *info);
 
+/* Daemon mode support */
+void bmda_daemon_scan(void);
+void bmda_daemon_poll(void);
+void bmda_daemon_client_connected(void);
+int bmda_daemon_run_command(uint16_t port, uint32_t target_number, const char *command);
+
 #if HOSTED_BMP_ONLY == 1
 bool device_is_bmp_gdb_port(const char *device);
 #else
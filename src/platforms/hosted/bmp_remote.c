@@ -33,6 +33,7 @@
 #include "remote/protocol_v1.h"
 #include "remote/protocol_v2.h"
 #include "remote/protocol_v3.h"
+#include "remote/protocol_v4.h"
 
 #include <assert.h>
 #include <sys/time.h>
@@ -98,6 +99,9 @@ bool remote_init(const bool power_up)
 		case 3:
 			remote_v3_init();
 			break;
+		case 4:
+			remote_v4_init();
+			break;
 		default:
 			DEBUG_ERROR("Unknown remote protocol version %" PRIu64 ", aborting\n", version);
 			return false;
@@ -209,6 +213,20 @@ void remote_adiv5_dp_init(adiv5_debug_port_s *const dp)
 	remote_funcs.adiv5_init(dp);
 }
 
+bool remote_riscv_jtag_dtm_init(riscv_dmi_s *const dmi)
+{
+	if (remote_funcs.riscv_jtag_init)
+		return remote_funcs.riscv_jtag_init(dmi);
+	return false;
+}
+
+const cortexar_dbg_ops_s *remote_cortexar_dbg_ops(void)
+{
+	if (remote_funcs.cortexar_dbg_ops)
+		return remote_funcs.cortexar_dbg_ops();
+	return NULL;
+}
+
 void remote_add_jtag_dev(uint32_t dev_index, const jtag_dev_s *jtag_dev)
 {
 	if (remote_funcs.add_jtag_dev)
@@ -29,6 +29,8 @@
 #include "adiv5.h"
 #include "target.h"
 #include "target_internal.h"
+#include "riscv_debug.h"
+#include "cortexar.h"
 
 #define REMOTE_MAX_MSG_SIZE 1024U
 
@@ -36,6 +38,8 @@ typedef struct bmp_remote_protocol {
 	bool (*swd_init)(void);
 	bool (*jtag_init)(void);
 	bool (*adiv5_init)(adiv5_debug_port_s *dp);
+	bool (*riscv_jtag_init)(riscv_dmi_s *dmi);
+	const cortexar_dbg_ops_s *(*cortexar_dbg_ops)(void);
 	void (*add_jtag_dev)(uint32_t dev_index, const jtag_dev_s *jtag_dev);
 	uint32_t (*get_comms_frequency)(void);
 	bool (*set_comms_frequency)(uint32_t freq);
@@ -60,6 +64,8 @@ uint32_t remote_max_frequency_get(void);
 void remote_target_clk_output_enable(bool enable);
 
 void remote_adiv5_dp_init(adiv5_debug_port_s *dp);
+bool remote_riscv_jtag_dtm_init(riscv_dmi_s *dmi);
+const cortexar_dbg_ops_s *remote_cortexar_dbg_ops(void);
 void remote_add_jtag_dev(uint32_t dev_index, const jtag_dev_s *jtag_dev);
 
 uint64_t remote_decode_response(const char *response, size_t digits);
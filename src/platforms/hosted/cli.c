@@ -36,6 +36,8 @@
 
 #include "cli.h"
 #include "bmp_hosted.h"
+#include "mem_dump.h"
+#include "crc32.h"
 
 #ifndef O_BINARY
 #define O_BINARY 0
@@ -130,10 +132,14 @@ static void cl_help(char **argv)
 	bmp_ident(NULL);
 	DEBUG_INFO("\n"
 			   "Usage: %s [-h | -l | [-v BITMASK] [-O] [-d PATH | -P NUMBER | -s SERIAL | -c TYPE]\n"
-			   "\t[-n NUMBER] [-j | -A] [-C] [-t | -T] [-e] [-p] [-R[h]] [-H] [-M STRING ...]\n"
-			   "\t[-f | -m] [-E | -w | -V | -r] [-a ADDR] [-S number] [file]]\n"
+			   "\t[-n NUMBER] [-j | -A] [-C] [-t | -T] [-e] [-p] [-R[h]] [-H] [-D] [-M STRING ...]\n"
+			   "\t[-o[WORDS]] [-X PORT]\n"
+			   "\t[-f | -m] [-E | -w | -V | -r] [-a ADDR] [-S number] [-u] [file]]\n"
 			   "\n"
 			   "The default is to start a debug server at localhost:2000\n\n"
+			   "When -X is given, the monitor command given by -M is instead run by the BMDA\n"
+			   "daemon listening on the given port on this machine, using its already open probe\n"
+			   "and scanned targets\n\n"
 			   "Single-shot and verbosity options [-h | -l | -v BITMASK]:\n"
 			   "\t-h, --help       Show the version and this help, then exit\n"
 			   "\t-l, --list       List available supported probes\n"
@@ -151,7 +157,7 @@ static void cl_help(char **argv)
 			   "\t                   type (cable)\n"
 			   "\n"
 			   "General configuration options: [-n NUMBER] [-j] [-C] [-t | -T] [-e] [-p] [-R[h]]\n"
-			   "\t\t[-H] [-M STRING ...]\n"
+			   "\t\t[-H] [-D] [-M STRING ...] [-o[WORDS]] [-k OP[,PATTERN]] [-X PORT]\n"
 			   "\t-n, --number     Select the target device at the given position in the\n"
 			   "\t                   scan chain (use the -t option to get a scan chain listing)\n"
 			   "\t-j, --jtag       Use JTAG instead of SWD\n"
@@ -169,10 +175,21 @@ static void cl_help(char **argv)
 			   "\t-R, --reset      Reset the device. If followed by 'h', this will be done using\n"
 			   "\t                   the hardware reset line instead of over the debug link\n"
 			   "\t-H, --high-level Do not use the high level command API (bmp-remote)\n"
+			   "\t-D, --daemon     Run the debug server as a daemon: scan for targets up front,\n"
+			   "\t                   keep the probe and targets warm between connections and\n"
+			   "\t                   rescan when target power is lost and restored\n"
 			   "\t-M, --monitor    Run target-specific monitor commands. This option\n"
 			   "\t                   can be repeated for as many commands you wish to run.\n"
 			   "\t                   If the command contains spaces, use quotes around the\n"
 			   "\t                   complete command\n"
+			   "\t-o, --protection Show the target's option bytes/protection state, or if followed\n"
+			   "\t                   by a comma separated list of words, apply it in a single\n"
+			   "\t                   transaction, only changing the words that differ. Use '-'\n"
+			   "\t                   to leave a word as it is\n"
+			   "\t-k, --memtest    Run a memory test or fill on the target itself over the region\n"
+			   "\t                   given by -a and -S. OP is one of fill, walk, addr, march or\n"
+			   "\t                   pattern, optionally followed by a comma and the pattern to use\n"
+			   "\t-X, --connect    Run the -M, -o or -k command via the daemon listening on this port\n"
 			   "\n"
 			   "SWD-specific configuration options [-f FREQUENCY | -m TARGET]:\n"
 			   "\t-f, --freq       Set an operating frequency for SWD\n"
@@ -186,11 +203,13 @@ static void cl_help(char **argv)
 			   "\t                   binary file\n"
 			   "\t-r, --read       Read the target device Flash\n"
 			   "\n"
-			   "Flash operation modifiers options: [-a ADDR] [-S number] [FILE]\n"
+			   "Flash operation modifiers options: [-a ADDR] [-S number] [-u] [FILE]\n"
 			   "\t-a, --addr       Start address for the given Flash operation (defaults to\n"
 			   "\t                   the start of Flash)\n"
 			   "\t-S, --byte-count Number of bytes to work on in the Flash operation (default\n"
 			   "\t                   is till the operation fails or is complete)\n"
+			   "\t-u, --resume     When reading, keep what is already in the file and\n"
+			   "\t                   continue the read from where it left off\n"
 			   "\t<file>           Binary file to use in Flash operations\n",
 		argv[0]);
 	exit(0);
@@ -217,6 +236,10 @@ static const getopt_option_s long_options[] = {
 	{"reset", optional_argument, NULL, 'R'},
 	{"high-level", no_argument, NULL, 'H'},
 	{"monitor", required_argument, NULL, 'M'},
+	{"protection", optional_argument, NULL, 'o'},
+	{"memtest", required_argument, NULL, 'k'},
+	{"daemon", no_argument, NULL, 'D'},
+	{"connect", required_argument, NULL, 'X'},
 	{"freq", required_argument, NULL, 'f'},
 	{"multi-drop", required_argument, NULL, 'm'},
 	{"erase", no_argument, NULL, 'E'},
@@ -225,6 +248,7 @@ static const getopt_option_s long_options[] = {
 	{"read", no_argument, NULL, 'r'},
 	{"addr", required_argument, NULL, 'a'},
 	{"byte-count", required_argument, NULL, 'S'},
+	{"resume", no_argument, NULL, 'u'},
 	{NULL, 0, NULL, 0},
 };
 
@@ -236,8 +260,11 @@ void cl_init(bmda_cli_options_s *opt, int argc, char **argv)
 	opt->opt_max_swj_frequency = 4000000;
 	opt->opt_scanmode = BMP_SCAN_SWD;
 	opt->opt_mode = BMP_MODE_DEBUG;
+	const char *protection = NULL;
+	const char *memtest = NULL;
 	while (true) {
-		const int option = getopt_long(argc, argv, "eEFhHv:Od:f:s:I:c:Cln:m:M:wVtTa:S:jApP:rR::", long_options, NULL);
+		const int option =
+			getopt_long(argc, argv, "eEFhHv:Od:f:s:I:c:Cln:m:M:o::k:wVtTa:S:jApP:rR::uDX:", long_options, NULL);
 		if (option == -1)
 			break;
 
@@ -257,6 +284,21 @@ void cl_init(bmda_cli_options_s *opt, int argc, char **argv)
 		case 'H':
 			opt->opt_no_hl = true;
 			break;
+		case 'D':
+			opt->opt_daemon = true;
+			break;
+		case 'X':
+			if (optarg) {
+				const char *end = optarg + strlen(optarg);
+				char *valid = NULL;
+				const unsigned long port = strtoul(optarg, &valid, 0);
+				if (valid != end || valid == optarg || !port || port > UINT16_MAX) {
+					DEBUG_ERROR("Value after connect flag was not a valid port number, got '%s'\n", optarg);
+					exit(1);
+				}
+				opt->opt_daemon_port = (uint16_t)port;
+			}
+			break;
 		case 'v':
 			if (optarg) {
 				const char *end = optarg + strlen(optarg);
@@ -307,6 +349,7 @@ void cl_init(bmda_cli_options_s *opt, int argc, char **argv)
 					break;
 				}
 				opt->opt_max_swj_frequency = frequency;
+				opt->opt_max_swj_frequency_set = true;
 			}
 			break;
 		case 's':
@@ -342,6 +385,9 @@ void cl_init(bmda_cli_options_s *opt, int argc, char **argv)
 		case 'r':
 			opt->opt_mode = BMP_MODE_FLASH_READ;
 			break;
+		case 'u':
+			opt->opt_resume = true;
+			break;
 		case 'R':
 			if ((optarg) && (tolower(optarg[0]) == 'h'))
 				opt->opt_mode = BMP_MODE_RESET_HW;
@@ -367,6 +413,12 @@ void cl_init(bmda_cli_options_s *opt, int argc, char **argv)
 			if (optarg)
 				opt->opt_monitor = optarg;
 			break;
+		case 'o':
+			protection = optarg ? optarg : "";
+			break;
+		case 'k':
+			memtest = optarg;
+			break;
 		case 'P':
 			if (optarg)
 				opt->opt_position = strtol(optarg, NULL, 0);
@@ -390,6 +442,43 @@ void cl_init(bmda_cli_options_s *opt, int argc, char **argv)
 			}
 		}
 	}
+	if (protection) {
+		if (opt->opt_monitor || memtest) {
+			DEBUG_ERROR("Only one of -M, -o and -k may be given\n");
+			exit(1);
+		}
+		/* Turn the request into a `protection` monitor command so it also works via the daemon */
+		const size_t length = strlen(protection);
+		opt->opt_monitor = malloc(length + 12U);
+		if (!opt->opt_monitor) {
+			DEBUG_ERROR("malloc: failed in %s\n", __func__);
+			exit(1);
+		}
+		memcpy(opt->opt_monitor, "protection ", 11U);
+		for (size_t i = 0; i <= length; ++i)
+			opt->opt_monitor[11U + i] = protection[i] == ',' ? ' ' : protection[i];
+	}
+	if (memtest) {
+		if (opt->opt_monitor) {
+			DEBUG_ERROR("Only one of -M, -o and -k may be given\n");
+			exit(1);
+		}
+		if (opt->opt_flash_start == 0xffffffffU || opt->opt_flash_size == 0xffffffffU) {
+			DEBUG_ERROR("-k needs the region to work on given with -a and -S\n");
+			exit(1);
+		}
+		/* Likewise turn this into a `memtest` monitor command: memtest <op> <address> <length> [pattern] */
+		const char *const pattern = strchr(memtest, ',');
+		const int op_length = pattern ? (int)(pattern - memtest) : (int)strlen(memtest);
+		const size_t length = strlen(memtest) + 32U;
+		opt->opt_monitor = malloc(length);
+		if (!opt->opt_monitor) {
+			DEBUG_ERROR("malloc: failed in %s\n", __func__);
+			exit(1);
+		}
+		snprintf(opt->opt_monitor, length, "memtest %.*s 0x%08" PRIx32 " 0x%zx %s", op_length, memtest,
+			opt->opt_flash_start, opt->opt_flash_size, pattern ? pattern + 1U : "");
+	}
 	if (optind && argv[optind]) {
 		if (opt->opt_mode == BMP_MODE_DEBUG)
 			opt->opt_mode = BMP_MODE_FLASH_WRITE;
@@ -418,6 +507,11 @@ static void display_target(size_t idx, target_s *target, void *context)
 			core_name ? core_name : "");
 }
 
+void cl_display_targets(void)
+{
+	target_foreach(display_target, NULL);
+}
+
 bool scan_for_targets(const bmda_cli_options_s *const opt)
 {
 	if (opt->opt_scanmode == BMP_SCAN_JTAG)
@@ -542,8 +636,9 @@ int cl_execute(bmda_cli_options_s *opt)
 			goto target_detach;
 		}
 	} else if (opt->opt_mode == BMP_MODE_FLASH_READ) {
-		/* Open as binary */
-		read_file = open(opt->opt_flash_file, O_TRUNC | O_CREAT | O_RDWR | O_BINARY, S_IRUSR | S_IWUSR);
+		/* Open as binary, keeping any existing contents if we're to resume a previous read */
+		read_file = open(opt->opt_flash_file, (opt->opt_resume ? 0 : O_TRUNC) | O_CREAT | O_RDWR | O_BINARY,
+			S_IRUSR | S_IWUSR);
 		if (read_file == -1) {
 			DEBUG_ERROR("Error opening flashfile %s for read: %s\n", opt->opt_flash_file, strerror(errno));
 			res = -1;
@@ -592,19 +687,45 @@ int cl_execute(bmda_cli_options_s *opt)
 			goto free_map;
 		}
 	}
-	if (opt->opt_mode == BMP_MODE_FLASH_READ || opt->opt_mode == BMP_MODE_FLASH_VERIFY ||
-		opt->opt_mode == BMP_MODE_FLASH_WRITE_VERIFY) {
+	if (opt->opt_mode == BMP_MODE_FLASH_READ) {
+		DEBUG_INFO("Reading flash from 0x%08" PRIx32 " for %zu bytes to %s\n", opt->opt_flash_start,
+			opt->opt_flash_size, opt->opt_flash_file);
+		mem_dump_result_s dump = {0};
+		const uint32_t start_time = platform_time_ms();
+		if (!mem_dump(target, read_file, opt->opt_flash_start, opt->opt_flash_size, opt->opt_resume, &dump)) {
+			DEBUG_ERROR("Read to %s failed\n", opt->opt_flash_file);
+			res = -1;
+			goto free_map;
+		}
+		const uint32_t end_time = platform_time_ms();
+		const size_t bytes_read = dump.bytes_done - dump.resumed_from;
+		if (dump.bytes_sparse)
+			DEBUG_INFO("Skipped %zu unreadable bytes not in the target memory map\n", dump.bytes_sparse);
+		if (dump.read_failed) {
+			DEBUG_ERROR("Read stopped after %zu bytes, use --resume to continue it\n", dump.bytes_done);
+			res = -1;
+			goto free_map;
+		}
+		DEBUG_WARN("Read succeeded for %zu bytes, %8.3fkiB/s, CRC32 0x%08" PRIx32 "\n", bytes_read,
+			(double)bytes_read / (end_time - start_time), dump.crc);
+	}
+	if (opt->opt_mode == BMP_MODE_FLASH_VERIFY || opt->opt_mode == BMP_MODE_FLASH_WRITE_VERIFY) {
 #define WORKSIZE 0x1000U
 		uint8_t data[WORKSIZE];
-		if (opt->opt_mode == BMP_MODE_FLASH_READ)
-			DEBUG_INFO("Reading flash from 0x%08" PRIx32 " for %zu bytes to %s\n", opt->opt_flash_start,
-				opt->opt_flash_size, opt->opt_flash_file);
 		const uint32_t flash_src = opt->opt_flash_start;
-		const size_t size = opt->opt_mode == BMP_MODE_FLASH_READ ? opt->opt_flash_size : map.size;
+		const size_t size = map.size;
 		size_t bytes_read = 0;
 		uint8_t *flash = (uint8_t *)map.data;
 		const uint32_t start_time = platform_time_ms();
-		for (size_t offset = 0; offset < size; offset += WORKSIZE) {
+		/* If the target can checksum the range itself, only fall back to comparing it byte by byte on a mismatch */
+		uint32_t target_crc = 0;
+		if (target->crc32 && target->crc32(target, &target_crc, flash_src, size) &&
+			target_crc == crc32_update(0xffffffffU, flash, size))
+			bytes_read = size;
+		else if (target->crc32_ieee && target->crc32_ieee(target, &target_crc, flash_src, size) &&
+			target_crc == crc32_ieee_update(0U, flash, size))
+			bytes_read = size;
+		for (size_t offset = bytes_read; offset < size; offset += WORKSIZE) {
 			const size_t worksize = MIN(size - offset, WORKSIZE);
 			int n_read = target_mem_read(target, data, flash_src + offset, worksize);
 			if (n_read) {
@@ -615,31 +736,14 @@ int cl_execute(bmda_cli_options_s *opt)
 				break;
 			}
 			bytes_read += worksize;
-			if (opt->opt_mode == BMP_MODE_FLASH_VERIFY || opt->opt_mode == BMP_MODE_FLASH_WRITE_VERIFY) {
-				if (memcmp(data, flash + offset, worksize) != 0) {
-					DEBUG_ERROR("Verify failed at flash region 0x%08" PRIx32 "\n", flash_src);
-					res = -1;
-					goto free_map;
-				}
-			} else if (read_file != -1) {
-				const ssize_t written = write(read_file, data, worksize);
-				if (written < 0) {
-					const int error = errno;
-					DEBUG_ERROR("Write to %s failed (%d): %s\n", opt->opt_flash_file, error, strerror(error));
-					res = -1;
-					goto free_map;
-				}
-				if ((size_t)written < worksize) {
-					DEBUG_ERROR("Read failed at flash region 0x%08" PRIx32 "\n", flash_src);
-					res = -1;
-					goto free_map;
-				}
+			if (memcmp(data, flash + offset, worksize) != 0) {
+				DEBUG_ERROR("Verify failed at flash region 0x%08" PRIx32 "\n", flash_src);
+				res = -1;
+				goto free_map;
 			}
 		}
 		const uint32_t end_time = platform_time_ms();
-		if (read_file != -1)
-			close(read_file);
-		DEBUG_WARN("Read/Verify succeeded for %zu bytes, %8.3fkiB/s\n", bytes_read,
+		DEBUG_WARN("Verify succeeded for %zu bytes, %8.3fkiB/s\n", bytes_read,
 			(double)bytes_read / (end_time - start_time));
 		if (opt->opt_mode == BMP_MODE_FLASH_WRITE_VERIFY)
 			target_reset(target);
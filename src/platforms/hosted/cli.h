@@ -55,6 +55,10 @@ typedef struct bmda_cli_options {
 	bool external_resistor_swd;
 	bool fast_poll;
 	bool opt_no_hl;
+	bool opt_resume;
+	bool opt_max_swj_frequency_set;
+	bool opt_daemon;
+	uint16_t opt_daemon_port;
 	char *opt_flash_file;
 	char *opt_device;
 	char *opt_serial;
@@ -71,6 +75,8 @@ typedef struct bmda_cli_options {
 
 void cl_init(bmda_cli_options_s *opt, int argc, char **argv);
 int cl_execute(bmda_cli_options_s *opt);
+bool scan_for_targets(const bmda_cli_options_s *opt);
+void cl_display_targets(void);
 bool serial_open(const bmda_cli_options_s *opt, const char *serial);
 void serial_close(void);
 
@@ -486,23 +486,18 @@ bool dap_run_cmd(const void *const request_data, const size_t request_length, vo
 	return (size_t)result >= response_length;
 }
 
-static void dap_mem_read(adiv5_access_port_s *ap, void *dest, uint32_t src, size_t len)
+/*
+ * Move a block using DAP_TransferBlock reads. In packed mode each DRW access moves a whole
+ * word's worth of `align` sized elements, so the block must be word aligned.
+ */
+static bool dap_mem_read_block(adiv5_access_port_s *const ap, uint8_t *const data, const uint32_t src, const size_t len,
+	const align_e align, const bool packed)
 {
-	if (len == 0)
-		return;
-	const align_e align = MIN_ALIGN(src, len);
-	DEBUG_WIRE("dap_mem_read @ %" PRIx32 " len %zu, align %d\n", src, len, align);
-	/* If the read can be done in a single transaction, use the dap_read_single() fast-path */
-	if ((1U << align) == len) {
-		dap_read_single(ap, dest, src, align);
-		return;
-	}
-	/* Otherwise proceed blockwise */
+	const align_e step = packed ? ALIGN_32BIT : align;
 	const size_t blocks_per_transfer = dap_max_transfer_data(DAP_CMD_BLOCK_READ_HDR_LEN) >> 2U;
-	uint8_t *const data = (uint8_t *)dest;
 	for (size_t offset = 0; offset < len;) {
 		/* Setup AP_TAR every loop as failing to do so results in it wrapping */
-		dap_ap_mem_access_setup(ap, src + offset, align);
+		dap_ap_mem_access_setup(ap, src + offset, align, packed);
 		/*
 		 * src can start out unaligned to a 1024 byte chunk size,
 		 * so we have to calculate how much is left of the chunk.
@@ -510,36 +505,55 @@ static void dap_mem_read(adiv5_access_port_s *ap, void *dest, uint32_t src, size
 		 * has requested we fill.
 		 */
 		const size_t chunk_remaining = MIN(1024 - ((src + offset) & 0x3ffU), len - offset);
-		const size_t blocks = chunk_remaining >> align;
+		const size_t blocks = chunk_remaining >> step;
 		for (size_t i = 0; i < blocks; i += blocks_per_transfer) {
 			/* blocks - i gives how many blocks are left to transfer in this 1024 byte chunk */
-			const size_t transfer_length = MIN(blocks - i, blocks_per_transfer) << align;
-			if (!dap_read_block(ap, data + offset, src + offset, transfer_length, align)) {
+			const size_t transfer_length = MIN(blocks - i, blocks_per_transfer) << step;
+			if (!dap_read_block(ap, data + offset, src + offset, transfer_length, step)) {
 				DEBUG_WIRE("mem_read failed: %u\n", ap->dp->fault);
-				return;
+				return false;
 			}
 			offset += transfer_length;
 		}
 	}
-	DEBUG_WIRE("dap_mem_read transferred %zu blocks\n", len >> align);
+	return true;
 }
 
-static void dap_mem_write(adiv5_access_port_s *ap, uint32_t dest, const void *src, size_t len, align_e align)
+static void dap_mem_read(adiv5_access_port_s *ap, void *dest, uint32_t src, size_t len)
 {
 	if (len == 0)
 		return;
-	DEBUG_WIRE("memwrite @ %" PRIx32 " len %zu, align %d\n", dest, len, align);
-	/* If the write can be done in a single transaction, use the dap_write_single() fast-path */
+	const align_e align = MIN_ALIGN(src, len);
+	DEBUG_WIRE("dap_mem_read @ %" PRIx32 " len %zu, align %d\n", src, len, align);
+	/* If the read can be done in a single transaction, use the dap_read_single() fast-path */
 	if ((1U << align) == len) {
-		dap_write_single(ap, dest, src, align);
+		dap_read_single(ap, dest, src, align);
 		return;
 	}
-	/* Otherwise proceed blockwise */
+	/* Otherwise proceed blockwise, moving the word aligned middle of narrow accesses with packed transfers if we can */
+	uint8_t *const data = (uint8_t *)dest;
+	size_t head = 0U;
+	const size_t body = adiv5_packed_split(ap, src, len, align, &head);
+	if (body) {
+		const size_t tail = len - head - body;
+		if ((head && !dap_mem_read_block(ap, data, src, head, align, false)) ||
+			!dap_mem_read_block(ap, data + head, src + head, body, align, true) ||
+			(tail && !dap_mem_read_block(ap, data + head + body, src + head + body, tail, align, false)))
+			return;
+	} else if (!dap_mem_read_block(ap, data, src, len, align, false))
+		return;
+	DEBUG_WIRE("dap_mem_read transferred %zu blocks\n", len >> align);
+}
+
+/* Move a block using DAP_TransferBlock writes, see dap_mem_read_block() for what packed means */
+static bool dap_mem_write_block(adiv5_access_port_s *const ap, const uint32_t dest, const uint8_t *const data,
+	const size_t len, const align_e align, const bool packed)
+{
+	const align_e step = packed ? ALIGN_32BIT : align;
 	const size_t blocks_per_transfer = dap_max_transfer_data(DAP_CMD_BLOCK_WRITE_HDR_LEN) >> 2U;
-	const uint8_t *const data = (const uint8_t *)src;
 	for (size_t offset = 0; offset < len;) {
 		/* Setup AP_TAR every loop as failing to do so results in it wrapping */
-		dap_ap_mem_access_setup(ap, dest + offset, align);
+		dap_ap_mem_access_setup(ap, dest + offset, align, packed);
 		/*
 		 * dest can start out unaligned to a 1024 byte chunk size,
 		 * so we have to calculate how much is left of the chunk.
@@ -547,17 +561,42 @@ static void dap_mem_write(adiv5_access_port_s *ap, uint32_t dest, const void *sr
 		 * has requested we fill.
 		 */
 		const size_t chunk_remaining = MIN(1024 - ((dest + offset) & 0x3ffU), len - offset);
-		const size_t blocks = chunk_remaining >> align;
+		const size_t blocks = chunk_remaining >> step;
 		for (size_t i = 0; i < blocks; i += blocks_per_transfer) {
 			/* blocks - i gives how many blocks are left to transfer in this 1024 byte chunk */
-			const size_t transfer_length = MIN(blocks - i, blocks_per_transfer) << align;
-			if (!dap_write_block(ap, dest + offset, data + offset, transfer_length, align)) {
+			const size_t transfer_length = MIN(blocks - i, blocks_per_transfer) << step;
+			if (!dap_write_block(ap, dest + offset, data + offset, transfer_length, step)) {
 				DEBUG_WIRE("mem_write failed: %u\n", ap->dp->fault);
-				return;
+				return false;
 			}
 			offset += transfer_length;
 		}
 	}
+	return true;
+}
+
+static void dap_mem_write(adiv5_access_port_s *ap, uint32_t dest, const void *src, size_t len, align_e align)
+{
+	if (len == 0)
+		return;
+	DEBUG_WIRE("memwrite @ %" PRIx32 " len %zu, align %d\n", dest, len, align);
+	/* If the write can be done in a single transaction, use the dap_write_single() fast-path */
+	if ((1U << align) == len) {
+		dap_write_single(ap, dest, src, align);
+		return;
+	}
+	/* Otherwise proceed blockwise, moving the word aligned middle of narrow accesses with packed transfers if we can */
+	const uint8_t *const data = (const uint8_t *)src;
+	size_t head = 0U;
+	const size_t body = adiv5_packed_split(ap, dest, len, align, &head);
+	if (body) {
+		const size_t tail = len - head - body;
+		if ((head && !dap_mem_write_block(ap, dest, data, head, align, false)) ||
+			!dap_mem_write_block(ap, dest + head, data + head, body, align, true) ||
+			(tail && !dap_mem_write_block(ap, dest + head + body, data + head + body, tail, align, false)))
+			return;
+	} else if (!dap_mem_write_block(ap, dest, data, len, align, false))
+		return;
 	DEBUG_WIRE("dap_mem_write_sized transferred %zu blocks\n", len >> align);
 
 	/* Make sure this write is complete by doing a dummy read */
@@ -332,9 +332,9 @@ void dap_reset_link(adiv5_debug_port_s *const target_dp)
 }
 
 static void mem_access_setup(const adiv5_access_port_s *const target_ap,
-	dap_transfer_request_s *const transfer_requests, const uint32_t addr, const align_e align)
+	dap_transfer_request_s *const transfer_requests, const uint32_t addr, const align_e align, const bool packed)
 {
-	uint32_t csw = target_ap->csw | ADIV5_AP_CSW_ADDRINC_SINGLE;
+	uint32_t csw = target_ap->csw | (packed ? ADIV5_AP_CSW_ADDRINC_PACKED : ADIV5_AP_CSW_ADDRINC_SINGLE);
 	switch (align) {
 	case ALIGN_8BIT:
 		csw |= ADIV5_AP_CSW_SIZE_BYTE;
@@ -358,11 +358,12 @@ static void mem_access_setup(const adiv5_access_port_s *const target_ap,
 	transfer_requests[2].data = addr;
 }
 
-void dap_ap_mem_access_setup(adiv5_access_port_s *const target_ap, const uint32_t addr, const align_e align)
+void dap_ap_mem_access_setup(
+	adiv5_access_port_s *const target_ap, const uint32_t addr, const align_e align, const bool packed)
 {
 	/* Start by setting up the transfer and attempting it */
 	dap_transfer_request_s requests[3];
-	mem_access_setup(target_ap, requests, addr, align);
+	mem_access_setup(target_ap, requests, addr, align, packed);
 	adiv5_debug_port_s *const target_dp = target_ap->dp;
 	const bool result = perform_dap_transfer_recoverable(target_dp, requests, 3U, NULL, 0U);
 	/* If it didn't go well, say something and abort */
@@ -411,7 +412,7 @@ void dap_ap_write(adiv5_access_port_s *const target_ap, const uint16_t addr, con
 void dap_read_single(adiv5_access_port_s *const target_ap, void *const dest, const uint32_t src, const align_e align)
 {
 	dap_transfer_request_s requests[4];
-	mem_access_setup(target_ap, requests, src, align);
+	mem_access_setup(target_ap, requests, src, align, false);
 	requests[3].request = SWD_AP_DRW | DAP_TRANSFER_RnW;
 	uint32_t result;
 	adiv5_debug_port_s *target_dp = target_ap->dp;
@@ -428,7 +429,7 @@ void dap_write_single(
 	adiv5_access_port_s *const target_ap, const uint32_t dest, const void *const src, const align_e align)
 {
 	dap_transfer_request_s requests[4];
-	mem_access_setup(target_ap, requests, dest, align);
+	mem_access_setup(target_ap, requests, dest, align, false);
 	requests[3].request = SWD_AP_DRW;
 	/* Pack data into correct data lane */
 	adiv5_pack_data(dest, src, &requests[3].data, align);
@@ -84,7 +84,7 @@ void dap_write_reg(adiv5_debug_port_s *target_dp, uint8_t reg, uint32_t data);
 void dap_reset_link(adiv5_debug_port_s *target_dp);
 bool dap_read_block(adiv5_access_port_s *target_ap, void *dest, uint32_t src, size_t len, align_e align);
 bool dap_write_block(adiv5_access_port_s *target_ap, uint32_t dest, const void *src, size_t len, align_e align);
-void dap_ap_mem_access_setup(adiv5_access_port_s *target_ap, uint32_t addr, align_e align);
+void dap_ap_mem_access_setup(adiv5_access_port_s *target_ap, uint32_t addr, align_e align, bool packed);
 uint32_t dap_ap_read(adiv5_access_port_s *target_ap, uint16_t addr);
 void dap_ap_write(adiv5_access_port_s *target_ap, uint16_t addr, uint32_t value);
 void dap_read_single(adiv5_access_port_s *target_ap, void *dest, uint32_t src, align_e align);
@@ -36,6 +36,7 @@
 #include "dap_command.h"
 #include "exception.h"
 #include "buffer_utils.h"
+#include "freq_profile.h"
 
 #define DAP_TRANSFER_APnDP       (1U << 0U)
 #define DAP_TRANSFER_RnW         (1U << 1U)
@@ -75,10 +76,12 @@ static void dap_dispatch_status(adiv5_debug_port_s *const dp, const dap_transfer
 		break;
 	case DAP_TRANSFER_NO_RESPONSE:
 		DEBUG_ERROR("Access resulted in no response\n");
+		freq_profile_note_fault();
 		dp->fault = status;
 		break;
 	default:
 		DEBUG_ERROR("Access has invalid ack %x\n", status);
+		freq_profile_note_fault();
 		raise_exception(EXCEPTION_ERROR, "Invalid ACK");
 		break;
 	}
@@ -165,9 +168,11 @@ bool perform_dap_transfer_block_read(
 			blocks[i] = read_le4(response.data[i], 0);
 		return true;
 	}
-	if (response.status != DAP_TRANSFER_OK)
+	if (response.status != DAP_TRANSFER_OK) {
 		target_dp->fault = response.status;
-	else
+		if (response.status != DAP_TRANSFER_WAIT && response.status != DAP_TRANSFER_FAULT)
+			freq_profile_note_fault();
+	} else
 		target_dp->fault = 0;
 
 	DEBUG_PROBE("-> transfer failed with %u after processing %u blocks\n", response.status, blocks_read);
@@ -200,9 +205,11 @@ bool perform_dap_transfer_block_write(
 	const uint16_t blocks_written = read_le2(response.count, 0);
 	if (blocks_written == block_count && response.status == DAP_TRANSFER_OK)
 		return true;
-	if (response.status != DAP_TRANSFER_OK)
+	if (response.status != DAP_TRANSFER_OK) {
 		target_dp->fault = response.status;
-	else
+		if (response.status != DAP_TRANSFER_WAIT && response.status != DAP_TRANSFER_FAULT)
+			freq_profile_note_fault();
+	} else
 		target_dp->fault = 0;
 
 	DEBUG_PROBE("-> transfer failed with %u after processing %u blocks\n", response.status, blocks_written);
@@ -0,0 +1,362 @@
+/*
+ * This file is part of the Black Magic Debug project.
+ *
+ * Copyright (C) 2023 1BitSquared <info@1bitsquared.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * This file implements interface frequency calibration and per-target frequency profiles.
+ *
+ * Calibration binary searches for the highest frequency at which writing and reading back a set of
+ * patterns to the target's RAM works reliably. The result, less a safety margin, is stored in a small
+ * profile file keyed on the probe serial number and the target's designer and part ID, and re-applied
+ * whenever that target is attached to through that probe. Should faults start to pile up while running
+ * on a profiled frequency, the frequency is stepped down and the profile updated to match.
+ *
+ * Only SWD/JTAG protocol faults (no or invalid ACKs, and parity errors) count towards a step down - other
+ * target errors say nothing about the link. If the user gives a frequency with -f, stored profiles are not
+ * applied and calibration will not search above that frequency.
+ */
+
+#include "general.h"
+#include "exception.h"
+#include "target_internal.h"
+#include "bmp_hosted.h"
+#include "freq_profile.h"
+
+/* The lowest and highest frequency calibration will consider */
+#define FREQ_CALIBRATE_MIN 100000U
+#define FREQ_CALIBRATE_MAX 50000000U
+/* Stop the search once the window is within this many Hz */
+#define FREQ_CALIBRATE_RESOLUTION 50000U
+/* How many bytes of RAM to run the pattern test over, and how many times to run it at each frequency */
+#define FREQ_CALIBRATE_WINDOW 1024U
+#define FREQ_CALIBRATE_ROUNDS 4U
+/* The safety margin to apply to the calibrated frequency, in percent of that frequency */
+#define FREQ_CALIBRATE_MARGIN 25U
+
+/* How many faults in what period of time trigger a step down, and by how much (in percent) */
+#define FREQ_FAULT_THRESHOLD  16U
+#define FREQ_FAULT_WINDOW_MS  5000U
+#define FREQ_FAULT_STEP_DOWN  25U
+
+#define FREQ_PROFILE_FILE     "bmda-frequency-profiles"
+#define FREQ_PROFILE_LINE_LEN 128U
+
+static bool profile_active = false;
+static bool calibrating = false;
+static unsigned int profile_designer;
+static unsigned int profile_part_id;
+static uint32_t fault_window_start;
+static uint32_t fault_count;
+static uint32_t user_frequency = 0;
+
+static char *freq_profile_path(void)
+{
+#if defined(_WIN32) || defined(__CYGWIN__)
+	const char *const base = getenv("APPDATA");
+	const char *const suffix = "";
+#else
+	const char *base = getenv("XDG_CONFIG_HOME");
+	const char *suffix = "";
+	if (!base) {
+		base = getenv("HOME");
+		suffix = "/.config";
+	}
+#endif
+	if (!base)
+		return NULL;
+	char *path = NULL;
+	if (asprintf(&path, "%s%s/%s", base, suffix, FREQ_PROFILE_FILE) < 0)
+		return NULL;
+	return path;
+}
+
+static const char *freq_profile_probe_serial(void)
+{
+	return bmda_probe_info.serial[0] ? bmda_probe_info.serial : "-";
+}
+
+/* Look up the stored frequency for the given target on the current probe, returning 0 if there is none */
+static uint32_t freq_profile_lookup(const unsigned int designer, const unsigned int part_id)
+{
+	char *const path = freq_profile_path();
+	if (!path)
+		return 0;
+	FILE *const file = fopen(path, "r");
+	free(path);
+	if (!file)
+		return 0;
+
+	uint32_t frequency = 0;
+	char line[FREQ_PROFILE_LINE_LEN];
+	while (fgets(line, sizeof(line), file)) {
+		char serial[65];
+		unsigned int line_designer = 0;
+		unsigned int line_part_id = 0;
+		uint32_t line_frequency = 0;
+		if (sscanf(line, "%64s %x:%x %" SCNu32, serial, &line_designer, &line_part_id, &line_frequency) != 4)
+			continue;
+		if (!strcmp(serial, freq_profile_probe_serial()) && line_designer == designer && line_part_id == part_id) {
+			frequency = line_frequency;
+			break;
+		}
+	}
+	fclose(file);
+	return frequency;
+}
+
+/* Store the frequency for the given target on the current probe, replacing any existing entry */
+static bool freq_profile_store(const unsigned int designer, const unsigned int part_id, const uint32_t frequency)
+{
+	char *const path = freq_profile_path();
+	if (!path)
+		return false;
+
+	/* Read in all the other entries so we can write them back out again */
+	char *contents = NULL;
+	size_t contents_len = 0;
+	FILE *file = fopen(path, "r");
+	if (file) {
+		char line[FREQ_PROFILE_LINE_LEN];
+		char key[FREQ_PROFILE_LINE_LEN];
+		const int key_len = snprintf(key, sizeof(key), "%s %x:%x ", freq_profile_probe_serial(), designer, part_id);
+		while (fgets(line, sizeof(line), file)) {
+			if (!strncmp(line, key, key_len))
+				continue;
+			const size_t line_len = strlen(line);
+			char *const new_contents = realloc(contents, contents_len + line_len);
+			if (!new_contents)
+				break;
+			contents = new_contents;
+			memcpy(contents + contents_len, line, line_len);
+			contents_len += line_len;
+		}
+		fclose(file);
+	}
+
+	file = fopen(path, "w");
+	if (!file) {
+		DEBUG_ERROR("Could not open frequency profile file %s for writing\n", path);
+		free(contents);
+		free(path);
+		return false;
+	}
+	if (contents_len)
+		fwrite(contents, 1, contents_len, file);
+	fprintf(file, "%s %x:%x %" PRIu32 "\n", freq_profile_probe_serial(), designer, part_id, frequency);
+	fclose(file);
+	free(contents);
+	free(path);
+	return true;
+}
+
+/* Write one pattern to the test window and read it back, treating any exception raised as a failure */
+static bool freq_calibrate_round(target_s *const target, const target_addr_t base, const uint32_t *const pattern,
+	uint32_t *const readback, const size_t length)
+{
+	volatile bool passed = false;
+	volatile exception_s error;
+	TRY_CATCH (error, EXCEPTION_ALL) {
+		passed = !target_mem_write(target, base, pattern, length) && !target_mem_read(target, readback, base, length) &&
+			memcmp(pattern, readback, length) == 0;
+	}
+	return !error.type && passed;
+}
+
+/* Write a set of patterns over the test window and read them back, returning whether they all matched */
+static bool freq_calibrate_pattern_test(target_s *const target, const target_addr_t base, const size_t length)
+{
+	uint32_t pattern[FREQ_CALIBRATE_WINDOW / 4U];
+	uint32_t readback[FREQ_CALIBRATE_WINDOW / 4U];
+	const size_t words = length / 4U;
+	for (size_t round = 0; round < FREQ_CALIBRATE_ROUNDS; ++round) {
+		/* Alternate between the classic toggling patterns, address-in-address, and a pseudo-random sequence */
+		uint32_t seed = 0x2545f491U + round;
+		for (size_t idx = 0; idx < words; ++idx) {
+			switch (round & 3U) {
+			case 0:
+				pattern[idx] = idx & 1U ? 0xaaaaaaaaU : 0x55555555U;
+				break;
+			case 1:
+				pattern[idx] = idx & 1U ? 0x55555555U : 0xaaaaaaaaU;
+				break;
+			case 2:
+				pattern[idx] = base + (idx * 4U);
+				break;
+			default:
+				seed ^= seed << 13U;
+				seed ^= seed >> 17U;
+				seed ^= seed << 5U;
+				pattern[idx] = seed;
+				break;
+			}
+		}
+		if (!freq_calibrate_round(target, base, pattern, readback, words * 4U))
+			return false;
+	}
+	return true;
+}
+
+static bool freq_calibrate_test(target_s *const target, const target_addr_t base, const size_t length,
+	const uint32_t frequency, uint32_t *const actual)
+{
+	platform_max_frequency_set(frequency);
+	*actual = platform_max_frequency_get();
+	const bool passed = freq_calibrate_pattern_test(target, base, length);
+	DEBUG_INFO("Calibration at %" PRIu32 "Hz: %s\n", *actual, passed ? "pass" : "fail");
+	if (!passed) {
+		/* Bring things back to a known state so the next test starts clean */
+		platform_max_frequency_set(FREQ_CALIBRATE_MIN);
+		target_check_error(target);
+	}
+	return passed;
+}
+
+bool freq_calibrate(target_s *const target)
+{
+	if (platform_max_frequency_get() == FREQ_FIXED) {
+		DEBUG_ERROR("This probe runs at a fixed frequency, nothing to calibrate\n");
+		return false;
+	}
+	/* Find the largest RAM region to run the test against */
+	const target_ram_s *ram = NULL;
+	for (const target_ram_s *region = target->ram; region; region = region->next) {
+		if (!ram || region->length > ram->length)
+			ram = region;
+	}
+	if (!ram || ram->length < 4U) {
+		DEBUG_ERROR("No RAM known for this target to calibrate against\n");
+		return false;
+	}
+	const target_addr_t base = ram->start;
+	const size_t length = MIN(ram->length, FREQ_CALIBRATE_WINDOW) & ~3U;
+
+	calibrating = true;
+	/* Save the contents of the test window at a known-good speed so it can be put back afterwards */
+	const uint32_t initial_frequency = platform_max_frequency_get();
+	uint8_t saved[FREQ_CALIBRATE_WINDOW];
+	platform_max_frequency_set(FREQ_CALIBRATE_MIN);
+	if (target_mem_read(target, saved, base, length)) {
+		DEBUG_ERROR("Failed to read RAM at 0x%08" PRIx32 " at the lowest frequency\n", base);
+		platform_max_frequency_set(initial_frequency);
+		calibrating = false;
+		return false;
+	}
+
+	uint32_t low = 0;
+	uint32_t actual = 0;
+	if (freq_calibrate_test(target, base, length, FREQ_CALIBRATE_MIN, &actual))
+		low = actual;
+	/* Never search above a frequency the user explicitly asked for */
+	uint32_t high = FREQ_CALIBRATE_MAX;
+	if (user_frequency)
+		high = MAX(MIN(user_frequency, high), (uint32_t)FREQ_CALIBRATE_MIN);
+	/* If the probe can't go as high as we'd like, don't bother searching above what it can do */
+	if (low && freq_calibrate_test(target, base, length, high, &actual)) {
+		low = actual;
+		high = actual;
+	}
+	while (low && high - low > FREQ_CALIBRATE_RESOLUTION) {
+		const uint32_t frequency = low + ((high - low) / 2U);
+		if (freq_calibrate_test(target, base, length, frequency, &actual) && actual > low)
+			low = actual;
+		else
+			high = frequency;
+	}
+
+	/* Put the RAM contents back at a speed we know works */
+	platform_max_frequency_set(FREQ_CALIBRATE_MIN);
+	const bool restored = !target_mem_write(target, base, saved, length);
+	calibrating = false;
+	if (!low) {
+		DEBUG_ERROR("Pattern test failed even at %" PRIu32 "Hz, not calibrating\n", (uint32_t)FREQ_CALIBRATE_MIN);
+		platform_max_frequency_set(initial_frequency);
+		return false;
+	}
+	if (!restored)
+		DEBUG_WARN("Failed to restore RAM contents at 0x%08" PRIx32 "\n", base);
+
+	const uint32_t frequency = MAX(low - ((low / 100U) * FREQ_CALIBRATE_MARGIN), (uint32_t)FREQ_CALIBRATE_MIN);
+	platform_max_frequency_set(frequency);
+	DEBUG_WARN("Calibrated maximum %" PRIu32 "Hz, using %" PRIu32 "Hz\n", low, platform_max_frequency_get());
+
+	profile_designer = target_designer(target);
+	profile_part_id = target_part_id(target);
+	profile_active = true;
+	fault_count = 0;
+	return freq_profile_store(profile_designer, profile_part_id, frequency);
+}
+
+void freq_profile_user_frequency(const uint32_t frequency)
+{
+	user_frequency = frequency;
+}
+
+void freq_profile_apply(target_s *const target)
+{
+	profile_active = false;
+	const unsigned int designer = target_designer(target);
+	const unsigned int part_id = target_part_id(target);
+	const uint32_t frequency = freq_profile_lookup(designer, part_id);
+	if (!frequency)
+		return;
+	if (user_frequency) {
+		DEBUG_INFO("Not applying frequency profile of %" PRIu32 "Hz, frequency was set explicitly\n", frequency);
+		return;
+	}
+	DEBUG_INFO("Applying frequency profile of %" PRIu32 "Hz for this target\n", frequency);
+	platform_max_frequency_set(frequency);
+	profile_designer = designer;
+	profile_part_id = part_id;
+	profile_active = true;
+	fault_count = 0;
+}
+
+void freq_profile_note_fault(void)
+{
+	if (!profile_active || calibrating)
+		return;
+	const uint32_t now = platform_time_ms();
+	if (now - fault_window_start > FREQ_FAULT_WINDOW_MS) {
+		fault_window_start = now;
+		fault_count = 0;
+	}
+	if (++fault_count < FREQ_FAULT_THRESHOLD)
+		return;
+	fault_count = 0;
+
+	const uint32_t current = platform_max_frequency_get();
+	if (current == FREQ_FIXED || current <= FREQ_CALIBRATE_MIN)
+		return;
+	const uint32_t frequency = MAX(current - ((current / 100U) * FREQ_FAULT_STEP_DOWN), (uint32_t)FREQ_CALIBRATE_MIN);
+	DEBUG_WARN("Too many faults at %" PRIu32 "Hz, stepping down to %" PRIu32 "Hz\n", current, frequency);
+	platform_max_frequency_set(frequency);
+	freq_profile_store(profile_designer, profile_part_id, frequency);
+}
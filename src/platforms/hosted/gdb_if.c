@@ -63,6 +63,7 @@ typedef int32_t socket_t;
 #include "gdb_if.h"
 #include "bmp_hosted.h"
 #include "command.h"
+#include "hex_utils.h"
 
 static const uint16_t default_port = 2000U;
 static const uint16_t max_port = default_port + 4U;
@@ -274,6 +275,7 @@ char gdb_if_getchar(void)
 				const int error = socket_error();
 				if (error == op_would_block) {
 					SET_IDLE_STATE(1);
+					bmda_daemon_poll();
 					platform_delay(100);
 				} else {
 					display_socket_error(error, gdb_if_serv, "accepting connection from socket");
@@ -285,6 +287,7 @@ char gdb_if_getchar(void)
 		DEBUG_INFO("Got connection\n");
 		socket_set_flags(gdb_if_serv, flags);
 		socket_set_flags(gdb_if_conn, socket_get_flags(gdb_if_conn) & ~O_NONBLOCK);
+		bmda_daemon_client_connected();
 	}
 
 	char value = '\0';
@@ -340,3 +343,147 @@ void gdb_if_putchar(char c, int flush)
 		gdb_buffer_used = 0;
 	}
 }
+
+/*
+ * The below implements the client side of the daemon mode: a minimal GDB remote protocol client
+ * that connects to a BMDA already running on this machine and has it run a monitor command.
+ */
+
+#define DAEMON_PACKET_LEN 1024U
+
+static bool daemon_send_packet(const socket_t sock, const char *const packet)
+{
+	const size_t length = strlen(packet);
+	if (length + 5U > DAEMON_PACKET_LEN)
+		return false;
+	char buffer[DAEMON_PACKET_LEN];
+	uint8_t csum = 0;
+	for (size_t idx = 0; idx < length; ++idx)
+		csum += (uint8_t)packet[idx];
+	const int buffer_len = snprintf(buffer, sizeof(buffer), "$%s#%02X", packet, csum);
+	if (send(sock, buffer, buffer_len, 0) != buffer_len)
+		return false;
+	/* Wait for the daemon to acknowledge the packet */
+	char ack = '\0';
+	return recv(sock, &ack, 1, 0) == 1 && ack == '+';
+}
+
+static ssize_t daemon_recv_packet(const socket_t sock, char *const packet, const size_t size)
+{
+	char value = '\0';
+	/* Skip forward to the start of the next packet */
+	while (value != '$') {
+		if (recv(sock, &value, 1, 0) != 1)
+			return -1;
+	}
+	size_t length = 0;
+	while (true) {
+		if (recv(sock, &value, 1, 0) != 1)
+			return -1;
+		if (value == '#')
+			break;
+		if (length + 1U < size)
+			packet[length++] = value;
+	}
+	packet[length] = '\0';
+	/* Consume the checksum and acknowledge the packet */
+	char csum[2];
+	if (recv(sock, csum, 2, MSG_WAITALL) != 2 || send(sock, "+", 1, 0) != 1)
+		return -1;
+	return (ssize_t)length;
+}
+
+/* Receive packets until we get one that is not console output, printing any output received */
+static ssize_t daemon_recv_response(const socket_t sock, char *const packet, const size_t size)
+{
+	while (true) {
+		const ssize_t length = daemon_recv_packet(sock, packet, size);
+		if (length < 0 || packet[0] != 'O' || length == 1 || !strcmp(packet, "OK"))
+			return length;
+		const size_t output_len = ((size_t)length - 1U) / 2U;
+		char output[DAEMON_PACKET_LEN / 2U + 1U];
+		unhexify(output, packet + 1U, output_len);
+		output[output_len] = '\0';
+		printf("%s", output);
+	}
+}
+
+static socket_t daemon_connect(const uint16_t port)
+{
+	addrinfo_s hints = {0};
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+	char service[6];
+	snprintf(service, sizeof(service), "%u", port);
+
+	addrinfo_s *results = NULL;
+	if (getaddrinfo("localhost", service, &hints, &results) || !results) {
+		DEBUG_ERROR("Failed to resolve the daemon's address\n");
+		return INVALID_SOCKET;
+	}
+	socket_t sock = INVALID_SOCKET;
+	for (const addrinfo_s *addr = results; addr; addr = addr->ai_next) {
+		sock = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+		if (sock == INVALID_SOCKET)
+			continue;
+		if (connect(sock, addr->ai_addr, addr->ai_addrlen) == 0)
+			break;
+		closesocket(sock);
+		sock = INVALID_SOCKET;
+	}
+	freeaddrinfo(results);
+	if (sock == INVALID_SOCKET)
+		DEBUG_ERROR("Could not connect to a daemon on port %u\n", port);
+	return sock;
+}
+
+int bmda_daemon_run_command(const uint16_t port, const uint32_t target_number, const char *const command)
+{
+#if defined(_WIN32) || defined(__CYGWIN__)
+	WSADATA wsa_data = {0};
+	if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != NO_ERROR)
+		return -1;
+#endif
+	const socket_t sock = daemon_connect(port);
+	if (sock == INVALID_SOCKET)
+		return -1;
+
+	int result = -1;
+	char packet[DAEMON_PACKET_LEN];
+	/* Attach to the requested target so target-specific commands are available */
+	snprintf(packet, sizeof(packet), "vAttach;%08" PRIx32, target_number);
+	if (!daemon_send_packet(sock, packet) || daemon_recv_response(sock, packet, sizeof(packet)) < 0)
+		goto out;
+	if (packet[0] == 'E') {
+		DEBUG_ERROR("Daemon could not attach to target %" PRIu32 "\n", target_number);
+		goto out;
+	}
+
+	/* Build and send the qRcmd packet for the command */
+	const size_t command_len = strlen(command);
+	if (command_len * 2U + 6U > sizeof(packet)) {
+		DEBUG_ERROR("Monitor command too long\n");
+		goto detach;
+	}
+	memcpy(packet, "qRcmd,", 6U);
+	hexify(packet + 6U, command, command_len);
+	if (!daemon_send_packet(sock, packet))
+		goto detach;
+	const ssize_t length = daemon_recv_response(sock, packet, sizeof(packet));
+	if (length < 0)
+		goto detach;
+	if (!strcmp(packet, "OK"))
+		result = 0;
+	else if (!length)
+		DEBUG_ERROR("Command \"%s\" not recognised by the daemon\n", command);
+	else
+		DEBUG_ERROR("Command \"%s\" failed\n", command);
+
+detach:
+	if (daemon_send_packet(sock, "D"))
+		daemon_recv_response(sock, packet, sizeof(packet));
+out:
+	closesocket(sock);
+	return result;
+}
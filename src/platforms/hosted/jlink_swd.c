@@ -35,6 +35,7 @@
 #include "jlink_protocol.h"
 #include "buffer_utils.h"
 #include "cli.h"
+#include "freq_profile.h"
 
 /*
  * The first byte in this defines 8 OUT bits to write the request out.
@@ -234,6 +235,7 @@ static uint32_t jlink_adiv5_raw_read(adiv5_debug_port_s *const dp)
 	if (parity) {
 		dp->fault = 1;
 		DEBUG_ERROR("SWD access resulted in parity error\n");
+		freq_profile_note_fault();
 		raise_exception(EXCEPTION_ERROR, "SWD parity error");
 	}
 	return response;
@@ -314,12 +316,14 @@ static uint32_t jlink_adiv5_raw_access(
 
 	if (ack == SWDP_ACK_NO_RESPONSE) {
 		DEBUG_ERROR("SWD access resulted in no response\n");
+		freq_profile_note_fault();
 		dp->fault = ack;
 		return 0;
 	}
 
 	if (ack != SWDP_ACK_OK) {
 		DEBUG_ERROR("SWD access has invalid ack %x\n", ack);
+		freq_profile_note_fault();
 		raise_exception(EXCEPTION_ERROR, "SWD invalid ACK");
 	}
 
@@ -0,0 +1,279 @@
+/*
+ * This file is part of the Black Magic Debug project.
+ *
+ * Copyright (C) 2023 1BitSquared <info@1bitsquared.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * This file implements the content-aware write path for large target memory writes.
+ *
+ * The data is compressed on the host into a simple token stream: runs of repeated words
+ * become fills, repeats of earlier data become back-references and everything else is
+ * passed through as literals. The stream is then expanded into place by a small routine
+ * run on the target (flashstub/mem_expand.s), so only the compressed form crosses the link.
+ */
+
+#include "general.h"
+#include "target_internal.h"
+#include "cortexm.h"
+#include "mem_codec.h"
+
+#define MEM_CODEC_LITERAL_MAX  128U
+#define MEM_CODEC_MATCH_MIN    3U
+#define MEM_CODEC_MATCH_MAX    66U
+#define MEM_CODEC_DISTANCE_MAX 65535U
+#define MEM_CODEC_FILL_MIN     32U           /* Shortest run of repeated words in bytes worth a fill */
+#define MEM_CODEC_FILL_MAX     (1U << 22U)   /* Most words a single fill token can cover */
+#define MEM_CODEC_HASH_BITS    16U
+#define MEM_CODEC_TOKEN_MAX    7U            /* Longest possible non-literal token (a fill) */
+
+/*
+ * Cost of running the expander over the link beyond the stream itself, in bytes. On top of this, the
+ * workspace gets saved and restored, so the stream must be well under a third of the data to be worth it.
+ */
+#define MEM_CODEC_RUN_OVERHEAD 512U
+
+static const uint16_t mem_expand_stub[] = {
+#include "flashstub/mem_expand.stub"
+};
+
+#define MEM_CODEC_STREAM_OFFSET ALIGN(sizeof(mem_expand_stub), 4U)
+
+typedef struct mem_codec_encoder {
+	uint8_t *out;
+	size_t out_len;
+	const uint8_t *literal;
+	size_t literal_len;
+} mem_codec_encoder_s;
+
+static inline uint32_t mem_codec_hash(const uint8_t *const data)
+{
+	const uint32_t value = data[0] | (data[1] << 8U) | (data[2] << 16U);
+	return (value * 2654435761U) >> (32U - MEM_CODEC_HASH_BITS);
+}
+
+static void mem_codec_flush_literals(mem_codec_encoder_s *const encoder)
+{
+	while (encoder->literal_len) {
+		const size_t amount = MIN(encoder->literal_len, MEM_CODEC_LITERAL_MAX);
+		encoder->out[encoder->out_len++] = amount - 1U;
+		memcpy(encoder->out + encoder->out_len, encoder->literal, amount);
+		encoder->out_len += amount;
+		encoder->literal += amount;
+		encoder->literal_len -= amount;
+	}
+}
+
+/* Count how many copies of the word at pos follow on from each other */
+static size_t mem_codec_word_run(const uint8_t *const src, const size_t pos, const size_t len)
+{
+	size_t words = 1U;
+	while (words < MEM_CODEC_FILL_MAX && pos + (words + 1U) * 4U <= len &&
+		memcmp(src + pos + words * 4U, src + pos, 4U) == 0)
+		++words;
+	return words;
+}
+
+/*
+ * Most a single step of the compressor can write past the budget: a pending literal run one short of
+ * full (and its header) flushed ahead of the longest other token
+ */
+#define MEM_CODEC_OUT_SLACK (MEM_CODEC_LITERAL_MAX + MEM_CODEC_TOKEN_MAX)
+
+bool mem_codec_enabled = false;
+
+/*
+ * Compress len bytes of src, destined for dest, into out. Gives up and returns 0 as soon as the
+ * stream (counting literals not yet flushed) grows past budget bytes, out must have room for
+ * budget + MEM_CODEC_OUT_SLACK bytes.
+ */
+static size_t mem_codec_compress(const target_addr_t dest, const uint8_t *const src, const size_t len,
+	uint8_t *const out, const size_t budget)
+{
+	uint32_t *const table = calloc(1U << MEM_CODEC_HASH_BITS, sizeof(uint32_t));
+	if (!table) { /* calloc failed: heap exhaustion */
+		DEBUG_ERROR("calloc: failed in %s\n", __func__);
+		return 0U;
+	}
+
+	mem_codec_encoder_s encoder = {.out = out};
+	size_t pos = 0U;
+	while (pos < len && encoder.out_len + encoder.literal_len <= budget) {
+		/* Runs of repeated words that land word aligned on the target become fills */
+		if (!((dest + pos) & 3U) && len - pos >= MEM_CODEC_FILL_MIN) {
+			const size_t words = mem_codec_word_run(src, pos, len);
+			if (words * 4U >= MEM_CODEC_FILL_MIN) {
+				mem_codec_flush_literals(&encoder);
+				const size_t count = words - 1U;
+				encoder.out[encoder.out_len++] = 0xc0U | ((count >> 16U) & 0x3fU);
+				encoder.out[encoder.out_len++] = count & 0xffU;
+				encoder.out[encoder.out_len++] = (count >> 8U) & 0xffU;
+				memcpy(encoder.out + encoder.out_len, src + pos, 4U);
+				encoder.out_len += 4U;
+				pos += words * 4U;
+				continue;
+			}
+		}
+
+		/* Otherwise look for an earlier copy of what comes next */
+		size_t match_len = 0U;
+		size_t distance = 0U;
+		if (len - pos >= MEM_CODEC_MATCH_MIN) {
+			const uint32_t hash = mem_codec_hash(src + pos);
+			/* Table entries are stored offset by one so 0 means empty */
+			const size_t candidate = table[hash];
+			table[hash] = pos + 1U;
+			distance = pos + 1U - candidate;
+			if (candidate && distance <= MEM_CODEC_DISTANCE_MAX) {
+				const uint8_t *const earlier = src + candidate - 1U;
+				while (match_len < MEM_CODEC_MATCH_MAX && pos + match_len < len &&
+					earlier[match_len] == src[pos + match_len])
+					++match_len;
+			}
+		}
+
+		if (match_len >= MEM_CODEC_MATCH_MIN) {
+			mem_codec_flush_literals(&encoder);
+			encoder.out[encoder.out_len++] = 0x80U | (match_len - MEM_CODEC_MATCH_MIN);
+			encoder.out[encoder.out_len++] = distance & 0xffU;
+			encoder.out[encoder.out_len++] = (distance >> 8U) & 0xffU;
+			/* Make the data covered by the match available for later matches too */
+			for (size_t offset = 1U; offset < match_len && pos + offset + MEM_CODEC_MATCH_MIN <= len; ++offset)
+				table[mem_codec_hash(src + pos + offset)] = pos + offset + 1U;
+			pos += match_len;
+		} else {
+			if (!encoder.literal_len)
+				encoder.literal = src + pos;
+			if (++encoder.literal_len == MEM_CODEC_LITERAL_MAX)
+				mem_codec_flush_literals(&encoder);
+			++pos;
+		}
+	}
+	mem_codec_flush_literals(&encoder);
+	free(table);
+	return encoder.out_len <= budget ? encoder.out_len : 0U;
+}
+
+static bool mem_codec_overlaps(const target_addr_t a, const size_t a_len, const target_addr_t b, const size_t b_len)
+{
+	return a < b + b_len && b < a + a_len;
+}
+
+/* Check the whole destination lies in one RAM region, the only place the expander can write to */
+static bool mem_codec_dest_in_ram(target_s *const target, const target_addr_t dest, const size_t len)
+{
+	for (const target_ram_s *ram = target->ram; ram; ram = ram->next) {
+		if (dest >= ram->start && dest + len <= ram->start + ram->length)
+			return true;
+	}
+	return false;
+}
+
+/* Find somewhere in RAM outside the destination to run the expander from */
+static bool mem_codec_find_workspace(target_s *const target, const target_addr_t dest, const size_t len,
+	const size_t workspace_size, target_addr_t *const workspace)
+{
+	for (const target_ram_s *ram = target->ram; ram; ram = ram->next) {
+		if (ram->length < workspace_size)
+			continue;
+		*workspace = ram->start;
+		if (!mem_codec_overlaps(*workspace, workspace_size, dest, len))
+			return true;
+		*workspace = (ram->start + ram->length - workspace_size) & ~3U;
+		if (!mem_codec_overlaps(*workspace, workspace_size, dest, len))
+			return true;
+	}
+	return false;
+}
+
+/* Upload and run the expander, putting back the workspace RAM and core registers afterwards */
+static bool mem_codec_expand(target_s *const target, const target_addr_t workspace, const target_addr_t dest,
+	const uint8_t *const stream, const size_t stream_len)
+{
+	const size_t workspace_size = MEM_CODEC_STREAM_OFFSET + stream_len;
+	uint8_t *const saved_ram = malloc(workspace_size);
+	if (!saved_ram) { /* malloc failed: heap exhaustion */
+		DEBUG_ERROR("malloc: failed in %s\n", __func__);
+		return false;
+	}
+	uint32_t saved_regs[CORTEXM_GENERAL_REG_COUNT + CORTEX_FLOAT_REG_COUNT];
+	target_regs_read(target, saved_regs);
+	target->mem_read(target, saved_ram, workspace, workspace_size);
+	if (target_check_error(target)) {
+		free(saved_ram);
+		return false;
+	}
+
+	/* Write directly with the target's routine so we don't come back round through target_mem_write() */
+	const target_addr_t stream_addr = workspace + MEM_CODEC_STREAM_OFFSET;
+	target->mem_write(target, workspace, mem_expand_stub, sizeof(mem_expand_stub));
+	target->mem_write(target, stream_addr, stream, stream_len);
+	const bool result = !target_check_error(target) &&
+		cortexm_run_stub(target, workspace, stream_addr, stream_addr + stream_len, dest, 0U);
+
+	target->mem_write(target, workspace, saved_ram, workspace_size);
+	target_regs_write(target, saved_regs);
+	free(saved_ram);
+	return result && !target_check_error(target);
+}
+
+bool mem_codec_write(target_s *const target, const target_addr_t dest, const void *const src, const size_t len)
+{
+	if (!mem_codec_enabled || len < MEM_CODEC_MIN_LENGTH || !target->mem_write ||
+		!cortexm_can_run_thumb2_stub(target) || !mem_codec_dest_in_ram(target, dest, len))
+		return false;
+
+	/* Work out how big the stream can get before a plain write would be quicker */
+	const size_t fixed_cost = MEM_CODEC_RUN_OVERHEAD + 3U * MEM_CODEC_STREAM_OFFSET;
+	if (len <= fixed_cost)
+		return false;
+	/*
+	 * The expander can only be run on a halted core, and with the caches off so what it writes
+	 * reaches memory rather than sitting in data cache lines the debugger would not see
+	 */
+	if (!(target_mem_read32(target, CORTEXM_DHCSR) & CORTEXM_DHCSR_S_HALT) ||
+		(target_mem_read32(target, CORTEXM_CCR) & (CORTEXM_CCR_DC | CORTEXM_CCR_IC)))
+		return false;
+	const size_t budget = (len - fixed_cost) / 3U;
+	uint8_t *const stream = malloc(budget + MEM_CODEC_OUT_SLACK);
+	if (!stream) { /* malloc failed: heap exhaustion */
+		DEBUG_ERROR("malloc: failed in %s\n", __func__);
+		return false;
+	}
+
+	bool result = false;
+	const size_t stream_len = mem_codec_compress(dest, (const uint8_t *)src, len, stream, budget);
+	target_addr_t workspace = 0U;
+	if (stream_len && mem_codec_find_workspace(target, dest, len, MEM_CODEC_STREAM_OFFSET + stream_len, &workspace)) {
+		DEBUG_INFO("Writing %zu bytes to 0x%08" PRIx32 " as %zu compressed bytes\n", len, dest, stream_len);
+		result = mem_codec_expand(target, workspace, dest, stream, stream_len);
+	}
+	free(stream);
+	return result;
+}
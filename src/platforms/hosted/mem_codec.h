@@ -0,0 +1,59 @@
+/*
+ * This file is part of the Black Magic Debug project.
+ *
+ * Copyright (C) 2023 1BitSquared <info@1bitsquared.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PLATFORMS_HOSTED_MEM_CODEC_H
+#define PLATFORMS_HOSTED_MEM_CODEC_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "target.h"
+
+/* Writes shorter than this always go straight over the debug link */
+#define MEM_CODEC_MIN_LENGTH 2048U
+
+/*
+ * Whether large RAM writes may be compressed at all. Off by default as the expander runs on the target
+ * with interrupts unmasked and no valid stack, so it is only safe on a core with nothing pending.
+ */
+extern bool mem_codec_enabled;
+
+/*
+ * Try to write `len` bytes to RAM at `dest` by compressing them and having a routine on the target expand them.
+ * Runs of repeated words become on-target fills and everything else is LZ-style compressed.
+ * Returns false without writing anything if this isn't possible or wouldn't be worthwhile, so the caller
+ * should then do a normal write. This is the case when it has not been enabled, for non-RAM destinations,
+ * running cores, targets that can't run the expander, when there's no spare RAM to run it from, or if the
+ * data doesn't compress well.
+ */
+bool mem_codec_write(target_s *target, target_addr_t dest, const void *src, size_t len);
+
+#endif /* PLATFORMS_HOSTED_MEM_CODEC_H */
@@ -0,0 +1,294 @@
+/*
+ * This file is part of the Black Magic Debug project.
+ *
+ * Copyright (C) 2023 1BitSquared <info@1bitsquared.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * This file implements the streaming memory dump engine used by the CLI's --read mode.
+ *
+ * The dump is split between two threads: the calling thread drives the probe and reads
+ * large blocks of target memory, while a writer thread drains filled blocks to the output
+ * file and accumulates the CRC. A small ring of block buffers sits between the two so USB
+ * and disk I/O overlap rather than alternate.
+ */
+
+#include "general.h"
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include "target_internal.h"
+#include "crc32.h"
+#include "mem_dump.h"
+
+/*
+ * Large enough that the backends can split each request into maximally sized transfers
+ * (1KiB TAR windows, the probe's remote buffer size, etc.) without coming back up to us
+ */
+#define MEM_DUMP_BLOCK_SIZE 0x10000U
+#define MEM_DUMP_SLOTS      4U
+/*
+ * Ranges outside the memory map are read in smaller pieces, in step with how finely peripheral
+ * and reserved regions are usually laid out, so one that faults only leaves a small hole
+ */
+#define MEM_DUMP_UNMAPPED_BLOCK_SIZE 0x400U
+
+typedef struct mem_dump_slot {
+	uint8_t data[MEM_DUMP_BLOCK_SIZE];
+	size_t length;
+	bool sparse;
+} mem_dump_slot_s;
+
+typedef struct mem_dump_state {
+	pthread_mutex_t lock;
+	pthread_cond_t slot_filled;
+	pthread_cond_t slot_freed;
+	mem_dump_slot_s slots[MEM_DUMP_SLOTS];
+	size_t head;    /* Next slot for the reader to fill */
+	size_t tail;    /* Next slot for the writer to drain */
+	size_t pending; /* Number of filled slots not yet drained */
+	bool finished;  /* Set once the reader has nothing further to hand over */
+	bool write_failed;
+	int fd;
+	uint32_t crc;
+	size_t bytes_written;
+} mem_dump_state_s;
+
+static const uint8_t mem_dump_zeros[4096U] = {0};
+
+/*
+ * Figure out how much of the range starting at addr has the same mapping state as addr itself,
+ * returning the length of that run and whether it is covered by the target's memory map
+ */
+static size_t mem_dump_extent(const target_s *const target, const uint32_t addr, const size_t len, bool *const mapped)
+{
+	/* With no memory map to go on, everything is fair game */
+	if (!target->ram && !target->flash) {
+		*mapped = true;
+		return len;
+	}
+
+	uint64_t next_start = (uint64_t)addr + len;
+	for (const target_ram_s *ram = target->ram; ram; ram = ram->next) {
+		const uint64_t end = (uint64_t)ram->start + ram->length;
+		if (addr >= ram->start && addr < end) {
+			*mapped = true;
+			return MIN(len, end - addr);
+		}
+		if (ram->start > addr)
+			next_start = MIN(next_start, ram->start);
+	}
+	for (const target_flash_s *flash = target->flash; flash; flash = flash->next) {
+		const uint64_t end = (uint64_t)flash->start + flash->length;
+		if (addr >= flash->start && addr < end) {
+			*mapped = true;
+			return MIN(len, end - addr);
+		}
+		if (flash->start > addr)
+			next_start = MIN(next_start, flash->start);
+	}
+	*mapped = false;
+	return next_start - addr;
+}
+
+static bool mem_dump_write_slot(mem_dump_state_s *const state, const mem_dump_slot_s *const slot)
+{
+	if (slot->sparse) {
+		/* Leave a hole in the file, but account for it in the CRC as the zeros it will read back as */
+		for (size_t offset = 0; offset < slot->length; offset += sizeof(mem_dump_zeros))
+			state->crc =
+				crc32_update(state->crc, mem_dump_zeros, MIN(sizeof(mem_dump_zeros), slot->length - offset));
+		if (lseek(state->fd, (off_t)slot->length, SEEK_CUR) < 0) {
+			DEBUG_ERROR("Seek in dump file failed: %s\n", strerror(errno));
+			return false;
+		}
+	} else {
+		for (size_t offset = 0; offset < slot->length;) {
+			const ssize_t written = write(state->fd, slot->data + offset, slot->length - offset);
+			if (written < 0) {
+				const int error = errno;
+				if (error == EINTR)
+					continue;
+				DEBUG_ERROR("Write to dump file failed (%d): %s\n", error, strerror(error));
+				return false;
+			}
+			offset += (size_t)written;
+		}
+		state->crc = crc32_update(state->crc, slot->data, slot->length);
+	}
+	state->bytes_written += slot->length;
+	return true;
+}
+
+static void *mem_dump_writer(void *const arg)
+{
+	mem_dump_state_s *const state = (mem_dump_state_s *)arg;
+	pthread_mutex_lock(&state->lock);
+	while (true) {
+		while (!state->pending && !state->finished)
+			pthread_cond_wait(&state->slot_filled, &state->lock);
+		/* If there is nothing left to write and the reader is done, so are we */
+		if (!state->pending)
+			break;
+		const mem_dump_slot_s *const slot = &state->slots[state->tail];
+		/* Drop the lock while doing the actual I/O so the reader can keep filling other slots */
+		pthread_mutex_unlock(&state->lock);
+		const bool success = mem_dump_write_slot(state, slot);
+		pthread_mutex_lock(&state->lock);
+		state->tail = (state->tail + 1U) % MEM_DUMP_SLOTS;
+		--state->pending;
+		if (!success)
+			state->write_failed = true;
+		pthread_cond_signal(&state->slot_freed);
+		if (!success)
+			break;
+	}
+	pthread_mutex_unlock(&state->lock);
+	return NULL;
+}
+
+/* Pick up from the end of a previous, interrupted, dump by re-checksumming what is already on disk */
+static bool mem_dump_resume(mem_dump_state_s *const state, const size_t length, size_t *const resume_offset)
+{
+	const off_t existing = lseek(state->fd, 0, SEEK_END);
+	if (existing < 0 || lseek(state->fd, 0, SEEK_SET) < 0) {
+		DEBUG_ERROR("Unable to determine size of existing dump file: %s\n", strerror(errno));
+		return false;
+	}
+	/* Keep the restart point word aligned so the resumed reads stay nicely aligned too */
+	const size_t offset = MIN((size_t)existing, length) & ~3U;
+	uint8_t *const buffer = state->slots[0].data;
+	for (size_t done = 0; done < offset;) {
+		const ssize_t amount = read(state->fd, buffer, MIN(MEM_DUMP_BLOCK_SIZE, offset - done));
+		if (amount <= 0) {
+			DEBUG_ERROR("Failed to read back existing dump file: %s\n", amount ? strerror(errno) : "unexpected EOF");
+			return false;
+		}
+		state->crc = crc32_update(state->crc, buffer, (size_t)amount);
+		done += (size_t)amount;
+	}
+	if (lseek(state->fd, (off_t)offset, SEEK_SET) < 0)
+		return false;
+	state->bytes_written = offset;
+	*resume_offset = offset;
+	return true;
+}
+
+bool mem_dump(target_s *const target, const int fd, const uint32_t start, const size_t length, const bool resume,
+	mem_dump_result_s *const result)
+{
+	memset(result, 0, sizeof(*result));
+	mem_dump_state_s *const state = calloc(1, sizeof(*state));
+	if (!state) { /* calloc failed: heap exhaustion */
+		DEBUG_ERROR("calloc: failed in %s\n", __func__);
+		return false;
+	}
+	state->fd = fd;
+	state->crc = 0xffffffffU;
+
+	size_t offset = 0;
+	if (resume) {
+		if (!mem_dump_resume(state, length, &offset)) {
+			free(state);
+			return false;
+		}
+		result->resumed_from = offset;
+		if (offset)
+			DEBUG_INFO("Resuming dump at offset 0x%zx\n", offset);
+	}
+
+	pthread_mutex_init(&state->lock, NULL);
+	pthread_cond_init(&state->slot_filled, NULL);
+	pthread_cond_init(&state->slot_freed, NULL);
+	pthread_t writer;
+	if (pthread_create(&writer, NULL, mem_dump_writer, state) != 0) {
+		DEBUG_ERROR("Failed to start dump writer thread\n");
+		free(state);
+		return false;
+	}
+
+	while (offset < length) {
+		pthread_mutex_lock(&state->lock);
+		while (state->pending == MEM_DUMP_SLOTS && !state->write_failed)
+			pthread_cond_wait(&state->slot_freed, &state->lock);
+		const bool write_failed = state->write_failed;
+		mem_dump_slot_s *const slot = &state->slots[state->head];
+		pthread_mutex_unlock(&state->lock);
+		if (write_failed)
+			break;
+
+		/* The slot at head is ours until we publish it, so fill it without holding the lock */
+		const uint32_t addr = start + offset;
+		bool mapped = true;
+		slot->length = mem_dump_extent(target, addr, MIN(length - offset, MEM_DUMP_BLOCK_SIZE), &mapped);
+		if (!mapped) {
+			const size_t unmapped_len = MEM_DUMP_UNMAPPED_BLOCK_SIZE - (addr & (MEM_DUMP_UNMAPPED_BLOCK_SIZE - 1U));
+			slot->length = MIN(slot->length, unmapped_len);
+		}
+		slot->sparse = false;
+		if (target_mem_read(target, slot->data, addr, slot->length)) {
+			if (mapped) {
+				DEBUG_ERROR("Read failed at address 0x%08" PRIx32 "\n", addr);
+				result->read_failed = true;
+				break;
+			}
+			/* Not in the memory map and not readable either, so leave a hole for it */
+			slot->sparse = true;
+			result->bytes_sparse += slot->length;
+		}
+		offset += slot->length;
+
+		pthread_mutex_lock(&state->lock);
+		state->head = (state->head + 1U) % MEM_DUMP_SLOTS;
+		++state->pending;
+		pthread_cond_signal(&state->slot_filled);
+		pthread_mutex_unlock(&state->lock);
+	}
+
+	pthread_mutex_lock(&state->lock);
+	state->finished = true;
+	pthread_cond_signal(&state->slot_filled);
+	pthread_mutex_unlock(&state->lock);
+	pthread_join(writer, NULL);
+
+	bool success = !state->write_failed;
+	/* If the dump ended on a hole, make sure the file still reflects the full length */
+	if (success && ftruncate(fd, (off_t)state->bytes_written) != 0) {
+		DEBUG_ERROR("Failed to set dump file length: %s\n", strerror(errno));
+		success = false;
+	}
+	result->bytes_done = state->bytes_written;
+	result->crc = state->crc;
+
+	pthread_cond_destroy(&state->slot_freed);
+	pthread_cond_destroy(&state->slot_filled);
+	pthread_mutex_destroy(&state->lock);
+	free(state);
+	return success;
+}
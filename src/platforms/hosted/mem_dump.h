@@ -0,0 +1,62 @@
+/*
+ * This file is part of the Black Magic Debug project.
+ *
+ * Copyright (C) 2023 1BitSquared <info@1bitsquared.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PLATFORMS_HOSTED_MEM_DUMP_H
+#define PLATFORMS_HOSTED_MEM_DUMP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "target.h"
+
+typedef struct mem_dump_result {
+	/* Number of bytes of the requested range now present in the output file */
+	size_t bytes_done;
+	/* Number of those bytes outside the target's memory map that faulted when read, left as holes */
+	size_t bytes_sparse;
+	/* Offset the dump was resumed from, 0 if it was started fresh */
+	size_t resumed_from;
+	/* CRC of the file contents computed the same way as the GDB qCRC packet does */
+	uint32_t crc;
+	/* Whether the dump stopped early because the target returned an error */
+	bool read_failed;
+} mem_dump_result_s;
+
+/*
+ * Dump `length` bytes of target memory starting at `start` into the already open file `fd`.
+ * Reads are issued in large blocks while a separate thread writes the data out and checksums it.
+ * Ranges not covered by the target's RAM or Flash map are still read, but left as holes in the file if they fault.
+ * If `resume` is true, any data already in the file is kept and the dump continues after it.
+ */
+bool mem_dump(target_s *target, int fd, uint32_t start, size_t length, bool resume, mem_dump_result_s *result);
+
+#endif /* PLATFORMS_HOSTED_MEM_DUMP_H */
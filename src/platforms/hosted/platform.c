@@ -34,8 +34,11 @@
 #include "target.h"
 #include "target_internal.h"
 #include "adiv5.h"
+#include "riscv_debug.h"
+#include "cortexar.h"
 #include "timing.h"
 #include "cli.h"
+#include "freq_profile.h"
 #include "gdb_if.h"
 #include "gdb_packet.h"
 #include <signal.h>
@@ -60,6 +63,14 @@ swd_proc_s swd_proc;
 
 static bmda_cli_options_s cl_opts;
 
+/* How often the daemon checks on the target while no client is connected */
+#define BMDA_DAEMON_POLL_INTERVAL_MS 1000U
+/* Target voltage, in tenths of a Volt, below which we consider the target to have lost power */
+#define BMDA_DAEMON_POWER_THRESHOLD 5U
+
+static uint32_t daemon_last_poll;
+static bool daemon_target_powered;
+
 void gdb_ident(char *p, int count)
 {
 	snprintf(p, count, "%s (%s), %s", bmda_probe_info.manufacturer, bmda_probe_info.product, bmda_probe_info.version);
@@ -108,6 +119,16 @@ void platform_init(int argc, char **argv)
 	SetConsoleOutputCP(CP_UTF8);
 #endif
 	cl_init(&cl_opts, argc, argv);
+	/* If we're a client of an already running daemon, there is no probe for us to open */
+	if (cl_opts.opt_daemon_port) {
+		if (!cl_opts.opt_monitor) {
+			DEBUG_ERROR("No monitor command given to run via the daemon\n");
+			exit(1);
+		}
+		exit(bmda_daemon_run_command(cl_opts.opt_daemon_port, cl_opts.opt_target_dev, cl_opts.opt_monitor));
+	}
+	if (cl_opts.opt_max_swj_frequency_set)
+		freq_profile_user_frequency(cl_opts.opt_max_swj_frequency);
 	atexit(exit_function);
 	signal(SIGTERM, sigterm_handler);
 	signal(SIGINT, sigterm_handler);
@@ -162,7 +183,55 @@ void platform_init(int argc, char **argv)
 #ifdef ENABLE_RTT
 		rtt_if_init();
 #endif
+		if (cl_opts.opt_daemon)
+			bmda_daemon_scan();
+	}
+}
+
+/* Whether we have any way to tell if the target is powered, currently only BMP and J-Link can sense this */
+static bool bmda_daemon_can_sense_power(void)
+{
+	return bmda_probe_info.type == PROBE_TYPE_BMP || bmda_probe_info.type == PROBE_TYPE_JLINK;
+}
+
+void bmda_daemon_scan(void)
+{
+	target_list_free();
+	if (bmda_daemon_can_sense_power())
+		daemon_target_powered = platform_target_voltage_sense() >= BMDA_DAEMON_POWER_THRESHOLD;
+	if (!scan_for_targets(&cl_opts)) {
+		DEBUG_WARN("Daemon: no targets found\n");
+		return;
+	}
+	cl_display_targets();
+}
+
+void bmda_daemon_poll(void)
+{
+	if (!cl_opts.opt_daemon || !bmda_daemon_can_sense_power())
+		return;
+	const uint32_t now = platform_time_ms();
+	if (now - daemon_last_poll < BMDA_DAEMON_POLL_INTERVAL_MS)
+		return;
+	daemon_last_poll = now;
+
+	/* Reading the target voltage also acts as a keep-alive for the probe link */
+	const bool powered = platform_target_voltage_sense() >= BMDA_DAEMON_POWER_THRESHOLD;
+	if (daemon_target_powered && !powered) {
+		DEBUG_WARN("Daemon: target power lost, discarding targets\n");
+		target_list_free();
+	} else if (!daemon_target_powered && powered) {
+		DEBUG_WARN("Daemon: target power restored, rescanning\n");
+		bmda_daemon_scan();
 	}
+	daemon_target_powered = powered;
+}
+
+void bmda_daemon_client_connected(void)
+{
+	/* If a previous scan came up empty (or the target went away unnoticed), try again for the new client */
+	if (cl_opts.opt_daemon && !target_list)
+		bmda_daemon_scan();
 }
 
 bool bmda_swd_scan(const uint32_t targetid)
@@ -295,6 +364,21 @@ void bmda_adiv5_dp_init(adiv5_debug_port_s *const dp)
 	}
 }
 
+void bmda_riscv_jtag_dtm_init(riscv_dmi_s *const dmi)
+{
+	/* If we're talking to a BMP, try to use its RISC-V acceleration for DMI and memory accesses */
+	if (bmda_probe_info.type == PROBE_TYPE_BMP && !cl_opts.opt_no_hl)
+		remote_riscv_jtag_dtm_init(dmi);
+}
+
+const cortexar_dbg_ops_s *bmda_cortexar_dbg_ops(void)
+{
+	/* If we're talking to a BMP, have it run the Cortex-A/R debug operations rather than the individual accesses */
+	if (bmda_probe_info.type == PROBE_TYPE_BMP && !cl_opts.opt_no_hl)
+		return remote_cortexar_dbg_ops();
+	return NULL;
+}
+
 void bmda_jtag_dp_init(adiv5_debug_port_s *dp)
 {
 #if HOSTED_BMP_ONLY == 0
@@ -696,6 +780,7 @@ uint32_t adiv5_read_no_check(adiv5_debug_port_s *dp, uint16_t addr)
 
 void adiv5_dp_write(adiv5_debug_port_s *dp, uint16_t addr, uint32_t value)
 {
+	adiv5_dp_select(dp);
 	decode_access(addr, ADIV5_LOW_WRITE, 0U, value);
 	DEBUG_PROTO("0x%08" PRIx32 "\n", value);
 	dp->low_access(dp, ADIV5_LOW_WRITE, addr, value);
@@ -703,6 +788,7 @@ void adiv5_dp_write(adiv5_debug_port_s *dp, uint16_t addr, uint32_t value)
 
 uint32_t adiv5_dp_read(adiv5_debug_port_s *dp, uint16_t addr)
 {
+	adiv5_dp_select(dp);
 	uint32_t ret = dp->dp_read(dp, addr);
 	decode_access(addr, ADIV5_LOW_READ, 0U, 0U);
 	DEBUG_PROTO("0x%08" PRIx32 "\n", ret);
@@ -718,6 +804,7 @@ uint32_t adiv5_dp_error(adiv5_debug_port_s *dp)
 
 uint32_t adiv5_dp_low_access(adiv5_debug_port_s *dp, uint8_t rnw, uint16_t addr, uint32_t value)
 {
+	adiv5_dp_select(dp);
 	uint32_t ret = dp->low_access(dp, rnw, addr, value);
 	decode_access(addr, rnw, 0U, value);
 	DEBUG_PROTO("0x%08" PRIx32 "\n", rnw ? ret : value);
@@ -726,6 +813,7 @@ uint32_t adiv5_dp_low_access(adiv5_debug_port_s *dp, uint8_t rnw, uint16_t addr,
 
 uint32_t adiv5_ap_read(adiv5_access_port_s *ap, uint16_t addr)
 {
+	adiv5_dp_select(ap->dp);
 	uint32_t ret = ap->dp->ap_read(ap, addr);
 	decode_access(addr, ADIV5_LOW_READ, ap->apsel, 0U);
 	DEBUG_PROTO("0x%08" PRIx32 "\n", ret);
@@ -734,6 +822,7 @@ uint32_t adiv5_ap_read(adiv5_access_port_s *ap, uint16_t addr)
 
 void adiv5_ap_write(adiv5_access_port_s *ap, uint16_t addr, uint32_t value)
 {
+	adiv5_dp_select(ap->dp);
 	decode_access(addr, ADIV5_LOW_WRITE, ap->apsel, value);
 	DEBUG_PROTO("0x%08" PRIx32 "\n", value);
 	ap->dp->ap_write(ap, addr, value);
@@ -741,6 +830,7 @@ void adiv5_ap_write(adiv5_access_port_s *ap, uint16_t addr, uint32_t value)
 
 void adiv5_mem_read(adiv5_access_port_s *ap, void *dest, uint32_t src, size_t len)
 {
+	adiv5_dp_select(ap->dp);
 	ap->dp->mem_read(ap, dest, src, len);
 	DEBUG_PROTO("ap_memread @ %" PRIx32 " len %zu:", src, len);
 	const uint8_t *const data = (const uint8_t *)dest;
@@ -756,6 +846,7 @@ void adiv5_mem_read(adiv5_access_port_s *ap, void *dest, uint32_t src, size_t le
 
 void adiv5_mem_write_sized(adiv5_access_port_s *ap, uint32_t dest, const void *src, size_t len, align_e align)
 {
+	adiv5_dp_select(ap->dp);
 	DEBUG_PROTO("ap_mem_write_sized @ %" PRIx32 " len %zu, align %d:", dest, len, 1 << align);
 	const uint8_t *const data = (const uint8_t *)src;
 	for (size_t offset = 0; offset < len; ++offset) {
@@ -771,6 +862,7 @@ void adiv5_mem_write_sized(adiv5_access_port_s *ap, uint32_t dest, const void *s
 
 void adiv5_dp_abort(adiv5_debug_port_s *dp, uint32_t abort)
 {
+	adiv5_dp_select(dp);
 	DEBUG_PROTO("Abort: %08" PRIx32 "\n", abort);
 	dp->abort(dp, abort);
 }
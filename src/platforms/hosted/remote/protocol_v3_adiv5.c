@@ -37,6 +37,7 @@
 #include "protocol_v3_adiv5.h"
 #include "hex_utils.h"
 #include "exception.h"
+#include "freq_profile.h"
 
 static bool remote_adiv5_check_error(
 	const char *const func, adiv5_debug_port_s *const dp, const char *const buffer, const ssize_t length)
@@ -50,12 +51,20 @@ static bool remote_adiv5_check_error(
 	if (buffer[0] == REMOTE_RESP_ERR) {
 		const uint64_t response_code = remote_decode_response(buffer + 1, (size_t)length - 1U);
 		const uint8_t error = response_code & 0xffU;
-		/* If the error part of the response code indicates a fault, store the fault value */
-		if (error == REMOTE_ERROR_FAULT)
+		/*
+		 * If the error part of the response code indicates a fault, store the fault value. A target that
+		 * stopped responding (rather than FAULTing the access) counts against the frequency profile
+		 */
+		if (error == REMOTE_ERROR_FAULT) {
 			dp->fault = response_code >> 8U;
+			if (dp->fault == SWDP_ACK_NO_RESPONSE)
+				freq_profile_note_fault();
+		}
 		/* If the error part indicates an exception had occured, make that happen here too */
-		else if (error == REMOTE_ERROR_EXCEPTION)
+		else if (error == REMOTE_ERROR_EXCEPTION) {
+			freq_profile_note_fault();
 			raise_exception(response_code >> 8U, "Remote protocol exception");
+		}
 		/* Otherwise it's an unexpected error */
 		else
 			DEBUG_ERROR("%s: Unexpected error %u\n", func, error);
@@ -0,0 +1,95 @@
+/*
+ * This file is part of the Black Magic Debug project.
+ *
+ * Copyright (C) 2023 1BitSquared <info@1bitsquared.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "bmp_remote.h"
+#include "protocol_v4_defs.h"
+
+#include "protocol_v0.h"
+#include "protocol_v1.h"
+#include "protocol_v2.h"
+#include "protocol_v3.h"
+#include "protocol_v4.h"
+#include "protocol_v4_riscv.h"
+#include "protocol_v4_cortexar.h"
+
+void remote_v4_init(void)
+{
+	remote_funcs = (bmp_remote_protocol_s){
+		.swd_init = remote_v0_swd_init,
+		.jtag_init = remote_v2_jtag_init,
+		.adiv5_init = remote_v3_adiv5_init,
+		.riscv_jtag_init = remote_v4_riscv_jtag_init,
+		.cortexar_dbg_ops = remote_v4_cortexar_dbg_ops,
+		.add_jtag_dev = remote_v1_add_jtag_dev,
+		.get_comms_frequency = remote_v2_get_comms_frequency,
+		.set_comms_frequency = remote_v2_set_comms_frequency,
+		.target_clk_output_enable = remote_v2_target_clk_output_enable,
+	};
+}
+
+bool remote_v4_riscv_jtag_init(riscv_dmi_s *const dmi)
+{
+	/* Firmware built without RISC-V support does not implement the acceleration protocol, so check first */
+	char buffer[REMOTE_MAX_MSG_SIZE];
+	ssize_t length = snprintf(buffer, REMOTE_MAX_MSG_SIZE, "%s", REMOTE_RISCV_CHECK_STR);
+	platform_buffer_write(buffer, length);
+	length = platform_buffer_read(buffer, REMOTE_MAX_MSG_SIZE);
+	if (length < 1 || buffer[0] != REMOTE_RESP_OK) {
+		DEBUG_INFO("Probe firmware does not support RISC-V acceleration, using JTAG for DMI accesses\n");
+		return false;
+	}
+
+	dmi->read = remote_v4_riscv_dmi_read;
+	dmi->write = remote_v4_riscv_dmi_write;
+	dmi->abstract_command = remote_v4_riscv_abstract_command;
+	dmi->mem_read = remote_v4_riscv_mem_read;
+	dmi->mem_write = remote_v4_riscv_mem_write;
+	return true;
+}
+
+const cortexar_dbg_ops_s *remote_v4_cortexar_dbg_ops(void)
+{
+	/* Only ask the probe once whether it was built with Cortex-A/R support, caching the answer */
+	static bool checked = false;
+	static bool available = false;
+	if (!checked) {
+		char buffer[REMOTE_MAX_MSG_SIZE];
+		ssize_t length = snprintf(buffer, REMOTE_MAX_MSG_SIZE, "%s", REMOTE_CORTEXAR_CHECK_STR);
+		platform_buffer_write(buffer, length);
+		length = platform_buffer_read(buffer, REMOTE_MAX_MSG_SIZE);
+		available = length > 0 && buffer[0] == REMOTE_RESP_OK;
+		checked = true;
+		if (!available)
+			DEBUG_INFO("Probe firmware does not support Cortex-A/R acceleration, using ADIv5 for debug accesses\n");
+	}
+	return available ? &remote_v4_cortexar_ops : NULL;
+}
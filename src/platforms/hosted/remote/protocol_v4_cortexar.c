@@ -0,0 +1,233 @@
+/*
+ * This file is part of the Black Magic Debug project.
+ *
+ * Copyright (C) 2023 1BitSquared <info@1bitsquared.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "bmp_remote.h"
+#include "protocol_v4_defs.h"
+#include "protocol_v4_cortexar.h"
+#include "hex_utils.h"
+#include "exception.h"
+
+/* Successful responses start with a byte indicating whether the operation completed cleanly */
+#define REMOTE_CORTEXAR_STATUS_LENGTH 1U
+/* Offset of any data in a successful response: the response code and the hex-encoded status byte */
+#define REMOTE_CORTEXAR_DATA_OFFSET (1U + (REMOTE_CORTEXAR_STATUS_LENGTH * 2U))
+
+/* Maximum number of uint32_t's that can be read through the DTR in one request */
+#define REMOTE_CORTEXAR_DTR_READ_MAX ((REMOTE_MAX_MSG_SIZE - REMOTE_CORTEXAR_DATA_OFFSET - 1U) / 8U)
+/* Maximum number of uint32_t's that can be written through the DTR in one request */
+#define REMOTE_CORTEXAR_DTR_WRITE_MAX ((REMOTE_MAX_MSG_SIZE - REMOTE_CORTEXAR_DTR_WRITE_LENGTH) / 8U)
+
+static bool remote_cortexar_check_error(
+	const char *const func, adiv5_debug_port_s *const dp, const char *const buffer, const ssize_t length)
+{
+	/* Check the response length for error codes */
+	if (length < 1) {
+		DEBUG_ERROR("%s comms error: %zd\n", func, length);
+		return false;
+	}
+	/* Now check if the remote is reporting an error */
+	if (buffer[0] == REMOTE_RESP_ERR) {
+		const uint64_t response_code = remote_decode_response(buffer + 1, (size_t)length - 1U);
+		const uint8_t error = response_code & 0xffU;
+		/* If the error part of the response code indicates a fault, store the fault value */
+		if (error == REMOTE_ERROR_FAULT)
+			dp->fault = response_code >> 8U;
+		/* If the error part indicates an exception had occured, make that happen here too */
+		else if (error == REMOTE_ERROR_EXCEPTION)
+			raise_exception(response_code >> 8U, "Remote protocol exception");
+		/* Otherwise it's an unexpected error */
+		else
+			DEBUG_ERROR("%s: Unexpected error %u\n", func, error);
+	} /* Check if the remote is reporting a parameter error*/
+	else if (buffer[0] == REMOTE_RESP_PARERR)
+		DEBUG_ERROR("%s: !BUG! Firmware reported a parameter error\n", func);
+	/* Check if the firmware is reporting some other kind of error */
+	else if (buffer[0] != REMOTE_RESP_OK)
+		DEBUG_ERROR("%s: Firmware reported unexpected error: %c\n", func, buffer[0]);
+	/* Return whether the remote indicated the request was successfull */
+	return buffer[0] == REMOTE_RESP_OK;
+}
+
+/* Decode the status byte of a successful response */
+static bool remote_cortexar_decode_status(const char *const buffer)
+{
+	uint8_t status = 0U;
+	unhexify(&status, buffer + 1, REMOTE_CORTEXAR_STATUS_LENGTH);
+	return status != 0U;
+}
+
+/* Send a request that has no data in its response and return the status it completed with */
+static bool remote_cortexar_request(
+	const char *const func, adiv5_access_port_s *const ap, char *const buffer, const ssize_t request_length)
+{
+	platform_buffer_write(buffer, request_length);
+	/* Read back the answer and check for errors */
+	const ssize_t length = platform_buffer_read(buffer, REMOTE_MAX_MSG_SIZE);
+	if (!remote_cortexar_check_error(func, ap->dp, buffer, length))
+		return false;
+	return remote_cortexar_decode_status(buffer);
+}
+
+static bool remote_v4_cortexar_run_insn(adiv5_access_port_s *const ap, const target_addr_t base, const uint32_t insn)
+{
+	char buffer[REMOTE_MAX_MSG_SIZE];
+	const ssize_t length = snprintf(buffer, REMOTE_MAX_MSG_SIZE, REMOTE_CORTEXAR_RUN_INSN_STR, ap->dp->dev_index,
+		ap->apsel, ap->csw, (uint32_t)base, insn);
+	return remote_cortexar_request(__func__, ap, buffer, length);
+}
+
+static bool remote_v4_cortexar_run_read_insn(
+	adiv5_access_port_s *const ap, const target_addr_t base, const uint32_t insn, uint32_t *const result)
+{
+	char buffer[REMOTE_MAX_MSG_SIZE];
+	/* Create the request and send it to the remote */
+	ssize_t length = snprintf(buffer, REMOTE_MAX_MSG_SIZE, REMOTE_CORTEXAR_RUN_READ_INSN_STR, ap->dp->dev_index,
+		ap->apsel, ap->csw, (uint32_t)base, insn);
+	platform_buffer_write(buffer, length);
+	/* Read back the answer and check for errors */
+	length = platform_buffer_read(buffer, REMOTE_MAX_MSG_SIZE);
+	if (!remote_cortexar_check_error(__func__, ap->dp, buffer, length))
+		return false;
+	/* If the response indicates all's OK, decode the data read and return it */
+	unhexify(result, buffer + REMOTE_CORTEXAR_DATA_OFFSET, 4U);
+	return remote_cortexar_decode_status(buffer);
+}
+
+static bool remote_v4_cortexar_run_write_insn(
+	adiv5_access_port_s *const ap, const target_addr_t base, const uint32_t insn, const uint32_t data)
+{
+	char buffer[REMOTE_MAX_MSG_SIZE];
+	const ssize_t length = snprintf(buffer, REMOTE_MAX_MSG_SIZE, REMOTE_CORTEXAR_RUN_WRITE_INSN_STR,
+		ap->dp->dev_index, ap->apsel, ap->csw, (uint32_t)base, insn, data);
+	return remote_cortexar_request(__func__, ap, buffer, length);
+}
+
+static bool remote_v4_cortexar_dtr_read(
+	adiv5_access_port_s *const ap, const target_addr_t base, uint32_t *const dest, const size_t count)
+{
+	char buffer[REMOTE_MAX_MSG_SIZE];
+	for (size_t offset = 0; offset < count; offset += REMOTE_CORTEXAR_DTR_READ_MAX) {
+		/* Pick the amount left to read or the block size, whichever is smaller */
+		const size_t amount = MIN(count - offset, REMOTE_CORTEXAR_DTR_READ_MAX);
+		/* Create the request and send it to the remote */
+		ssize_t length = snprintf(buffer, REMOTE_MAX_MSG_SIZE, REMOTE_CORTEXAR_DTR_READ_STR, ap->dp->dev_index,
+			ap->apsel, ap->csw, (uint32_t)base, (uint32_t)amount);
+		platform_buffer_write(buffer, length);
+		/* Read back the answer and check for errors */
+		length = platform_buffer_read(buffer, REMOTE_MAX_MSG_SIZE);
+		if (!remote_cortexar_check_error(__func__, ap->dp, buffer, length)) {
+			DEBUG_ERROR("%s error around word %zu\n", __func__, offset);
+			return false;
+		}
+		/* If the response indicates all's OK, decode the data read */
+		unhexify(dest + offset, buffer + REMOTE_CORTEXAR_DATA_OFFSET, amount * 4U);
+		/* The core's r0 has been left pointing after the block, so the next block picks up from there */
+		if (!remote_cortexar_decode_status(buffer))
+			return false;
+	}
+	return true;
+}
+
+static bool remote_v4_cortexar_dtr_write(
+	adiv5_access_port_s *const ap, const target_addr_t base, const uint32_t *const src, const size_t count)
+{
+	char buffer[REMOTE_MAX_MSG_SIZE];
+	for (size_t offset = 0; offset < count; offset += REMOTE_CORTEXAR_DTR_WRITE_MAX) {
+		/* Pick the amount left to write or the block size, whichever is smaller */
+		const size_t amount = MIN(count - offset, REMOTE_CORTEXAR_DTR_WRITE_MAX);
+		/* Create the request header */
+		ssize_t length = snprintf(buffer, REMOTE_MAX_MSG_SIZE, REMOTE_CORTEXAR_DTR_WRITE_STR, ap->dp->dev_index,
+			ap->apsel, ap->csw, (uint32_t)base, (uint32_t)amount);
+		/* Encode the data to send after the request block and append the packet termination marker */
+		hexify(buffer + length, src + offset, amount * 4U);
+		length += (ssize_t)(amount * 8U);
+		buffer[length++] = REMOTE_EOM;
+		buffer[length] = '\0';
+		if (!remote_cortexar_request(__func__, ap, buffer, length)) {
+			DEBUG_ERROR("%s error around word %zu\n", __func__, offset);
+			return false;
+		}
+	}
+	return true;
+}
+
+static void remote_v4_cortexar_core_regs_read(
+	adiv5_access_port_s *const ap, const target_addr_t base, uint32_t *const regs, const size_t count)
+{
+	char buffer[REMOTE_MAX_MSG_SIZE];
+	/* Create the request and send it to the remote */
+	ssize_t length = snprintf(buffer, REMOTE_MAX_MSG_SIZE, REMOTE_CORTEXAR_REGS_READ_STR, ap->dp->dev_index,
+		ap->apsel, ap->csw, (uint32_t)base, (uint8_t)count);
+	platform_buffer_write(buffer, length);
+	/* Read back the answer and check for errors */
+	length = platform_buffer_read(buffer, REMOTE_MAX_MSG_SIZE);
+	if (!remote_cortexar_check_error(__func__, ap->dp, buffer, length)) {
+		memset(regs, 0, count * 4U);
+		return;
+	}
+	/* If the response indicates all's OK, decode the registers read */
+	unhexify(regs, buffer + REMOTE_CORTEXAR_DATA_OFFSET, count * 4U);
+}
+
+static void remote_v4_cortexar_core_regs_write(
+	adiv5_access_port_s *const ap, const target_addr_t base, const uint32_t *const regs, const size_t count)
+{
+	char buffer[REMOTE_MAX_MSG_SIZE];
+	/* Create the request header */
+	ssize_t length = snprintf(buffer, REMOTE_MAX_MSG_SIZE, REMOTE_CORTEXAR_REGS_WRITE_STR, ap->dp->dev_index,
+		ap->apsel, ap->csw, (uint32_t)base, (uint8_t)count);
+	/* Encode the register values after the request block and append the packet termination marker */
+	hexify(buffer + length, regs, count * 4U);
+	length += (ssize_t)(count * 8U);
+	buffer[length++] = REMOTE_EOM;
+	buffer[length] = '\0';
+	remote_cortexar_request(__func__, ap, buffer, length);
+}
+
+static bool remote_v4_cortexar_resume(adiv5_access_port_s *const ap, const target_addr_t base, const uint32_t dscr)
+{
+	char buffer[REMOTE_MAX_MSG_SIZE];
+	const ssize_t length = snprintf(buffer, REMOTE_MAX_MSG_SIZE, REMOTE_CORTEXAR_RESUME_STR, ap->dp->dev_index,
+		ap->apsel, ap->csw, (uint32_t)base, dscr);
+	return remote_cortexar_request(__func__, ap, buffer, length);
+}
+
+const cortexar_dbg_ops_s remote_v4_cortexar_ops = {
+	.run_insn = remote_v4_cortexar_run_insn,
+	.run_read_insn = remote_v4_cortexar_run_read_insn,
+	.run_write_insn = remote_v4_cortexar_run_write_insn,
+	.dtr_read = remote_v4_cortexar_dtr_read,
+	.dtr_write = remote_v4_cortexar_dtr_write,
+	.core_regs_read = remote_v4_cortexar_core_regs_read,
+	.core_regs_write = remote_v4_cortexar_core_regs_write,
+	.resume = remote_v4_cortexar_resume,
+};
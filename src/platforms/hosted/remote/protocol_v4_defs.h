@@ -0,0 +1,187 @@
+/*
+ * This file is part of the Black Magic Debug project.
+ *
+ * Copyright (C) 2023 1BitSquared <info@1bitsquared.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PLATFORMS_HOSTED_REMOTE_PROTOCOL_V4_DEFS_H
+#define PLATFORMS_HOSTED_REMOTE_PROTOCOL_V4_DEFS_H
+
+/* Bring in the v3 protocol definitions */
+#include "protocol_v3_defs.h"
+
+/* This version of the protocol introduces the RISC-V acceleration protocol */
+#define REMOTE_RISCV_PACKET       'R'
+#define REMOTE_RISCV_CHECK        'C'
+#define REMOTE_RISCV_DMI_READ     'd'
+#define REMOTE_RISCV_DMI_WRITE    'D'
+#define REMOTE_RISCV_ABST_COMMAND 'c'
+#define REMOTE_RISCV_MEM_READ     'm'
+#define REMOTE_RISCV_MEM_WRITE    'M'
+
+#define REMOTE_RISCV_DEV_INDEX   REMOTE_UINT8
+#define REMOTE_RISCV_IDLE_CYCLES REMOTE_UINT8
+#define REMOTE_RISCV_ADDR_WIDTH  REMOTE_UINT8
+#define REMOTE_RISCV_ADDR32      REMOTE_UINT32
+#define REMOTE_RISCV_DATA        REMOTE_UINT32
+#define REMOTE_RISCV_DM_BASE     REMOTE_UINT32
+#define REMOTE_RISCV_COMMAND     REMOTE_UINT32
+#define REMOTE_RISCV_HART_FLAGS  REMOTE_UINT8
+#define REMOTE_RISCV_COUNT       REMOTE_UINT32
+
+#define REMOTE_RISCV_CHECK_STR                                             \
+	(char[])                                                               \
+	{                                                                      \
+		REMOTE_SOM, REMOTE_RISCV_PACKET, REMOTE_RISCV_CHECK, REMOTE_EOM, 0 \
+	}
+#define REMOTE_RISCV_DMI_READ_STR                                                                 \
+	(char[])                                                                                      \
+	{                                                                                             \
+		REMOTE_SOM, REMOTE_RISCV_PACKET, REMOTE_RISCV_DMI_READ, REMOTE_RISCV_DEV_INDEX,           \
+			REMOTE_RISCV_IDLE_CYCLES, REMOTE_RISCV_ADDR_WIDTH, REMOTE_RISCV_ADDR32, REMOTE_EOM, 0 \
+	}
+#define REMOTE_RISCV_DMI_WRITE_STR                                                                     \
+	(char[])                                                                                           \
+	{                                                                                                  \
+		REMOTE_SOM, REMOTE_RISCV_PACKET, REMOTE_RISCV_DMI_WRITE, REMOTE_RISCV_DEV_INDEX,               \
+			REMOTE_RISCV_IDLE_CYCLES, REMOTE_RISCV_ADDR_WIDTH, REMOTE_RISCV_ADDR32, REMOTE_RISCV_DATA, \
+			REMOTE_EOM, 0                                                                              \
+	}
+#define REMOTE_RISCV_ABST_COMMAND_STR                                                                      \
+	(char[])                                                                                               \
+	{                                                                                                      \
+		REMOTE_SOM, REMOTE_RISCV_PACKET, REMOTE_RISCV_ABST_COMMAND, REMOTE_RISCV_DEV_INDEX,                \
+			REMOTE_RISCV_IDLE_CYCLES, REMOTE_RISCV_ADDR_WIDTH, REMOTE_RISCV_DM_BASE, REMOTE_RISCV_COMMAND, \
+			REMOTE_EOM, 0                                                                                  \
+	}
+#define REMOTE_RISCV_MEM_READ_STR                                                                             \
+	(char[])                                                                                                  \
+	{                                                                                                         \
+		REMOTE_SOM, REMOTE_RISCV_PACKET, REMOTE_RISCV_MEM_READ, REMOTE_RISCV_DEV_INDEX,                       \
+			REMOTE_RISCV_IDLE_CYCLES, REMOTE_RISCV_ADDR_WIDTH, REMOTE_RISCV_DM_BASE, REMOTE_RISCV_HART_FLAGS, \
+			REMOTE_RISCV_ADDR32, REMOTE_RISCV_COUNT, REMOTE_EOM, 0                                            \
+	}
+#define REMOTE_RISCV_MEM_WRITE_STR                                                                            \
+	(char[])                                                                                                  \
+	{                                                                                                         \
+		REMOTE_SOM, REMOTE_RISCV_PACKET, REMOTE_RISCV_MEM_WRITE, REMOTE_RISCV_DEV_INDEX,                      \
+			REMOTE_RISCV_IDLE_CYCLES, REMOTE_RISCV_ADDR_WIDTH, REMOTE_RISCV_DM_BASE, REMOTE_RISCV_HART_FLAGS, \
+			REMOTE_RISCV_ADDR32, REMOTE_RISCV_COUNT, 0                                                        \
+	}
+/*
+ * 3 leader bytes + 2 bytes for dev index + 2 for idle cycles + 2 for the address width + 8 for the
+ * DM base + 2 for the Hart flags + 8 for the address and 8 for the count and one trailer gives 36U
+ */
+#define REMOTE_RISCV_MEM_WRITE_LENGTH 36U
+
+/* As well as the Cortex-A/R debug operation protocol */
+#define REMOTE_CORTEXAR_PACKET         'C'
+#define REMOTE_CORTEXAR_CHECK          'C'
+#define REMOTE_CORTEXAR_RUN_INSN       'i'
+#define REMOTE_CORTEXAR_RUN_READ_INSN  'r'
+#define REMOTE_CORTEXAR_RUN_WRITE_INSN 'w'
+#define REMOTE_CORTEXAR_DTR_READ       'd'
+#define REMOTE_CORTEXAR_DTR_WRITE      'D'
+#define REMOTE_CORTEXAR_REGS_READ      'g'
+#define REMOTE_CORTEXAR_REGS_WRITE     'G'
+#define REMOTE_CORTEXAR_RESUME         'R'
+
+#define REMOTE_CORTEXAR_BASE      REMOTE_UINT32
+#define REMOTE_CORTEXAR_INSN      REMOTE_UINT32
+#define REMOTE_CORTEXAR_DATA      REMOTE_UINT32
+#define REMOTE_CORTEXAR_COUNT     REMOTE_UINT32
+#define REMOTE_CORTEXAR_REG_COUNT REMOTE_UINT8
+
+/*
+ * All Cortex-A/R requests start with the same device index, AP select and CSW as the ADIv5 memory requests,
+ * followed by the base address of the core's debug unit. Successful responses start with a byte that is 0 if
+ * the operation triggered a synchronous data abort (or the core did not resume) and 1 otherwise, followed by
+ * any data. ADIv5 faults and exceptions are reported the same way as for ADIv5 requests.
+ */
+#define REMOTE_CORTEXAR_CHECK_STR                                                \
+	(char[])                                                                     \
+	{                                                                            \
+		REMOTE_SOM, REMOTE_CORTEXAR_PACKET, REMOTE_CORTEXAR_CHECK, REMOTE_EOM, 0 \
+	}
+#define REMOTE_CORTEXAR_RUN_INSN_STR                                                                               \
+	(char[])                                                                                                       \
+	{                                                                                                              \
+		REMOTE_SOM, REMOTE_CORTEXAR_PACKET, REMOTE_CORTEXAR_RUN_INSN, REMOTE_ADIv5_DEV_INDEX, REMOTE_ADIv5_AP_SEL, \
+			REMOTE_ADIv5_CSW, REMOTE_CORTEXAR_BASE, REMOTE_CORTEXAR_INSN, REMOTE_EOM, 0                            \
+	}
+#define REMOTE_CORTEXAR_RUN_READ_INSN_STR                                                                    \
+	(char[])                                                                                                 \
+	{                                                                                                        \
+		REMOTE_SOM, REMOTE_CORTEXAR_PACKET, REMOTE_CORTEXAR_RUN_READ_INSN, REMOTE_ADIv5_DEV_INDEX,           \
+			REMOTE_ADIv5_AP_SEL, REMOTE_ADIv5_CSW, REMOTE_CORTEXAR_BASE, REMOTE_CORTEXAR_INSN, REMOTE_EOM, 0 \
+	}
+#define REMOTE_CORTEXAR_RUN_WRITE_INSN_STR                                                          \
+	(char[])                                                                                        \
+	{                                                                                               \
+		REMOTE_SOM, REMOTE_CORTEXAR_PACKET, REMOTE_CORTEXAR_RUN_WRITE_INSN, REMOTE_ADIv5_DEV_INDEX, \
+			REMOTE_ADIv5_AP_SEL, REMOTE_ADIv5_CSW, REMOTE_CORTEXAR_BASE, REMOTE_CORTEXAR_INSN,      \
+			REMOTE_CORTEXAR_DATA, REMOTE_EOM, 0                                                     \
+	}
+#define REMOTE_CORTEXAR_DTR_READ_STR                                                                               \
+	(char[])                                                                                                       \
+	{                                                                                                              \
+		REMOTE_SOM, REMOTE_CORTEXAR_PACKET, REMOTE_CORTEXAR_DTR_READ, REMOTE_ADIv5_DEV_INDEX, REMOTE_ADIv5_AP_SEL, \
+			REMOTE_ADIv5_CSW, REMOTE_CORTEXAR_BASE, REMOTE_CORTEXAR_COUNT, REMOTE_EOM, 0                           \
+	}
+#define REMOTE_CORTEXAR_DTR_WRITE_STR                                                                               \
+	(char[])                                                                                                        \
+	{                                                                                                               \
+		REMOTE_SOM, REMOTE_CORTEXAR_PACKET, REMOTE_CORTEXAR_DTR_WRITE, REMOTE_ADIv5_DEV_INDEX, REMOTE_ADIv5_AP_SEL, \
+			REMOTE_ADIv5_CSW, REMOTE_CORTEXAR_BASE, REMOTE_CORTEXAR_COUNT, 0                                        \
+	}
+/*
+ * 3 leader bytes + 2 bytes for dev index + 2 bytes for AP select + 8 for CSW + 8 for the debug base
+ * and 8 for the count and one trailer gives 32U
+ */
+#define REMOTE_CORTEXAR_DTR_WRITE_LENGTH 32U
+#define REMOTE_CORTEXAR_REGS_READ_STR                                                                               \
+	(char[])                                                                                                        \
+	{                                                                                                               \
+		REMOTE_SOM, REMOTE_CORTEXAR_PACKET, REMOTE_CORTEXAR_REGS_READ, REMOTE_ADIv5_DEV_INDEX, REMOTE_ADIv5_AP_SEL, \
+			REMOTE_ADIv5_CSW, REMOTE_CORTEXAR_BASE, REMOTE_CORTEXAR_REG_COUNT, REMOTE_EOM, 0                        \
+	}
+#define REMOTE_CORTEXAR_REGS_WRITE_STR                                                                \
+	(char[])                                                                                          \
+	{                                                                                                 \
+		REMOTE_SOM, REMOTE_CORTEXAR_PACKET, REMOTE_CORTEXAR_REGS_WRITE, REMOTE_ADIv5_DEV_INDEX,       \
+			REMOTE_ADIv5_AP_SEL, REMOTE_ADIv5_CSW, REMOTE_CORTEXAR_BASE, REMOTE_CORTEXAR_REG_COUNT, 0 \
+	}
+#define REMOTE_CORTEXAR_RESUME_STR                                                                               \
+	(char[])                                                                                                     \
+	{                                                                                                            \
+		REMOTE_SOM, REMOTE_CORTEXAR_PACKET, REMOTE_CORTEXAR_RESUME, REMOTE_ADIv5_DEV_INDEX, REMOTE_ADIv5_AP_SEL, \
+			REMOTE_ADIv5_CSW, REMOTE_CORTEXAR_BASE, REMOTE_CORTEXAR_DATA, REMOTE_EOM, 0                          \
+	}
+
+#endif /*PLATFORMS_HOSTED_REMOTE_PROTOCOL_V4_DEFS_H*/
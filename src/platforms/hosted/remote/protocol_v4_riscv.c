@@ -0,0 +1,232 @@
+/*
+ * This file is part of the Black Magic Debug project.
+ *
+ * Copyright (C) 2023 1BitSquared <info@1bitsquared.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <assert.h>
+#include "bmp_remote.h"
+#include "protocol_v4_defs.h"
+#include "protocol_v4_riscv.h"
+#include "hex_utils.h"
+#include "exception.h"
+#include "freq_profile.h"
+
+/* Successful responses start with 2 bytes for the DTM's idle cycle count and the Hart status */
+#define REMOTE_RISCV_HEADER_LENGTH 2U
+
+static bool remote_riscv_check_error(
+	const char *const func, riscv_dmi_s *const dmi, const char *const buffer, const ssize_t length)
+{
+	/* Check the response length for error codes */
+	if (length < 1) {
+		DEBUG_ERROR("%s comms error: %zd\n", func, length);
+		return false;
+	}
+	/* Now check if the remote is reporting an error */
+	if (buffer[0] == REMOTE_RESP_ERR) {
+		const uint64_t response_code = remote_decode_response(buffer + 1, (size_t)length - 1U);
+		const uint8_t error = response_code & 0xffU;
+		/* If the error part of the response code indicates a fault, store the DMI status and idle cycles */
+		if (error == REMOTE_ERROR_FAULT) {
+			dmi->fault = (response_code >> 8U) & 0xffU;
+			dmi->idle_cycles = (response_code >> 16U) & 0xffU;
+			dmi->faulted = true;
+			freq_profile_note_fault();
+		}
+		/* If the error part indicates an exception had occured, make that happen here too */
+		else if (error == REMOTE_ERROR_EXCEPTION) {
+			freq_profile_note_fault();
+			raise_exception(response_code >> 8U, "Remote protocol exception");
+		}
+		/* Otherwise it's an unexpected error */
+		else
+			DEBUG_ERROR("%s: Unexpected error %u\n", func, error);
+	} /* Check if the remote is reporting a parameter error*/
+	else if (buffer[0] == REMOTE_RESP_PARERR)
+		DEBUG_ERROR("%s: !BUG! Firmware reported a parameter error\n", func);
+	/* Check if the firmware is reporting some other kind of error */
+	else if (buffer[0] != REMOTE_RESP_OK)
+		DEBUG_ERROR("%s: Firmware reported unexpected error: %c\n", func, buffer[0]);
+	/* Return whether the remote indicated the request was successfull */
+	return buffer[0] == REMOTE_RESP_OK;
+}
+
+/* Decode the header of a successful response, returning the Hart status it carries */
+static riscv_hart_status_e remote_riscv_decode_header(riscv_dmi_s *const dmi, const char *const buffer)
+{
+	uint8_t header[REMOTE_RISCV_HEADER_LENGTH];
+	unhexify(header, buffer + 1, REMOTE_RISCV_HEADER_LENGTH);
+	/*
+	 * The firmware may have had to raise the idle cycle count to get the request through, so keep that.
+	 * It only does so when an access came back busy and had to be retried, which is a fault as far as
+	 * anything relying on the exact sequence of DMI accesses (like batched autoexec) is concerned.
+	 */
+	if (header[0] != dmi->idle_cycles)
+		dmi->faulted = true;
+	dmi->idle_cycles = header[0];
+	dmi->fault = 0U;
+	return (riscv_hart_status_e)header[1];
+}
+
+bool remote_v4_riscv_dmi_read(riscv_dmi_s *const dmi, const uint32_t address, uint32_t *const value)
+{
+	char buffer[REMOTE_MAX_MSG_SIZE];
+	/* Create the request and send it to the remote */
+	ssize_t length = snprintf(buffer, REMOTE_MAX_MSG_SIZE, REMOTE_RISCV_DMI_READ_STR, dmi->dev_index,
+		dmi->idle_cycles, dmi->address_width, address);
+	platform_buffer_write(buffer, length);
+	/* Read back the answer and check for errors */
+	length = platform_buffer_read(buffer, REMOTE_MAX_MSG_SIZE);
+	if (!remote_riscv_check_error(__func__, dmi, buffer, length)) {
+		DEBUG_WARN("DMI read at 0x%08" PRIx32 " failed with status %u\n", address, dmi->fault);
+		return false;
+	}
+	/* If the response indicates all's OK, decode the data read and return it */
+	remote_riscv_decode_header(dmi, buffer);
+	unhexify(value, buffer + 1U + REMOTE_RISCV_HEADER_LENGTH * 2U, 4);
+	DEBUG_PROBE("%s: addr %08" PRIx32 " -> %08" PRIx32 "\n", __func__, address, *value);
+	return true;
+}
+
+bool remote_v4_riscv_dmi_write(riscv_dmi_s *const dmi, const uint32_t address, const uint32_t value)
+{
+	char buffer[REMOTE_MAX_MSG_SIZE];
+	/* Create the request and send it to the remote */
+	ssize_t length = snprintf(buffer, REMOTE_MAX_MSG_SIZE, REMOTE_RISCV_DMI_WRITE_STR, dmi->dev_index,
+		dmi->idle_cycles, dmi->address_width, address, value);
+	platform_buffer_write(buffer, length);
+	/* Read back the answer and check for errors */
+	length = platform_buffer_read(buffer, REMOTE_MAX_MSG_SIZE);
+	if (!remote_riscv_check_error(__func__, dmi, buffer, length)) {
+		DEBUG_WARN("DMI write at 0x%08" PRIx32 " failed with status %u\n", address, dmi->fault);
+		return false;
+	}
+	remote_riscv_decode_header(dmi, buffer);
+	DEBUG_PROBE("%s: addr %08" PRIx32 " <- %08" PRIx32 "\n", __func__, address, value);
+	return true;
+}
+
+bool remote_v4_riscv_abstract_command(riscv_hart_s *const hart, const uint32_t command)
+{
+	riscv_dmi_s *const dmi = hart->dbg_module->dmi_bus;
+	char buffer[REMOTE_MAX_MSG_SIZE];
+	/* Create the request and send it to the remote */
+	ssize_t length = snprintf(buffer, REMOTE_MAX_MSG_SIZE, REMOTE_RISCV_ABST_COMMAND_STR, dmi->dev_index,
+		dmi->idle_cycles, dmi->address_width, hart->dbg_module->base, command);
+	platform_buffer_write(buffer, length);
+	/* Read back the answer and check for errors */
+	length = platform_buffer_read(buffer, REMOTE_MAX_MSG_SIZE);
+	if (!remote_riscv_check_error(__func__, dmi, buffer, length))
+		return false;
+	/* The command completed one way or another, so pick up how it went */
+	hart->status = remote_riscv_decode_header(dmi, buffer);
+	DEBUG_PROBE("%s: command %08" PRIx32 " -> status %u\n", __func__, command, hart->status);
+	if (hart->status != RISCV_HART_NO_ERROR)
+		DEBUG_WARN("CSR access failed: %u\n", hart->status);
+	return hart->status == RISCV_HART_NO_ERROR;
+}
+
+void remote_v4_riscv_mem_read(riscv_hart_s *const hart, void *const dest, const target_addr_t src, const size_t len)
+{
+	riscv_dmi_s *const dmi = hart->dbg_module->dmi_bus;
+	uint8_t *const data = (uint8_t *)dest;
+	DEBUG_PROBE("%s: @%08" PRIx32 "+%zx\n", __func__, src, len);
+	char buffer[REMOTE_MAX_MSG_SIZE];
+	/*
+	 * As we do, calculate how large a transfer we can do to the firmware.
+	 * There are 2 leader bytes around responses, the header and data are hex-encoded taking 2 bytes a byte,
+	 * and we keep the blocks a multiple of 4 bytes so the firmware can use full width accesses
+	 */
+	const size_t blocksize = (((REMOTE_MAX_MSG_SIZE - 2U) / 2U) - REMOTE_RISCV_HEADER_LENGTH) & ~3U;
+	/* For each transfer block size, ask the firmware to read that block of bytes */
+	for (size_t offset = 0; offset < len; offset += blocksize) {
+		/* Pick the amount left to read or the block size, whichever is smaller */
+		const size_t amount = MIN(len - offset, blocksize);
+		/* Create the request and send it to the remote */
+		ssize_t length = snprintf(buffer, REMOTE_MAX_MSG_SIZE, REMOTE_RISCV_MEM_READ_STR, dmi->dev_index,
+			dmi->idle_cycles, dmi->address_width, hart->dbg_module->base, hart->flags, src + (uint32_t)offset,
+			(uint32_t)amount);
+		platform_buffer_write(buffer, length);
+
+		/* Read back the answer and check for errors */
+		length = platform_buffer_read(buffer, REMOTE_MAX_MSG_SIZE);
+		if (!remote_riscv_check_error(__func__, dmi, buffer, length)) {
+			DEBUG_ERROR("%s error around 0x%08zx\n", __func__, (size_t)src + offset);
+			return;
+		}
+		/* If the response indicates all's OK, decode the data read */
+		hart->status = remote_riscv_decode_header(dmi, buffer);
+		unhexify(data + offset, buffer + 1U + REMOTE_RISCV_HEADER_LENGTH * 2U, amount);
+		if (hart->status != RISCV_HART_NO_ERROR) {
+			DEBUG_WARN("memory access failed: %u\n", hart->status);
+			return;
+		}
+	}
+}
+
+void remote_v4_riscv_mem_write(
+	riscv_hart_s *const hart, const target_addr_t dest, const void *const src, const size_t len)
+{
+	riscv_dmi_s *const dmi = hart->dbg_module->dmi_bus;
+	const uint8_t *const data = (const uint8_t *)src;
+	DEBUG_PROBE("%s: @%08" PRIx32 "+%zx\n", __func__, dest, len);
+	/* + 1 for terminating NUL character */
+	char buffer[REMOTE_MAX_MSG_SIZE + 1U];
+	/* As we do, calculate how large a transfer we can do to the firmware, keeping it a multiple of 4 bytes */
+	const size_t blocksize = ((REMOTE_MAX_MSG_SIZE - REMOTE_RISCV_MEM_WRITE_LENGTH) / 2U) & ~3U;
+	/* For each transfer block size, ask the firmware to write that block of bytes */
+	for (size_t offset = 0; offset < len; offset += blocksize) {
+		/* Pick the amount left to write or the block size, whichever is smaller */
+		const size_t amount = MIN(len - offset, blocksize);
+		/* Create the request and validate it ends up the right length */
+		ssize_t length = snprintf(buffer, REMOTE_MAX_MSG_SIZE, REMOTE_RISCV_MEM_WRITE_STR, dmi->dev_index,
+			dmi->idle_cycles, dmi->address_width, hart->dbg_module->base, hart->flags, dest + (uint32_t)offset,
+			(uint32_t)amount);
+		assert(length == REMOTE_RISCV_MEM_WRITE_LENGTH - 1U);
+		/* Encode the data to send after the request block and append the packet termination marker */
+		hexify(buffer + length, data + offset, amount);
+		length += (ssize_t)(amount * 2U);
+		buffer[length++] = REMOTE_EOM;
+		buffer[length++] = '\0';
+		platform_buffer_write(buffer, length);
+
+		/* Read back the answer and check for errors */
+		length = platform_buffer_read(buffer, REMOTE_MAX_MSG_SIZE);
+		if (!remote_riscv_check_error(__func__, dmi, buffer, length)) {
+			DEBUG_ERROR("%s error around 0x%08zx\n", __func__, (size_t)dest + offset);
+			return;
+		}
+		hart->status = remote_riscv_decode_header(dmi, buffer);
+		if (hart->status != RISCV_HART_NO_ERROR) {
+			DEBUG_WARN("memory access failed: %u\n", hart->status);
+			return;
+		}
+	}
+}
@@ -34,6 +34,10 @@
 #include "sfdp.h"
 #include "target.h"
 #include "adiv5.h"
+#include "cortexar.h"
+#ifdef ENABLE_RISCV
+#include "riscv_debug.h"
+#endif
 #include "version.h"
 #include "exception.h"
 #include "hex_utils.h"
@@ -59,12 +63,14 @@ uint64_t remote_hex_string_to_num(const uint32_t max, const char *const str)
 /* hex-ify and send a buffer of data */
 static void remote_send_buf(const void *const buffer, const size_t len)
 {
-	char hex[2] = {0};
+	/* Convert the data in blocks so hexify() gets to work on more than a byte at a time */
+	char hex[65U];
 	const uint8_t *const data = (const uint8_t *)buffer;
-	for (size_t offset = 0; offset < len; ++offset) {
-		hexify(hex, data + offset, 1U);
-		gdb_if_putchar(hex[0], 0);
-		gdb_if_putchar(hex[1], 0);
+	for (size_t offset = 0; offset < len; offset += 32U) {
+		const size_t amount = MIN(len - offset, 32U);
+		hexify(hex, data + offset, amount);
+		for (size_t idx = 0; idx < amount * 2U; ++idx)
+			gdb_if_putchar(hex[idx], 0);
 	}
 }
 
@@ -129,8 +135,8 @@ static void remote_respond_string(const char response_code, const char *const st
  * and remote_packet_process_jtag() for use by remote_packet_process_adiv5() so its faked AP can do the right
  * thing.
  *
- * REMOTE_INIT for SWD and JTAG rewrite the {read,write}_no_check, dp_read, error, low_access and abort function
- * pointers to reconfigure this structure appropriately.
+ * REMOTE_INIT for SWD and JTAG rewrite the {read,write}_no_check, dp_read, error, low_access, abort and
+ * write_burst function pointers to reconfigure this structure appropriately.
  */
 static adiv5_debug_port_s remote_dp = {
 	.ap_read = firmware_ap_read,
@@ -150,6 +156,7 @@ static void remote_packet_process_swd(const char *const packet, const size_t pac
 			remote_dp.error = adiv5_swd_clear_error;
 			remote_dp.low_access = firmware_swdp_low_access;
 			remote_dp.abort = firmware_swdp_abort;
+			remote_dp.write_burst = firmware_swdp_write_burst;
 			swdptap_init();
 			remote_respond(REMOTE_RESP_OK, 0);
 		} else
@@ -203,6 +210,7 @@ static void remote_packet_process_jtag(const char *const packet, const size_t pa
 		remote_dp.error = adiv5_jtagdp_error;
 		remote_dp.low_access = fw_adiv5_jtagdp_low_access;
 		remote_dp.abort = adiv5_jtagdp_abort;
+		remote_dp.write_burst = NULL;
 		jtagtap_init();
 		remote_respond(REMOTE_RESP_OK, 0);
 		break;
@@ -394,6 +402,8 @@ static void remote_packet_process_adiv5(const char *const packet, const size_t p
 	adiv5_access_port_s remote_ap;
 	remote_ap.apsel = remote_hex_string_to_num(2, packet + 4);
 	remote_ap.dp = &remote_dp;
+	/* The remote protocol carries no AP capability information, so don't assume packed transfer support */
+	remote_ap.flags = 0U;
 
 	SET_IDLE_STATE(0);
 	switch (packet[1]) {
@@ -485,6 +495,273 @@ static void remote_packet_process_adiv5(const char *const packet, const size_t p
 	SET_IDLE_STATE(1);
 }
 
+#ifdef ENABLE_CORTEXAR
+static void remote_cortexar_respond(const bool result, const void *const data, const size_t length)
+{
+	/* If the request caused an ADIv5 fault, tell the host */
+	if (remote_dp.fault) {
+		remote_respond(REMOTE_RESP_ERR, REMOTE_ERROR_FAULT | ((uint16_t)remote_dp.fault << 8U));
+		return;
+	}
+	/* Otherwise reply back with the result of the operation and then any data */
+	const uint8_t status = result ? 1U : 0U;
+	gdb_if_putchar(REMOTE_RESP, 0);
+	gdb_if_putchar(REMOTE_RESP_OK, 0);
+	remote_send_buf(&status, 1U);
+	remote_send_buf(data, length);
+	gdb_if_putchar(REMOTE_EOM, 1);
+}
+
+static void remote_packet_process_cortexar(const char *const packet, const size_t packet_len)
+{
+	if (packet[1] == REMOTE_CORTEXAR_CHECK) { /* CC = check the Cortex-A/R acceleration is available */
+		remote_respond(REMOTE_RESP_OK, 0);
+		return;
+	}
+
+	/* Our shortest Cortex-A/R packet is 24 bytes long, check that we have at least that */
+	if (packet_len < 24U) {
+		remote_respond(REMOTE_RESP_PARERR, 0);
+		return;
+	}
+
+	/* Set up the DP and a fake AP structure to perform the operation with */
+	remote_dp.dev_index = remote_hex_string_to_num(2, packet + 2);
+	adiv5_access_port_s remote_ap;
+	remote_ap.apsel = remote_hex_string_to_num(2, packet + 4);
+	remote_ap.dp = &remote_dp;
+	remote_ap.flags = 0U;
+	remote_ap.csw = remote_hex_string_to_num(8, packet + 6);
+	/* Grab the base address of the core's debug unit */
+	const target_addr_t base = remote_hex_string_to_num(8, packet + 14);
+
+	SET_IDLE_STATE(0);
+	switch (packet[1]) {
+	case REMOTE_CORTEXAR_RUN_INSN: { /* Ci = Run an instruction on the core */
+		const uint32_t insn = remote_hex_string_to_num(8, packet + 22);
+		const bool result = cortexar_dbg_run_insn(&remote_ap, base, insn);
+		remote_cortexar_respond(result, NULL, 0U);
+		break;
+	}
+	case REMOTE_CORTEXAR_RUN_READ_INSN: { /* Cr = Run an instruction on the core and read back the DTR */
+		const uint32_t insn = remote_hex_string_to_num(8, packet + 22);
+		uint32_t value = 0;
+		const bool result = cortexar_dbg_run_read_insn(&remote_ap, base, insn, &value);
+		remote_cortexar_respond(result, &value, 4U);
+		break;
+	}
+	case REMOTE_CORTEXAR_RUN_WRITE_INSN: { /* Cw = Load the DTR and run an instruction on the core */
+		const uint32_t insn = remote_hex_string_to_num(8, packet + 22);
+		const uint32_t value = remote_hex_string_to_num(8, packet + 30);
+		const bool result = cortexar_dbg_run_write_insn(&remote_ap, base, insn, value);
+		remote_cortexar_respond(result, NULL, 0U);
+		break;
+	}
+	case REMOTE_CORTEXAR_DTR_READ: { /* Cd = Read a block of memory through the DTR */
+		/* Grab how many uint32_t's to read, validating it for buffer overflows */
+		const uint32_t count = remote_hex_string_to_num(8, packet + 22);
+		if (count > GDB_PACKET_BUFFER_SIZE / 4U) {
+			remote_respond(REMOTE_RESP_PARERR, 0);
+			break;
+		}
+		/* Get the aligned packet buffer to reuse for the data read */
+		uint32_t *const data = (uint32_t *)gdb_packet_buffer();
+		/* Perform the read and send back the results */
+		const bool result = cortexar_dbg_dtr_read(&remote_ap, base, data, count);
+		remote_cortexar_respond(result, data, count * 4U);
+		break;
+	}
+	case REMOTE_CORTEXAR_DTR_WRITE: { /* CD = Write a block of memory through the DTR */
+		/* Grab how many uint32_t's to write, validating it for buffer overflows */
+		const uint32_t count = remote_hex_string_to_num(8, packet + 22);
+		if (count > GDB_PACKET_BUFFER_SIZE / 4U || packet_len < 30U + count * 8U) {
+			remote_respond(REMOTE_RESP_PARERR, 0);
+			break;
+		}
+		/* Get the aligned packet buffer to reuse for the data to write and decode the data into it */
+		uint32_t *const data = (uint32_t *)gdb_packet_buffer();
+		unhexify(data, packet + 30U, count * 4U);
+		/* Perform the write and report success/failures */
+		const bool result = cortexar_dbg_dtr_write(&remote_ap, base, data, count);
+		remote_cortexar_respond(result, NULL, 0U);
+		break;
+	}
+	case REMOTE_CORTEXAR_REGS_READ: { /* Cg = Read the core registers r0 through r(count - 1) */
+		const uint8_t count = remote_hex_string_to_num(2, packet + 22);
+		if (count > CORTEXAR_DBG_GPR_COUNT) {
+			remote_respond(REMOTE_RESP_PARERR, 0);
+			break;
+		}
+		uint32_t regs[CORTEXAR_DBG_GPR_COUNT];
+		cortexar_dbg_core_regs_read(&remote_ap, base, regs, count);
+		remote_cortexar_respond(true, regs, count * 4U);
+		break;
+	}
+	case REMOTE_CORTEXAR_REGS_WRITE: { /* CG = Write the core registers r0 through r(count - 1) */
+		const uint8_t count = remote_hex_string_to_num(2, packet + 22);
+		if (count > CORTEXAR_DBG_GPR_COUNT || packet_len < 24U + count * 8U) {
+			remote_respond(REMOTE_RESP_PARERR, 0);
+			break;
+		}
+		uint32_t regs[CORTEXAR_DBG_GPR_COUNT];
+		unhexify(regs, packet + 24U, count * 4U);
+		cortexar_dbg_core_regs_write(&remote_ap, base, regs, count);
+		remote_cortexar_respond(true, NULL, 0U);
+		break;
+	}
+	case REMOTE_CORTEXAR_RESUME: { /* CR = Resume the core and wait for it to restart */
+		const uint32_t dscr = remote_hex_string_to_num(8, packet + 22);
+		const bool result = cortexar_dbg_resume(&remote_ap, base, dscr);
+		remote_cortexar_respond(result, NULL, 0U);
+		break;
+	}
+
+	default:
+		remote_respond(REMOTE_RESP_ERR, REMOTE_ERROR_UNRECOGNISED);
+		break;
+	}
+	SET_IDLE_STATE(1);
+}
+#endif
+
+#ifdef ENABLE_RISCV
+static void remote_riscv_respond(
+	const riscv_dmi_s *const dmi, const riscv_hart_status_e status, const void *const data, const size_t length)
+{
+	/* If a DMI access failed, tell the host the DMI status and how many idle cycles we ended up on */
+	if (dmi->fault) {
+		remote_respond(REMOTE_RESP_ERR,
+			REMOTE_ERROR_FAULT | ((uint32_t)dmi->fault << 8U) | ((uint32_t)dmi->idle_cycles << 16U));
+		return;
+	}
+	/* Otherwise reply back with the idle cycles, the Hart status and then any data */
+	const uint8_t header[2] = {dmi->idle_cycles, status};
+	gdb_if_putchar(REMOTE_RESP, 0);
+	gdb_if_putchar(REMOTE_RESP_OK, 0);
+	remote_send_buf(header, sizeof(header));
+	remote_send_buf(data, length);
+	gdb_if_putchar(REMOTE_EOM, 1);
+}
+
+static void remote_packet_process_riscv(const char *const packet, const size_t packet_len)
+{
+	if (packet[1] == REMOTE_RISCV_CHECK) { /* RC = check the RISC-V acceleration is available */
+		remote_respond(REMOTE_RESP_OK, 0);
+		return;
+	}
+
+	/* Our shortest RISC-V access packet is 16 bytes long, check that we have at least that */
+	if (packet_len < 16U) {
+		remote_respond(REMOTE_RESP_PARERR, 0);
+		return;
+	}
+
+	/* Set up a DMI structure from the DTM parameters the host discovered to perform the access with */
+	riscv_dmi_s dmi = {0};
+	dmi.dev_index = remote_hex_string_to_num(2, packet + 2);
+	dmi.idle_cycles = remote_hex_string_to_num(2, packet + 4);
+	dmi.address_width = remote_hex_string_to_num(2, packet + 6);
+	if (dmi.dev_index >= jtag_dev_count) {
+		remote_respond(REMOTE_RESP_PARERR, 0);
+		return;
+	}
+	riscv_jtag_dmi_setup(&dmi);
+	/* Along with a fake DM and Hart for the commands that need them */
+	riscv_dm_s dbg_module = {0};
+	dbg_module.dmi_bus = &dmi;
+	riscv_hart_s hart = {0};
+	hart.dbg_module = &dbg_module;
+	hart.access_width = 32U;
+	hart.address_width = 32U;
+
+	SET_IDLE_STATE(0);
+	switch (packet[1]) {
+	case REMOTE_RISCV_DMI_READ: { /* Rd = Read from a DMI register */
+		const uint32_t address = remote_hex_string_to_num(8, packet + 8);
+		uint32_t value = 0;
+		dmi.read(&dmi, address, &value);
+		remote_riscv_respond(&dmi, RISCV_HART_NO_ERROR, &value, 4U);
+		break;
+	}
+	case REMOTE_RISCV_DMI_WRITE: { /* RD = Write to a DMI register */
+		if (packet_len < 24U) {
+			remote_respond(REMOTE_RESP_PARERR, 0);
+			break;
+		}
+		const uint32_t address = remote_hex_string_to_num(8, packet + 8);
+		const uint32_t value = remote_hex_string_to_num(8, packet + 16);
+		dmi.write(&dmi, address, value);
+		remote_riscv_respond(&dmi, RISCV_HART_NO_ERROR, NULL, 0U);
+		break;
+	}
+	case REMOTE_RISCV_ABST_COMMAND: { /* Rc = Run an abstract command and wait for it to complete */
+		if (packet_len < 24U) {
+			remote_respond(REMOTE_RESP_PARERR, 0);
+			break;
+		}
+		dbg_module.base = remote_hex_string_to_num(8, packet + 8);
+		const uint32_t command = remote_hex_string_to_num(8, packet + 16);
+		riscv_abstract_command(&hart, command);
+		remote_riscv_respond(&dmi, hart.status, NULL, 0U);
+		break;
+	}
+	case REMOTE_RISCV_MEM_READ: { /* Rm = Read from memory */
+		if (packet_len < 34U) {
+			remote_respond(REMOTE_RESP_PARERR, 0);
+			break;
+		}
+		/* Grab the DM base and the Hart's memory access flags */
+		dbg_module.base = remote_hex_string_to_num(8, packet + 8);
+		hart.flags = remote_hex_string_to_num(2, packet + 16);
+		/* Grab the start address for the read */
+		const uint32_t address = remote_hex_string_to_num(8, packet + 18);
+		/* And how many bytes to read, validating it for buffer overflows */
+		const uint32_t length = remote_hex_string_to_num(8, packet + 26);
+		if (length > 1024U) {
+			remote_respond(REMOTE_RESP_PARERR, 0);
+			break;
+		}
+		/* Get the aligned packet buffer to reuse for the data read */
+		void *data = gdb_packet_buffer();
+		/* Perform the read and send back the results */
+		riscv_hart_mem_read(&hart, data, address, length);
+		remote_riscv_respond(&dmi, hart.status, data, length);
+		break;
+	}
+	case REMOTE_RISCV_MEM_WRITE: { /* RM = Write to memory */
+		if (packet_len < 34U) {
+			remote_respond(REMOTE_RESP_PARERR, 0);
+			break;
+		}
+		/* Grab the DM base and the Hart's memory access flags */
+		dbg_module.base = remote_hex_string_to_num(8, packet + 8);
+		hart.flags = remote_hex_string_to_num(2, packet + 16);
+		/* Grab the start address for the write */
+		const uint32_t dest = remote_hex_string_to_num(8, packet + 18);
+		/* And how many bytes to write, validating it for buffer overflows */
+		const uint32_t length = remote_hex_string_to_num(8, packet + 26);
+		if (length > 1024U || packet_len < 34U + length * 2U) {
+			remote_respond(REMOTE_RESP_PARERR, 0);
+			break;
+		}
+		/* Get the aligned packet buffer to reuse for the data to write */
+		void *data = gdb_packet_buffer();
+		/* And decode the data from the packet into it */
+		unhexify(data, packet + 34U, length);
+		/* Perform the write and report success/failures */
+		riscv_hart_mem_write(&hart, dest, data, length);
+		remote_riscv_respond(&dmi, hart.status, NULL, 0U);
+		break;
+	}
+
+	default:
+		remote_respond(REMOTE_RESP_ERR, REMOTE_ERROR_UNRECOGNISED);
+		break;
+	}
+	SET_IDLE_STATE(1);
+}
+#endif
+
 static void remote_spi_respond(const bool result)
 {
 	if (result)
@@ -630,10 +907,38 @@ void remote_packet_process(unsigned i, char *packet)
 		break;
 	}
 
+#ifdef ENABLE_CORTEXAR
+	case REMOTE_CORTEXAR_PACKET: {
+		/* Setup an exception frame to try the Cortex-A/R operation in */
+		volatile exception_s error = {0};
+		TRY_CATCH (error, EXCEPTION_ALL) {
+			remote_packet_process_cortexar(packet, i);
+		}
+		/* Handle any exception we've caught by translating it into a remote protocol response */
+		if (error.type)
+			remote_respond(REMOTE_RESP_ERR, REMOTE_ERROR_EXCEPTION | ((uint64_t)error.type << 8U));
+		break;
+	}
+#endif
+
 	case REMOTE_SPI_PACKET:
 		remote_packet_process_spi(packet, i);
 		break;
 
+#ifdef ENABLE_RISCV
+	case REMOTE_RISCV_PACKET: {
+		/* Setup an exception frame to try the RISC-V operation in */
+		volatile exception_s error = {0};
+		TRY_CATCH (error, EXCEPTION_ALL) {
+			remote_packet_process_riscv(packet, i);
+		}
+		/* Handle any exception we've caught by translating it into a remote protocol response */
+		if (error.type)
+			remote_respond(REMOTE_RESP_ERR, REMOTE_ERROR_EXCEPTION | ((uint64_t)error.type << 8U));
+		break;
+	}
+#endif
+
 	default: /* Oh dear, unrecognised, return an error */
 		remote_respond(REMOTE_RESP_ERR, REMOTE_ERROR_UNRECOGNISED);
 		break;
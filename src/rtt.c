@@ -32,8 +32,11 @@
 #include "rtt.h"
 #include "rtt_if.h"
 
+#include <stdarg.h>
+
 bool rtt_enabled = false;
 bool rtt_found = false;
+const char *rtt_stop_reason = NULL;
 static bool rtt_halt = false; // true if rtt needs to halt target to access memory
 uint32_t rtt_cbaddr = 0;
 uint32_t rtt_num_up_chan = 0;
@@ -56,6 +59,14 @@ bool rtt_flag_ram;                      // limit ram scanned by rtt
 uint32_t rtt_ram_start;                 // if rtt_flag_ram set, lower limit of ram scanned by rtt
 uint32_t rtt_ram_end;                   // if rtt_flag_ram set, upper limit of ram scanned by rtt
 static uint32_t saved_cblock_header[6]; // first 24 bytes of control block
+/* channel-tagged framing of host data and the counters reported by 'mon rtt status' */
+bool rtt_flag_framed = false;
+uint32_t rtt_up_dropped = 0;
+uint32_t rtt_up_full = 0;
+uint32_t rtt_down_dropped = 0;
+static uint32_t up_dropped_unreported = 0;
+/* true while servicing rtt between GDB packets */
+static bool rtt_quiet = false;
 
 typedef enum rtt_retval {
 	RTT_OK,
@@ -63,6 +74,17 @@ typedef enum rtt_retval {
 	RTT_ERR
 } rtt_retval_e;
 
+/* framed host to target data: parser state, kept across polls as frames can span USB packets */
+typedef enum rtt_frame_state {
+	RTT_FRAME_CHANNEL,
+	RTT_FRAME_LENGTH,
+	RTT_FRAME_PAYLOAD,
+} rtt_frame_state_e;
+
+static rtt_frame_state_e down_frame_state = RTT_FRAME_CHANNEL;
+static uint32_t down_frame_channel;
+static uint32_t down_frame_remaining;
+
 #ifdef RTT_IDENT
 #define Q(x)     #x
 #define QUOTE(x) Q(x)
@@ -74,6 +96,16 @@ char rtt_ident[16] = {0};
 /* usb uart transmit buffer */
 static char xmit_buf[RTT_UP_BUF_SIZE];
 
+static void rtt_outf(const char *const fmt, ...)
+{
+	if (rtt_quiet)
+		return;
+	va_list ap;
+	va_start(ap, fmt);
+	gdb_voutf(fmt, ap);
+	va_end(ap);
+}
+
 /*********************************************************************
 *
 *       rtt control block
@@ -97,7 +129,7 @@ static uint32_t fast_search(target_s *const cur_target, const uint32_t ram_start
 		uint32_t buf_siz = MIN(stride, ram_end - addr);
 		memcpy(srch_buf, srch_buf + stride, m);
 		if (target_mem_read(cur_target, srch_buf + m, addr, buf_siz)) {
-			gdb_outf("rtt: read fail at 0x%" PRIx32 "\r\n", addr);
+			rtt_outf("rtt: read fail at 0x%" PRIx32 "\r\n", addr);
 			return 0;
 		}
 		for (uint32_t i = 0; i < buf_siz; i++) {
@@ -123,7 +155,7 @@ static uint32_t memory_search(target_s *const cur_target, const uint32_t ram_sta
 	for (uint32_t addr = ram_start; addr < ram_end; addr += sizeof(srch_buf) - srch_str_len - 1U) {
 		uint32_t buf_siz = MIN(ram_end - addr, sizeof(srch_buf));
 		if (target_mem_read(cur_target, srch_buf, addr, buf_siz)) {
-			gdb_outf("rtt: read fail at 0x%" PRIx32 "\r\n", addr);
+			rtt_outf("rtt: read fail at 0x%" PRIx32 "\r\n", addr);
 			continue;
 		}
 		for (uint32_t offset = 0; offset + srch_str_len + 1U < buf_siz; offset++) {
@@ -180,13 +212,15 @@ static void find_rtt(target_s *const cur_target)
 
 		/* sanity checks */
 		if (rtt_num_up_chan > 255U || rtt_num_down_chan > 255U) {
-			gdb_out("rtt: bad cblock\r\n");
+			rtt_outf("rtt: bad cblock\r\n");
 			rtt_enabled = false;
+			rtt_stop_reason = "bad cblock";
 			return;
 		}
 		if (rtt_num_up_chan == 0 && rtt_num_down_chan == 0) {
-			gdb_out("rtt: empty cblock\r\n");
+			rtt_outf("rtt: empty cblock\r\n");
 			rtt_enabled = false;
+			rtt_stop_reason = "empty cblock";
 			return;
 		}
 
@@ -253,6 +287,80 @@ static rtt_retval_e read_rtt(target_s *const cur_target, const uint32_t i)
 	return RTT_OK;
 }
 
+/* true if the frame being received can be stored in 'down' channel i */
+static bool rtt_down_frame_valid(const uint32_t i)
+{
+	return down_frame_channel < rtt_num_down_chan && rtt_channel_enabled[i] && rtt_channel[i].buf_addr != 0 &&
+		rtt_channel[i].buf_size != 0 && rtt_channel[i].head < rtt_channel[i].buf_size &&
+		rtt_channel[i].tail < rtt_channel[i].buf_size;
+}
+
+/* framed mode: route each frame from the host to the 'down' channel named in its header */
+static rtt_retval_e read_rtt_framed(target_s *const cur_target)
+{
+	uint32_t updated = 0; /* bitmask of channels whose head moved */
+	uint8_t chunk[RTT_FRAME_MAX_PAYLOAD];
+
+	while (!rtt_nodata()) {
+		if (down_frame_state != RTT_FRAME_PAYLOAD) {
+			const int32_t ch = rtt_getchar();
+			if (ch == -1)
+				break;
+			if (down_frame_state == RTT_FRAME_CHANNEL) {
+				down_frame_channel = (uint32_t)ch;
+				down_frame_state = RTT_FRAME_LENGTH;
+			} else {
+				down_frame_remaining = (uint32_t)ch;
+				down_frame_state = down_frame_remaining ? RTT_FRAME_PAYLOAD : RTT_FRAME_CHANNEL;
+			}
+			continue;
+		}
+
+		const uint32_t i = rtt_num_up_chan + down_frame_channel;
+		uint32_t len = 0;
+		if (rtt_down_frame_valid(i)) {
+			/* copy as much as fits before the target buffer is full or wraps */
+			rtt_channel_s *const channel = &rtt_channel[i];
+			uint32_t space = channel->buf_size - channel->head - (channel->tail == 0 ? 1U : 0U);
+			if (channel->tail > channel->head)
+				space = channel->tail - channel->head - 1U;
+			/* target buffer full: hold off the host if the channel blocks, drop the data otherwise */
+			if (space == 0 && channel->flag == 2U)
+				break;
+			space = MIN(space, MIN(down_frame_remaining, sizeof(chunk)));
+			for (int32_t ch; len < space && (ch = rtt_getchar()) != -1; ++len)
+				chunk[len] = (uint8_t)ch;
+			if (len) {
+				if (target_mem_write(cur_target, channel->buf_addr + channel->head, chunk, len))
+					return RTT_ERR;
+				channel->head = (channel->head + len) % channel->buf_size;
+				updated |= 1U << i;
+			}
+		}
+		if (len == 0) {
+			/* no such channel, not enabled, or full and not blocking: discard the byte */
+			if (rtt_getchar() == -1)
+				break;
+			++rtt_down_dropped;
+			len = 1U;
+		}
+		down_frame_remaining -= len;
+		if (down_frame_remaining == 0)
+			down_frame_state = RTT_FRAME_CHANNEL;
+	}
+
+	if (!updated)
+		return RTT_IDLE;
+	/* update head of each target 'down' buffer written to */
+	for (uint32_t i = rtt_num_up_chan; i < rtt_num_up_chan + rtt_num_down_chan; ++i) {
+		const uint32_t head_addr = rtt_cbaddr + 24U + i * 24U + 12U;
+		if ((updated & (1U << i)) &&
+			target_mem_write(cur_target, head_addr, &rtt_channel[i].head, sizeof(rtt_channel[i].head)))
+			return RTT_ERR;
+	}
+	return RTT_OK;
+}
+
 /*********************************************************************
 *
 *       rtt from target to host
@@ -279,6 +387,54 @@ uint32_t rtt_aligned_mem_read(target_s *t, void *dest, target_addr_t src, size_t
 	return retval;
 }
 
+/* framed mode: tell the host how much data from the target was lost since the last report */
+static bool rtt_send_dropped(void)
+{
+	const uint8_t frame[RTT_FRAME_HEADER_LEN + 4U] = {
+		RTT_FRAME_DROPPED,
+		4U,
+		up_dropped_unreported & 0xffU,
+		(up_dropped_unreported >> 8U) & 0xffU,
+		(up_dropped_unreported >> 16U) & 0xffU,
+		(up_dropped_unreported >> 24U) & 0xffU,
+	};
+	if (rtt_write((const char *)frame, sizeof(frame)) != sizeof(frame))
+		return false;
+	up_dropped_unreported = 0;
+	return true;
+}
+
+/* send data from 'up' channel i to the host, accounting for anything the host did not take */
+static void rtt_send(const uint32_t i, const char *const data, const uint32_t len)
+{
+	if (!rtt_flag_framed) {
+		const uint32_t sent = rtt_write(data, len);
+		rtt_up_dropped += len - sent;
+		return;
+	}
+
+	/* data must not overtake the report of what went missing before it, so if that can't go yet, drop this too */
+	if (up_dropped_unreported && !rtt_send_dropped()) {
+		rtt_up_dropped += len;
+		up_dropped_unreported += len;
+		return;
+	}
+	char frame[RTT_FRAME_HEADER_LEN + RTT_FRAME_MAX_PAYLOAD];
+	for (uint32_t offset = 0; offset < len;) {
+		const uint32_t payload = MIN(len - offset, RTT_FRAME_MAX_PAYLOAD);
+		frame[0] = (char)i;
+		frame[1] = (char)payload;
+		memcpy(frame + RTT_FRAME_HEADER_LEN, data + offset, payload);
+		if (rtt_write(frame, RTT_FRAME_HEADER_LEN + payload) != RTT_FRAME_HEADER_LEN + payload) {
+			/* the host is not keeping up, the rest of this data is lost */
+			rtt_up_dropped += len - offset;
+			up_dropped_unreported += len - offset;
+			return;
+		}
+		offset += payload;
+	}
+}
+
 /* poll if target has new data for host */
 static rtt_retval_e print_rtt(target_s *const cur_target, const uint32_t i)
 {
@@ -289,6 +445,9 @@ static rtt_retval_e print_rtt(target_s *const cur_target, const uint32_t i)
 		return RTT_ERR;
 	if (rtt_channel[i].head == rtt_channel[i].tail)
 		return RTT_IDLE;
+	/* the target has been filling this buffer faster than it is emptied */
+	if ((rtt_channel[i].head + 1U) % rtt_channel[i].buf_size == rtt_channel[i].tail)
+		++rtt_up_full;
 
 	uint32_t bytes_free = sizeof(xmit_buf) - 8U; /* need 8 bytes for alignment and padding */
 	uint32_t bytes_read = 0;
@@ -320,7 +479,7 @@ static rtt_retval_e print_rtt(target_s *const cur_target, const uint32_t i)
 		return RTT_ERR;
 
 	/* write buffer to usb */
-	rtt_write(xmit_buf, bytes_read);
+	rtt_send(i, xmit_buf, bytes_read);
 
 	return RTT_OK;
 }
@@ -332,8 +491,10 @@ static rtt_retval_e print_rtt(target_s *const cur_target, const uint32_t i)
 **********************************************************************
 */
 
-void poll_rtt(target_s *const cur_target)
+/* target_halted is set when polling between GDB packets, which also means GDB must not be sent console output */
+static void rtt_poll(target_s *const cur_target, const bool target_halted)
 {
+	rtt_quiet = target_halted;
 	/* rtt off */
 	if (!cur_target || !rtt_enabled)
 		return;
@@ -348,7 +509,7 @@ void poll_rtt(target_s *const cur_target)
 
 		bool resume_target = false;
 		target_addr_t watch;
-		if (rtt_halt && target_halt_poll(cur_target, &watch) == TARGET_HALT_RUNNING) {
+		if (rtt_halt && !target_halted && target_halt_poll(cur_target, &watch) == TARGET_HALT_RUNNING) {
 			/* briefly halt target during target memory access */
 			target_halt_request(cur_target);
 
@@ -378,11 +539,11 @@ void poll_rtt(target_s *const cur_target)
 			/* copy control block from target */
 			uint32_t rtt_cblock_size = sizeof(rtt_channel[0]) * (rtt_num_up_chan + rtt_num_down_chan);
 			if (target_mem_read(cur_target, rtt_channel, rtt_cbaddr + 24U, rtt_cblock_size)) {
-				gdb_outf("rtt: read fail at 0x%" PRIx32 "\r\n", rtt_cbaddr + 24U);
+				rtt_outf("rtt: read fail at 0x%" PRIx32 "\r\n", rtt_cbaddr + 24U);
 				rtt_err = true;
 			} else {
 				for (uint32_t i = 0; i < rtt_num_up_chan + rtt_num_down_chan; i++) {
-					if (rtt_channel_enabled[i]) {
+					if (rtt_channel_enabled[i] && (i < rtt_num_up_chan || !rtt_flag_framed)) {
 						rtt_retval_e result;
 						if (i < rtt_num_up_chan)
 							result = print_rtt(cur_target, i); /* rtt from target to host */
@@ -398,6 +559,16 @@ void poll_rtt(target_s *const cur_target)
 							rtt_err = true;
 					}
 				}
+				if (rtt_flag_framed) {
+					/* frames for all channels share one stream, so flow control is left to read_rtt_framed() */
+					rtt_flag_skip = false;
+					rtt_flag_block = true;
+					const rtt_retval_e result = read_rtt_framed(cur_target);
+					if (result == RTT_OK)
+						rtt_busy = true;
+					else if (result == RTT_ERR)
+						rtt_err = true;
+				}
 			}
 		}
 
@@ -420,12 +591,26 @@ void poll_rtt(target_s *const cur_target)
 			poll_ms = rtt_min_poll_ms;
 
 		if (rtt_err) {
-			gdb_out("rtt: err\r\n");
+			rtt_outf("rtt: err\r\n");
 			poll_errs++;
 			if (rtt_max_poll_errs != 0 && poll_errs > rtt_max_poll_errs) {
-				gdb_out("\r\nrtt lost\r\n");
+				rtt_outf("\r\nrtt lost\r\n");
 				rtt_enabled = false;
+				rtt_stop_reason = "lost";
 			}
 		}
 	}
 }
+
+void poll_rtt(target_s *const cur_target)
+{
+	rtt_poll(cur_target, false);
+}
+
+void poll_rtt_idle(target_s *const cur_target)
+{
+	/* the control block search can take a while, leave it to when the target is next running */
+	if (!rtt_found)
+		return;
+	rtt_poll(cur_target, true);
+}
@@ -728,7 +728,8 @@ adiv5_access_port_s *adiv5_new_ap(adiv5_debug_port_s *dp, uint8_t apsel)
 
 	if (!tmpap.idr) /* IDR Invalid */
 		return NULL;
-	tmpap.csw = adiv5_ap_read(&tmpap, ADIV5_AP_CSW);
+	const uint32_t initial_csw = adiv5_ap_read(&tmpap, ADIV5_AP_CSW);
+	tmpap.csw = initial_csw;
 	// XXX: We might be able to use the type field in ap->idr to determine if the AP supports TrustZone
 	tmpap.csw &= ~(ADIV5_AP_CSW_SIZE_MASK | ADIV5_AP_CSW_ADDRINC_MASK | ADIV5_AP_CSW_MTE | ADIV5_AP_CSW_HNOSEC);
 	tmpap.csw |= ADIV5_AP_CSW_DBGSWENABLE;
@@ -738,6 +739,21 @@ adiv5_access_port_s *adiv5_new_ap(adiv5_debug_port_s *dp, uint8_t apsel)
 		return NULL;
 	}
 
+	/*
+	 * Packed transfers are an optional MEM-AP feature. When not implemented, AddrInc reads back as
+	 * something other than what we wrote, so try selecting it and see if it sticks. Byte-sized
+	 * accesses are optional too, and packing is only useful to us if they stuck as well.
+	 */
+	if (ADIV5_AP_IDR_CLASS(tmpap.idr) == ADIV5_AP_IDR_CLASS_MEM_AP) {
+		adiv5_ap_write(&tmpap, ADIV5_AP_CSW, tmpap.csw | ADIV5_AP_CSW_ADDRINC_PACKED | ADIV5_AP_CSW_SIZE_BYTE);
+		const uint32_t csw = adiv5_ap_read(&tmpap, ADIV5_AP_CSW);
+		if ((csw & ADIV5_AP_CSW_ADDRINC_MASK) == ADIV5_AP_CSW_ADDRINC_PACKED &&
+			(csw & ADIV5_AP_CSW_SIZE_MASK) == ADIV5_AP_CSW_SIZE_BYTE)
+			tmpap.flags |= ADIV5_AP_FLAGS_PACKED_TRANSFERS;
+		/* Put the CSW back how we found it so the probe doesn't leave byte-sized packed accesses selected */
+		adiv5_ap_write(&tmpap, ADIV5_AP_CSW, initial_csw);
+	}
+
 	/* It's valid to so create a heap copy */
 	adiv5_access_port_s *ap = malloc(sizeof(*ap));
 	if (!ap) { /* malloc failed: heap exhaustion */
@@ -752,6 +768,8 @@ adiv5_access_port_s *adiv5_new_ap(adiv5_debug_port_s *dp, uint8_t apsel)
 	uint32_t cfg = adiv5_ap_read(ap, ADIV5_AP_CFG);
 	DEBUG_INFO("AP %3u: IDR=%08" PRIx32 " CFG=%08" PRIx32 " BASE=%08" PRIx32 " CSW=%08" PRIx32, apsel, ap->idr, cfg,
 		ap->base, ap->csw);
+	if (ap->flags & ADIV5_AP_FLAGS_PACKED_TRANSFERS)
+		DEBUG_INFO(" packed");
 	/* Decode the AP designer code */
 	uint16_t designer = ADIV5_AP_IDR_DESIGNER(ap->idr);
 	designer = (designer & ADIV5_DP_DESIGNER_JEP106_CONT_MASK) << 1U | (designer & ADIV5_DP_DESIGNER_JEP106_CODE_MASK);
@@ -1003,10 +1021,14 @@ void adiv5_dp_init(adiv5_debug_port_s *const dp)
 	adiv5_dp_unref(dp);
 }
 
-/* Program the CSW and TAR for sequential access at a given width */
-void ap_mem_access_setup(adiv5_access_port_s *ap, uint32_t addr, align_e align)
+/* Bounds on the number of DRW accesses handed to dp->write_burst() and dp->read_burst() in one go */
+#define ADIV5_BURST_MIN 8U
+#define ADIV5_BURST_MAX 64U
+
+/* Program the CSW and TAR for sequential access at a given width, using the given address increment mode */
+static void ap_mem_access_setup_inc(adiv5_access_port_s *ap, uint32_t addr, align_e align, uint32_t addr_inc)
 {
-	uint32_t csw = ap->csw | ADIV5_AP_CSW_ADDRINC_SINGLE;
+	uint32_t csw = ap->csw | addr_inc;
 
 	switch (align) {
 	case ALIGN_8BIT:
@@ -1024,6 +1046,31 @@ void ap_mem_access_setup(adiv5_access_port_s *ap, uint32_t addr, align_e align)
 	adiv5_dp_low_access(ap->dp, ADIV5_LOW_WRITE, ADIV5_AP_TAR, addr);
 }
 
+/* Program the CSW and TAR for sequential access at a given width */
+void ap_mem_access_setup(adiv5_access_port_s *ap, uint32_t addr, align_e align)
+{
+	ap_mem_access_setup_inc(ap, addr, align, ADIV5_AP_CSW_ADDRINC_SINGLE);
+}
+
+/*
+ * Work out how much of a byte or halfword access can be done using packed transfers. This is the
+ * word-aligned middle of the range, with `head` set to the number of bytes that have to be moved
+ * normally before it. Returns 0 if the AP can't do packed transfers or it isn't worth doing here.
+ */
+size_t adiv5_packed_split(
+	const adiv5_access_port_s *const ap, const uint32_t addr, const size_t len, const align_e align, size_t *const head)
+{
+	if (!(ap->flags & ADIV5_AP_FLAGS_PACKED_TRANSFERS) || align > ALIGN_16BIT)
+		return 0U;
+	const uint32_t body_start = (addr + 3U) & ~3U;
+	const uint32_t body_end = (uint32_t)(addr + len) & ~3U;
+	/* The body has to come to at least two words to win back the cost of reprogramming the CSW and TAR */
+	if (body_end <= body_start || body_end - body_start < 8U)
+		return 0U;
+	*head = body_start - addr;
+	return body_end - body_start;
+}
+
 /* Unpack data from the source uint32_t value based on data alignment and source address */
 void *adiv5_unpack_data(void *const dest, const uint32_t src, const uint32_t data, const align_e align)
 {
@@ -1091,22 +1138,60 @@ const void *adiv5_pack_data(const uint32_t dest, const void *const src, uint32_t
 	return (const uint8_t *)src + (1 << align);
 }
 
-void advi5_mem_read_bytes(adiv5_access_port_s *const ap, void *dest, uint32_t src, size_t len)
+/*
+ * Read a block (with the CSW and TAR already set up) as a series of pipelined bursts. Any burst
+ * the DP reports as not having completed cleanly is redone with normal, checked, reads.
+ */
+static void adiv5_mem_read_burst(
+	adiv5_access_port_s *const ap, void *dest, uint32_t src, size_t count, const align_e step)
+{
+	adiv5_debug_port_s *const dp = ap->dp;
+	uint32_t values[ADIV5_BURST_MAX];
+	while (count) {
+		/* Bursts must not cross the 1KiB boundary TAR auto-increment stops at */
+		const size_t boundary = (0x400U - (src & 0x3ffU)) >> step;
+		const size_t burst = MIN(MIN(count, boundary), ADIV5_BURST_MAX);
+
+		const bool redo = !dp->read_burst(dp, ADIV5_AP_DRW, values, burst);
+		if (redo) {
+			adiv5_dp_low_access(dp, ADIV5_LOW_WRITE, ADIV5_AP_TAR, src);
+			adiv5_dp_low_access(dp, ADIV5_LOW_READ, ADIV5_AP_DRW, 0);
+			for (size_t i = 1; i < burst; ++i)
+				values[i - 1U] = adiv5_dp_low_access(dp, ADIV5_LOW_READ, ADIV5_AP_DRW, 0);
+			values[burst - 1U] = adiv5_dp_low_access(dp, ADIV5_LOW_READ, ADIV5_DP_RDBUFF, 0);
+		}
+		for (size_t i = 0; i < burst; ++i) {
+			dest = adiv5_unpack_data(dest, src, values[i], step);
+			src += 1U << step;
+		}
+		count -= burst;
+		if (count && !(src & 0x3ffU))
+			adiv5_dp_low_access(dp, ADIV5_LOW_WRITE, ADIV5_AP_TAR, src);
+	}
+}
+
+/*
+ * Read a block in a single run of DRW accesses. In packed mode each access moves a whole
+ * word's worth of `align` sized elements, so the block must be word aligned.
+ */
+static void adiv5_mem_read_block(
+	adiv5_access_port_s *const ap, void *dest, uint32_t src, size_t len, const align_e align, const bool packed)
 {
 	uint32_t osrc = src;
-	const align_e align = MIN_ALIGN(src, len);
+	const align_e step = packed ? ALIGN_32BIT : align;
 
-	if (len == 0)
+	len >>= step;
+	ap_mem_access_setup_inc(ap, src, align, packed ? ADIV5_AP_CSW_ADDRINC_PACKED : ADIV5_AP_CSW_ADDRINC_SINGLE);
+	if (ap->dp->read_burst && len >= ADIV5_BURST_MIN) {
+		adiv5_mem_read_burst(ap, dest, src, len, step);
 		return;
-
-	len >>= align;
-	ap_mem_access_setup(ap, src, align);
+	}
 	adiv5_dp_low_access(ap->dp, ADIV5_LOW_READ, ADIV5_AP_DRW, 0);
 	while (--len) {
 		const uint32_t value = adiv5_dp_low_access(ap->dp, ADIV5_LOW_READ, ADIV5_AP_DRW, 0);
-		dest = adiv5_unpack_data(dest, src, value, align);
+		dest = adiv5_unpack_data(dest, src, value, step);
 
-		src += 1U << align;
+		src += 1U << step;
 		/* Check for 10 bit address overflow */
 		if ((src ^ osrc) & 0xfffffc00U) {
 			osrc = src;
@@ -1115,27 +1200,105 @@ void advi5_mem_read_bytes(adiv5_access_port_s *const ap, void *dest, uint32_t sr
 		}
 	}
 	const uint32_t value = adiv5_dp_low_access(ap->dp, ADIV5_LOW_READ, ADIV5_DP_RDBUFF, 0);
-	adiv5_unpack_data(dest, src, value, align);
+	adiv5_unpack_data(dest, src, value, step);
 }
 
-void adiv5_mem_write_bytes(adiv5_access_port_s *ap, uint32_t dest, const void *src, size_t len, align_e align)
+void advi5_mem_read_bytes(adiv5_access_port_s *const ap, void *dest, uint32_t src, size_t len)
+{
+	const align_e align = MIN_ALIGN(src, len);
+
+	if (len == 0)
+		return;
+
+	/* If we can, move the word aligned middle of a narrow access with packed transfers */
+	size_t head = 0U;
+	const size_t body = adiv5_packed_split(ap, src, len, align, &head);
+	if (body) {
+		uint8_t *const data = (uint8_t *)dest;
+		const size_t tail = len - head - body;
+		if (head)
+			adiv5_mem_read_block(ap, data, src, head, align, false);
+		adiv5_mem_read_block(ap, data + head, src + head, body, align, true);
+		if (tail)
+			adiv5_mem_read_block(ap, data + head + body, src + head + body, tail, align, false);
+	} else
+		adiv5_mem_read_block(ap, dest, src, len, align, false);
+}
+
+/*
+ * Write a block (with the CSW and TAR already set up) as a series of streamed bursts. Any burst
+ * the DP reports as having overrun is redone with normal, checked, writes.
+ */
+static void adiv5_mem_write_burst(
+	adiv5_access_port_s *const ap, uint32_t dest, const void *src, size_t count, const align_e step)
+{
+	adiv5_debug_port_s *const dp = ap->dp;
+	uint32_t values[ADIV5_BURST_MAX];
+	while (count) {
+		/* Bursts must not cross the 1KiB boundary TAR auto-increment stops at */
+		const size_t boundary = (0x400U - (dest & 0x3ffU)) >> step;
+		const size_t burst = MIN(MIN(count, boundary), ADIV5_BURST_MAX);
+		uint32_t next = dest;
+		for (size_t i = 0; i < burst; ++i) {
+			src = adiv5_pack_data(next, src, values + i, step);
+			next += 1U << step;
+		}
+
+		const bool redo = !dp->write_burst(dp, ADIV5_AP_DRW, values, burst);
+		if (redo) {
+			adiv5_dp_low_access(dp, ADIV5_LOW_WRITE, ADIV5_AP_TAR, dest);
+			for (size_t i = 0; i < burst; ++i)
+				adiv5_dp_low_access(dp, ADIV5_LOW_WRITE, ADIV5_AP_DRW, values[i]);
+		}
+		dest = next;
+		count -= burst;
+		if (count && !(dest & 0x3ffU))
+			adiv5_dp_low_access(dp, ADIV5_LOW_WRITE, ADIV5_AP_TAR, dest);
+	}
+}
+
+/* Write a block in a single run of DRW accesses, see adiv5_mem_read_block() for what packed means */
+static void adiv5_mem_write_block(
+	adiv5_access_port_s *const ap, uint32_t dest, const void *src, size_t len, const align_e align, const bool packed)
 {
 	uint32_t odest = dest;
+	const align_e step = packed ? ALIGN_32BIT : align;
 
-	len >>= align;
-	ap_mem_access_setup(ap, dest, align);
+	len >>= step;
+	ap_mem_access_setup_inc(ap, dest, align, packed ? ADIV5_AP_CSW_ADDRINC_PACKED : ADIV5_AP_CSW_ADDRINC_SINGLE);
+	if (ap->dp->write_burst && len >= ADIV5_BURST_MIN) {
+		adiv5_mem_write_burst(ap, dest, src, len, step);
+		return;
+	}
 	while (len--) {
 		uint32_t value = 0;
-		src = adiv5_pack_data(dest, src, &value, align);
+		src = adiv5_pack_data(dest, src, &value, step);
 		adiv5_dp_low_access(ap->dp, ADIV5_LOW_WRITE, ADIV5_AP_DRW, value);
 
-		dest += 1U << align;
+		dest += 1U << step;
 		/* Check for 10 bit address overflow */
 		if ((dest ^ odest) & 0xfffffc00U) {
 			odest = dest;
 			adiv5_dp_low_access(ap->dp, ADIV5_LOW_WRITE, ADIV5_AP_TAR, dest);
 		}
 	}
+}
+
+void adiv5_mem_write_bytes(adiv5_access_port_s *ap, uint32_t dest, const void *src, size_t len, align_e align)
+{
+	/* If we can, move the word aligned middle of a narrow access with packed transfers */
+	size_t head = 0U;
+	const size_t body = adiv5_packed_split(ap, dest, len, align, &head);
+	if (body) {
+		const uint8_t *const data = (const uint8_t *)src;
+		const size_t tail = len - head - body;
+		if (head)
+			adiv5_mem_write_block(ap, dest, data, head, align, false);
+		adiv5_mem_write_block(ap, dest + head, data + head, body, align, true);
+		if (tail)
+			adiv5_mem_write_block(ap, dest + head + body, data + head + body, tail, align, false);
+	} else
+		adiv5_mem_write_block(ap, dest, src, len, align, false);
 	/* Make sure this write is complete by doing a dummy read */
 	adiv5_dp_read(ap->dp, ADIV5_DP_RDBUFF);
 }
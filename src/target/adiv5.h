@@ -194,6 +194,11 @@
 #define ADIV5_AP_IDR_TYPE_MASK       0x0000000fU
 #define ADIV5_AP_IDR_TYPE(idr)       ((idr)&ADIV5_AP_IDR_TYPE_MASK)
 
+#define ADIV5_AP_IDR_CLASS_MEM_AP 0x8U
+
+/* AP capability flags */
+#define ADIV5_AP_FLAGS_PACKED_TRANSFERS (1U << 0U)
+
 /* ADIv5 Class 0x1 ROM Table Registers */
 #define ADIV5_ROM_MEMTYPE          0xfccU
 #define ADIV5_ROM_MEMTYPE_SYSMEM   (1U << 0U)
@@ -250,12 +255,21 @@ struct adiv5_debug_port {
 
 	void (*mem_read)(adiv5_access_port_s *ap, void *dest, uint32_t src, size_t len);
 	void (*mem_write)(adiv5_access_port_s *ap, uint32_t dest, const void *src, size_t len, align_e align);
+	/* Optional streamed write of count values to a single register, returns false if it must be redone */
+	bool (*write_burst)(adiv5_debug_port_s *dp, uint16_t addr, const uint32_t *data, size_t count);
+	/* Optional pipelined run of count reads of a single register, returns false if it must be redone */
+	bool (*read_burst)(adiv5_debug_port_s *dp, uint16_t addr, uint32_t *data, size_t count);
+	/* Idle cycles to put between the scans of a JTAG burst, and how many bursts have had to be redone so far */
+	uint8_t burst_idle_cycles;
+	uint8_t burst_redos;
 	uint8_t dev_index;
 	uint8_t fault;
 
 	/* targetsel DPv2 */
 	uint8_t instance;
 	uint32_t targetsel;
+	/* Set only for DPs found by a multi-drop scan over the bit-level SWD transport, which need reselecting */
+	bool multidrop;
 
 	uint8_t version;
 
@@ -279,6 +293,7 @@ struct adiv5_access_port {
 	uint32_t idr;
 	uint32_t base;
 	uint32_t csw;
+	uint8_t flags;
 	uint32_t ap_cortexm_demcr; /* Copy of demcr when starting */
 	uint32_t ap_storage;       /* E.g to hold STM32F7 initial DBGMCU_CR value.*/
 
@@ -289,6 +304,20 @@ struct adiv5_access_port {
 
 uint8_t make_packet_request(uint8_t RnW, uint16_t addr);
 
+/* TARGETSEL value of the multi-drop DP currently selected on the SWD bus, 0 if none */
+extern uint32_t adiv5_swd_selected_targetsel;
+void adiv5_swd_multidrop_select(adiv5_debug_port_s *dp);
+
+/*
+ * On a multi-drop SWD bus, make sure this DP is the one selected before talking to it.
+ * This only costs a line reset and TARGETSEL write when the DP being accessed changes.
+ */
+static inline void adiv5_dp_select(adiv5_debug_port_s *const dp)
+{
+	if (dp->multidrop && dp->targetsel != adiv5_swd_selected_targetsel)
+		adiv5_swd_multidrop_select(dp);
+}
+
 #if PC_HOSTED == 0
 static inline bool adiv5_write_no_check(adiv5_debug_port_s *const dp, uint16_t addr, const uint32_t value)
 {
@@ -302,6 +331,7 @@ static inline uint32_t adiv5_read_no_check(adiv5_debug_port_s *const dp, uint16_
 
 static inline uint32_t adiv5_dp_read(adiv5_debug_port_s *dp, uint16_t addr)
 {
+	adiv5_dp_select(dp);
 	return dp->dp_read(dp, addr);
 }
 
@@ -312,37 +342,44 @@ static inline uint32_t adiv5_dp_error(adiv5_debug_port_s *dp)
 
 static inline uint32_t adiv5_dp_low_access(adiv5_debug_port_s *dp, uint8_t RnW, uint16_t addr, uint32_t value)
 {
+	adiv5_dp_select(dp);
 	return dp->low_access(dp, RnW, addr, value);
 }
 
 static inline void adiv5_dp_abort(adiv5_debug_port_s *dp, uint32_t abort)
 {
+	adiv5_dp_select(dp);
 	dp->abort(dp, abort);
 }
 
 static inline uint32_t adiv5_ap_read(adiv5_access_port_s *ap, uint16_t addr)
 {
+	adiv5_dp_select(ap->dp);
 	return ap->dp->ap_read(ap, addr);
 }
 
 static inline void adiv5_ap_write(adiv5_access_port_s *ap, uint16_t addr, uint32_t value)
 {
+	adiv5_dp_select(ap->dp);
 	ap->dp->ap_write(ap, addr, value);
 }
 
 static inline void adiv5_mem_read(adiv5_access_port_s *ap, void *dest, uint32_t src, size_t len)
 {
+	adiv5_dp_select(ap->dp);
 	ap->dp->mem_read(ap, dest, src, len);
 }
 
 static inline void adiv5_mem_write_sized(
 	adiv5_access_port_s *ap, uint32_t dest, const void *src, size_t len, align_e align)
 {
+	adiv5_dp_select(ap->dp);
 	ap->dp->mem_write(ap, dest, src, len, align);
 }
 
 static inline void adiv5_dp_write(adiv5_debug_port_s *dp, uint16_t addr, uint32_t value)
 {
+	adiv5_dp_select(dp);
 	dp->low_access(dp, ADIV5_LOW_WRITE, addr, value);
 }
 
@@ -395,6 +432,7 @@ void *adiv5_unpack_data(void *dest, uint32_t src, uint32_t val, align_e align);
 const void *adiv5_pack_data(uint32_t dest, const void *src, uint32_t *data, align_e align);
 
 void ap_mem_access_setup(adiv5_access_port_s *ap, uint32_t addr, align_e align);
+size_t adiv5_packed_split(const adiv5_access_port_s *ap, uint32_t addr, size_t len, align_e align, size_t *head);
 void adiv5_mem_write_bytes(adiv5_access_port_s *ap, uint32_t dest, const void *src, size_t len, align_e align);
 void advi5_mem_read_bytes(adiv5_access_port_s *ap, void *dest, uint32_t src, size_t len);
 void firmware_ap_write(adiv5_access_port_s *ap, uint16_t addr, uint32_t value);
@@ -410,6 +448,9 @@ uint32_t adiv5_swd_clear_error(adiv5_debug_port_s *dp, bool protocol_recovery);
 uint32_t adiv5_jtagdp_error(adiv5_debug_port_s *dp, bool protocol_recovery);
 
 void firmware_swdp_abort(adiv5_debug_port_s *dp, uint32_t abort);
+bool firmware_swdp_write_burst(adiv5_debug_port_s *dp, uint16_t addr, const uint32_t *data, size_t count);
+bool fw_adiv5_jtagdp_write_burst(adiv5_debug_port_s *dp, uint16_t addr, const uint32_t *data, size_t count);
+bool fw_adiv5_jtagdp_read_burst(adiv5_debug_port_s *dp, uint16_t addr, uint32_t *data, size_t count);
 void adiv5_jtagdp_abort(adiv5_debug_port_s *dp, uint32_t abort);
 
 void adiv5_swd_multidrop_scan(adiv5_debug_port_s *dp, uint32_t targetid);
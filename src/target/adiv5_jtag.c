@@ -29,9 +29,17 @@
 #include "jtagtap.h"
 #include "morse.h"
 
+#if PC_HOSTED == 1
+#include "freq_profile.h"
+#endif
+
 #define JTAGDP_ACK_OK   0x02U
 #define JTAGDP_ACK_WAIT 0x01U
 
+/* The most idle cycles a burst will put between its scans, and how many redone bursts it takes to give up on them */
+#define JTAGDP_BURST_IDLE_MAX   8U
+#define JTAGDP_BURST_REDO_LIMIT 16U
+
 /* 35-bit registers that control the ADIv5 DP */
 #define IR_ABORT 0x8U
 #define IR_DPACC 0xaU
@@ -54,6 +62,11 @@ void adiv5_jtag_dp_handler(const uint8_t dev_index)
 #if PC_HOSTED == 1
 	bmda_jtag_dp_init(dp);
 #endif
+	/* Pipelined bursts are only possible when we're driving the JTAG scans ourselves */
+	if (dp->low_access == fw_adiv5_jtagdp_low_access) {
+		dp->write_burst = fw_adiv5_jtagdp_write_burst;
+		dp->read_burst = fw_adiv5_jtagdp_read_burst;
+	}
 
 	/* Grab the ID code that was scanned */
 	const uint32_t idcode = jtag_devs[dev_index].jd_idcode;
@@ -95,18 +108,21 @@ uint32_t adiv5_jtagdp_error(adiv5_debug_port_s *dp, const bool protocol_recovery
 	return adiv5_dp_low_access(dp, ADIV5_LOW_WRITE, ADIV5_DP_CTRLSTAT, status) & 0x32U;
 }
 
-uint32_t fw_adiv5_jtagdp_low_access(adiv5_debug_port_s *dp, uint8_t RnW, uint16_t addr, uint32_t value)
+/* Select DPACC or APACC as appropriate for the access and build the 35-bit DR request for it */
+static uint64_t adiv5_jtagdp_request(adiv5_debug_port_s *const dp, const uint8_t RnW, const uint16_t addr,
+	const uint32_t value)
 {
-	const bool APnDP = addr & ADIV5_APnDP;
-	addr &= 0xffU;
+	jtag_dev_write_ir(dp->dev_index, (addr & ADIV5_APnDP) ? IR_APACC : IR_DPACC);
+	return ((uint64_t)value << 3U) | ((addr >> 1U) & 0x06U) | (RnW ? 1U : 0U);
+}
 
-	const uint64_t request = ((uint64_t)value << 3U) | ((addr >> 1U) & 0x06U) | (RnW ? 1U : 0U);
+uint32_t fw_adiv5_jtagdp_low_access(adiv5_debug_port_s *dp, uint8_t RnW, uint16_t addr, uint32_t value)
+{
+	const uint64_t request = adiv5_jtagdp_request(dp, RnW, addr, value);
 
 	uint32_t result;
 	uint8_t ack;
 
-	jtag_dev_write_ir(dp->dev_index, APnDP ? IR_APACC : IR_DPACC);
-
 	platform_timeout_s timeout;
 	platform_timeout_set(&timeout, 250);
 	do {
@@ -125,12 +141,81 @@ uint32_t fw_adiv5_jtagdp_low_access(adiv5_debug_port_s *dp, uint8_t RnW, uint16_
 
 	if (ack != JTAGDP_ACK_OK) {
 		DEBUG_ERROR("JTAG access resulted in: %" PRIx32 ":%x\n", result, ack);
+#if PC_HOSTED == 1
+		freq_profile_note_fault();
+#endif
 		raise_exception(EXCEPTION_ERROR, "JTAG-DP invalid ACK");
 	}
 
 	return result;
 }
 
+/*
+ * Account for a burst that saw WAIT and so has to be redone: give the DP another idle cycle between scans
+ * for the next one, and if bursts keep having to be redone regardless, stop using them for this DP
+ */
+static void fw_adiv5_jtagdp_burst_redo(adiv5_debug_port_s *const dp)
+{
+	if (dp->burst_idle_cycles < JTAGDP_BURST_IDLE_MAX)
+		++dp->burst_idle_cycles;
+	if (++dp->burst_redos == JTAGDP_BURST_REDO_LIMIT)
+		DEBUG_WARN("JTAG bursts keep seeing WAIT, using checked accesses from now on\n");
+}
+
+/*
+ * Stream a run of writes to a single register as back-to-back DR scans, separated only by the DP's burst
+ * idle cycles and without going back through the IR or checking in between. Each scan returns the
+ * ACK for the access before it, and an access that sees WAIT is ignored by the DP, so rather than retrying
+ * each one as it happens, all the ACKs are checked once at the end of the burst - with the final write's
+ * collected by a read of RDBUFF. Returns false if the burst did not complete cleanly and must be redone.
+ */
+bool fw_adiv5_jtagdp_write_burst(
+	adiv5_debug_port_s *const dp, const uint16_t addr, const uint32_t *const data, const size_t count)
+{
+	if (dp->fault || dp->burst_redos >= JTAGDP_BURST_REDO_LIMIT)
+		return false;
+	bool complete = true;
+	for (size_t i = 0; i < count; ++i) {
+		/* Only the first of these actually has to write the IR, jtag_dev_write_ir() skipping the rest */
+		const uint64_t request = adiv5_jtagdp_request(dp, ADIV5_LOW_WRITE, addr, data[i]);
+		uint64_t response = 0;
+		jtag_dev_shift_dr_burst(dp->dev_index, (uint8_t *)&response, (const uint8_t *)&request, 35U, i == 0U,
+			i + 1U == count, dp->burst_idle_cycles);
+		complete &= (response & 0x07U) == JTAGDP_ACK_OK;
+	}
+	fw_adiv5_jtagdp_low_access(dp, ADIV5_LOW_READ, ADIV5_DP_RDBUFF, 0);
+	if (!complete)
+		fw_adiv5_jtagdp_burst_redo(dp);
+	return complete && !dp->fault;
+}
+
+/*
+ * Perform a run of reads of a single register as back-to-back DR scans, each scan carrying
+ * the next request while returning the result of the one before, with the final result collected from
+ * RDBUFF. ACKs are checked once at the end as for fw_adiv5_jtagdp_write_burst().
+ * Returns false if the burst did not complete cleanly and must be redone.
+ */
+bool fw_adiv5_jtagdp_read_burst(
+	adiv5_debug_port_s *const dp, const uint16_t addr, uint32_t *const data, const size_t count)
+{
+	if (dp->fault || dp->burst_redos >= JTAGDP_BURST_REDO_LIMIT)
+		return false;
+	const uint64_t request = adiv5_jtagdp_request(dp, ADIV5_LOW_READ, addr, 0U);
+	bool complete = true;
+	for (size_t i = 0; i < count; ++i) {
+		uint64_t response = 0;
+		jtag_dev_shift_dr_burst(dp->dev_index, (uint8_t *)&response, (const uint8_t *)&request, 35U, i == 0U,
+			i + 1U == count, dp->burst_idle_cycles);
+		complete &= (response & 0x07U) == JTAGDP_ACK_OK;
+		if (i)
+			data[i - 1U] = (uint32_t)(response >> 3U);
+	}
+	data[count - 1U] = fw_adiv5_jtagdp_low_access(dp, ADIV5_LOW_READ, ADIV5_DP_RDBUFF, 0);
+	if (!complete)
+		fw_adiv5_jtagdp_burst_redo(dp);
+	return complete && !dp->fault;
+}
+
 void adiv5_jtagdp_abort(adiv5_debug_port_s *dp, uint32_t abort)
 {
 	uint64_t request = (uint64_t)abort << 3U;
@@ -31,6 +31,10 @@
 #include "target.h"
 #include "target_internal.h"
 
+#if PC_HOSTED == 1
+#include "freq_profile.h"
+#endif
+
 uint8_t make_packet_request(uint8_t RnW, uint16_t addr)
 {
 	bool APnDP = addr & ADIV5_APnDP;
@@ -54,8 +58,12 @@ uint8_t make_packet_request(uint8_t RnW, uint16_t addr)
 
 /* Provide bare DP access functions without timeout and exception */
 
+uint32_t adiv5_swd_selected_targetsel = 0;
+
 static void swd_line_reset_sequence(const bool idle_cycles)
 {
+	/* A line reset leaves no multi-drop DP selected till the next TARGETSEL write */
+	adiv5_swd_selected_targetsel = 0;
 	/*
 	 * A line reset is achieved by holding the SWDIOTMS HIGH for at least 50 SWCLKTCK cycles, followed by at least two idle cycles
 	 * Note: in some non-conformant devices (STM32) at least 51 HIGH cycles and/or 3/4 idle cycles are required
@@ -125,6 +133,20 @@ static void jtag_to_swd_sequence()
 	swd_line_reset_sequence(true);
 }
 
+/*
+ * Switch which DP on a multi-drop bus is selected. Selection is sticky, so this is only done
+ * (via adiv5_dp_select()) when an access is made to a different DP than the last one.
+ */
+void adiv5_swd_multidrop_select(adiv5_debug_port_s *const dp)
+{
+	DEBUG_PROBE("Selecting multi-drop DP with TARGETSEL 0x%08" PRIx32 "\n", dp->targetsel);
+	swd_line_reset_sequence(true);
+	dp->write_no_check(ADIV5_DP_TARGETSEL, dp->targetsel);
+	/* A DPIDR read is required after a line reset before the DP will accept any other access */
+	dp->read_no_check(ADIV5_DP_DPIDR);
+	adiv5_swd_selected_targetsel = dp->targetsel;
+}
+
 bool adiv5_swd_write_no_check(const uint16_t addr, const uint32_t data)
 {
 	const uint8_t request = make_packet_request(ADIV5_LOW_WRITE, addr);
@@ -172,6 +194,10 @@ bool adiv5_swd_scan(const uint32_t targetid)
 	}
 #endif
 
+	/* Streamed writes are only possible when we're driving the SWD sequences ourselves */
+	if (dp->low_access == firmware_swdp_low_access)
+		dp->write_burst = firmware_swdp_write_burst;
+
 	platform_target_clk_output_enable(true);
 
 	/* Switch out of dormant state */
@@ -300,9 +326,9 @@ void adiv5_swd_multidrop_scan(adiv5_debug_port_s *const dp, const uint32_t targe
 		dp->fault = 0;
 
 		/* Select the instance */
-		dp->write_no_check(ADIV5_DP_TARGETSEL,
-			instance << ADIV5_DP_TARGETSEL_TINSTANCE_OFFSET |
-				(targetid & (ADIV5_DP_TARGETID_TDESIGNER_MASK | ADIV5_DP_TARGETID_TPARTNO_MASK)) | 1U);
+		const uint32_t targetsel = instance << ADIV5_DP_TARGETSEL_TINSTANCE_OFFSET |
+			(targetid & (ADIV5_DP_TARGETID_TDESIGNER_MASK | ADIV5_DP_TARGETID_TPARTNO_MASK)) | 1U;
+		dp->write_no_check(ADIV5_DP_TARGETSEL, targetsel);
 
 		/* Read DPIDR */
 		if (adiv5_dp_read_dpidr(dp) == 0)
@@ -319,6 +345,10 @@ void adiv5_swd_multidrop_scan(adiv5_debug_port_s *const dp, const uint32_t targe
 		/* Populate the target DP from the initial one */
 		memcpy(target_dp, dp, sizeof(*dp));
 		target_dp->instance = instance;
+		target_dp->targetsel = targetsel;
+		/* Reselection needs a raw line reset and TARGETSEL write, which only the bit-level transport can do */
+		target_dp->multidrop = dp->write_no_check == adiv5_swd_write_no_check;
+		adiv5_swd_selected_targetsel = targetsel;
 
 		/* Yield the target DP to adiv5_dp_init */
 		adiv5_dp_abort(target_dp, ADIV5_DP_ABORT_STKERRCLR);
@@ -349,8 +379,11 @@ uint32_t adiv5_swd_clear_error(adiv5_debug_port_s *const dp, const bool protocol
 		 * into the expected state.
 		 */
 		swd_line_reset_sequence(true);
-		if (dp->version >= 2U)
+		if (dp->version >= 2U) {
 			adiv5_write_no_check(dp, ADIV5_DP_TARGETSEL, dp->targetsel);
+			if (dp->multidrop)
+				adiv5_swd_selected_targetsel = dp->targetsel;
+		}
 		adiv5_read_no_check(dp, ADIV5_DP_DPIDR);
 		/* Exception here is unexpected, so do not catch */
 	}
@@ -412,12 +445,18 @@ uint32_t firmware_swdp_low_access(adiv5_debug_port_s *dp, const uint8_t RnW, con
 
 	if (ack == SWDP_ACK_NO_RESPONSE) {
 		DEBUG_ERROR("SWD access resulted in no response\n");
+#if PC_HOSTED == 1
+		freq_profile_note_fault();
+#endif
 		dp->fault = ack;
 		return 0;
 	}
 
 	if (ack != SWDP_ACK_OK) {
 		DEBUG_ERROR("SWD access has invalid ack %x\n", ack);
+#if PC_HOSTED == 1
+		freq_profile_note_fault();
+#endif
 		raise_exception(EXCEPTION_ERROR, "SWD invalid ACK");
 	}
 
@@ -425,6 +464,9 @@ uint32_t firmware_swdp_low_access(adiv5_debug_port_s *dp, const uint8_t RnW, con
 		if (swd_proc.seq_in_parity(&response, 32U)) { /* Give up on parity error */
 			dp->fault = 1U;
 			DEBUG_ERROR("SWD access resulted in parity error\n");
+#if PC_HOSTED == 1
+			freq_profile_note_fault();
+#endif
 			raise_exception(EXCEPTION_ERROR, "SWD parity error");
 		}
 	} else {
@@ -447,3 +489,43 @@ void firmware_swdp_abort(adiv5_debug_port_s *dp, uint32_t abort)
 {
 	adiv5_dp_write(dp, ADIV5_DP_ABORT, abort);
 }
+
+/*
+ * Stream a run of writes to a single register with no per-access ACK checking or idle cycles.
+ * Overrun detection is turned on for the duration so the DP latches any WAIT or FAULT into
+ * STICKYORUN (ignoring all further AP accesses), and that gets checked once at the end.
+ * Returns false if the burst did not complete cleanly and must be redone the careful way.
+ */
+bool firmware_swdp_write_burst(
+	adiv5_debug_port_s *const dp, const uint16_t addr, const uint32_t *const data, const size_t count)
+{
+	if (dp->fault)
+		return false;
+	const uint32_t ctrlstat = ADIV5_DP_CTRLSTAT_CSYSPWRUPREQ | ADIV5_DP_CTRLSTAT_CDBGPWRUPREQ;
+	adiv5_dp_write(dp, ADIV5_DP_CTRLSTAT, ctrlstat | ADIV5_DP_CTRLSTAT_ORUNDETECT);
+	if (dp->fault)
+		return false;
+
+	const uint8_t request = make_packet_request(ADIV5_LOW_WRITE, addr);
+	if (swd_proc.seq_write_burst)
+		swd_proc.seq_write_burst(request, data, count);
+	else {
+		for (size_t i = 0; i < count; ++i) {
+			swd_proc.seq_out(request, 8U);
+			swd_proc.seq_in(3U);
+			swd_proc.seq_out_parity(data[i], 32U);
+		}
+	}
+	/* Clock the last write through the DP */
+	swd_proc.seq_out(0, 8U);
+
+	/* CTRL/STAT stays readable with STICKYORUN set, but everything else bar ABORT will FAULT till it's cleared */
+	const uint32_t status = adiv5_dp_read(dp, ADIV5_DP_CTRLSTAT);
+	const bool overrun = status & (ADIV5_DP_CTRLSTAT_STICKYORUN | ADIV5_DP_CTRLSTAT_STICKYERR);
+	if (overrun) {
+		DEBUG_WARN("SWD burst write overran, falling back to checked writes\n");
+		firmware_swdp_abort(dp, ADIV5_DP_ABORT_ORUNERRCLR | ADIV5_DP_ABORT_STKERRCLR);
+	}
+	adiv5_dp_write(dp, ADIV5_DP_CTRLSTAT, ctrlstat);
+	return !overrun && !dp->fault;
+}
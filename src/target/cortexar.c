@@ -50,6 +50,7 @@
 #include "jep106.h"
 #include "cortex.h"
 #include "cortex_internal.h"
+#include "cortexar.h"
 #include "gdb_reg.h"
 #include "gdb_packet.h"
 #include "buffer_utils.h"
@@ -71,6 +72,9 @@ typedef struct cortexar_priv {
 
 	/* Control and status information */
 	uint8_t core_status;
+
+	/* Routines for running debug operations on the core, possibly offloaded to a remote probe */
+	const cortexar_dbg_ops_s *dbg_ops;
 } cortexar_priv_s;
 
 #define CORTEXAR_DBG_IDR   0x000U /* ID register */
@@ -359,70 +363,177 @@ void cortexar_detach(target_s *target);
 
 static const char *cortexar_target_description(target_s *target);
 
-static bool cortexar_run_insn(target_s *const target, const uint32_t insn)
+static inline uint32_t cortexar_dbg_read32(adiv5_access_port_s *const ap, const target_addr_t base, const uint16_t src)
+{
+	uint32_t result = 0;
+	adiv5_mem_read(ap, &result, base + src, sizeof(result));
+	return result;
+}
+
+static inline void cortexar_dbg_write32(
+	adiv5_access_port_s *const ap, const target_addr_t base, const uint16_t dest, const uint32_t value)
+{
+	adiv5_mem_write(ap, base + dest, &value, sizeof(value));
+}
+
+bool cortexar_dbg_run_insn(adiv5_access_port_s *const ap, const target_addr_t base, const uint32_t insn)
 {
 	/* Issue the requested instruction to the core */
-	cortex_dbg_write32(target, CORTEXAR_DBG_ITR, insn);
+	cortexar_dbg_write32(ap, base, CORTEXAR_DBG_ITR, insn);
 	/* Poll for the instruction to complete */
 	uint32_t status = 0;
 	while (!(status & CORTEXAR_DBG_DSCR_INSN_COMPLETE))
-		status = cortex_dbg_read32(target, CORTEXAR_DBG_DSCR);
+		status = cortexar_dbg_read32(ap, base, CORTEXAR_DBG_DSCR);
 	/* If the instruction triggered a synchronous data abort, signal failure having cleared it */
-	if (status & CORTEXAR_DBG_DSCR_SYNC_DATA_ABORT) {
-		cortexar_priv_s *const priv = (cortexar_priv_s *)target->priv;
-		priv->core_status |= CORTEXAR_STATUS_DATA_FAULT;
-		cortex_dbg_write32(target, CORTEXAR_DBG_DRCR, CORTEXAR_DBG_DRCR_CLR_STICKY_EXC);
-	}
+	if (status & CORTEXAR_DBG_DSCR_SYNC_DATA_ABORT)
+		cortexar_dbg_write32(ap, base, CORTEXAR_DBG_DRCR, CORTEXAR_DBG_DRCR_CLR_STICKY_EXC);
 	return !(status & CORTEXAR_DBG_DSCR_SYNC_DATA_ABORT);
 }
 
-static bool cortexar_run_read_insn(target_s *const target, const uint32_t insn, uint32_t *const result)
+bool cortexar_dbg_run_read_insn(
+	adiv5_access_port_s *const ap, const target_addr_t base, const uint32_t insn, uint32_t *const result)
 {
 	/* Issue the requested instruction to the core */
-	cortex_dbg_write32(target, CORTEXAR_DBG_ITR, insn);
+	cortexar_dbg_write32(ap, base, CORTEXAR_DBG_ITR, insn);
 	/* Poll for the instruction to complete and the data to become ready in the DTR */
 	uint32_t status = 0;
 	while ((status & (CORTEXAR_DBG_DSCR_INSN_COMPLETE | CORTEXAR_DBG_DSCR_DTR_READ_READY)) !=
 		(CORTEXAR_DBG_DSCR_INSN_COMPLETE | CORTEXAR_DBG_DSCR_DTR_READ_READY)) {
-		status = cortex_dbg_read32(target, CORTEXAR_DBG_DSCR);
+		status = cortexar_dbg_read32(ap, base, CORTEXAR_DBG_DSCR);
 		/* If the instruction triggered a synchronous data abort, signal failure having cleared it */
 		if (status & CORTEXAR_DBG_DSCR_SYNC_DATA_ABORT) {
-			cortexar_priv_s *const priv = (cortexar_priv_s *)target->priv;
-			priv->core_status |= CORTEXAR_STATUS_DATA_FAULT;
-			cortex_dbg_write32(target, CORTEXAR_DBG_DRCR, CORTEXAR_DBG_DRCR_CLR_STICKY_EXC);
+			cortexar_dbg_write32(ap, base, CORTEXAR_DBG_DRCR, CORTEXAR_DBG_DRCR_CLR_STICKY_EXC);
 			return false;
 		}
 	}
 	/* Read back the DTR to complete the read and signal success */
-	*result = cortex_dbg_read32(target, CORTEXAR_DBG_DTRRX);
+	*result = cortexar_dbg_read32(ap, base, CORTEXAR_DBG_DTRRX);
 	return true;
 }
 
-static bool cortexar_run_write_insn(target_s *const target, const uint32_t insn, const uint32_t data)
+bool cortexar_dbg_run_write_insn(
+	adiv5_access_port_s *const ap, const target_addr_t base, const uint32_t insn, const uint32_t data)
 {
 	/* Set up the data in the DTR for the transaction */
-	cortex_dbg_write32(target, CORTEXAR_DBG_DTRTX, data);
+	cortexar_dbg_write32(ap, base, CORTEXAR_DBG_DTRTX, data);
 	/* Poll for the data to become ready in the DTR */
-	while (!(cortex_dbg_read32(target, CORTEXAR_DBG_DSCR) & CORTEXAR_DBG_DSCR_DTR_WRITE_DONE))
+	while (!(cortexar_dbg_read32(ap, base, CORTEXAR_DBG_DSCR) & CORTEXAR_DBG_DSCR_DTR_WRITE_DONE))
 		continue;
 	/* Issue the requested instruction to the core */
-	cortex_dbg_write32(target, CORTEXAR_DBG_ITR, insn);
+	cortexar_dbg_write32(ap, base, CORTEXAR_DBG_ITR, insn);
 	/* Poll for the instruction to complete and the data to be consumed from the DTR */
 	uint32_t status = 0;
 	while ((status & (CORTEXAR_DBG_DSCR_INSN_COMPLETE | CORTEXAR_DBG_DSCR_DTR_WRITE_DONE)) !=
 		CORTEXAR_DBG_DSCR_INSN_COMPLETE) {
-		status = cortex_dbg_read32(target, CORTEXAR_DBG_DSCR);
+		status = cortexar_dbg_read32(ap, base, CORTEXAR_DBG_DSCR);
 		/* If the instruction triggered a synchronous data abort, signal failure having cleared it */
 		if (status & CORTEXAR_DBG_DSCR_SYNC_DATA_ABORT) {
-			cortexar_priv_s *const priv = (cortexar_priv_s *)target->priv;
-			priv->core_status |= CORTEXAR_STATUS_DATA_FAULT;
-			cortex_dbg_write32(target, CORTEXAR_DBG_DRCR, CORTEXAR_DBG_DRCR_CLR_STICKY_EXC);
+			cortexar_dbg_write32(ap, base, CORTEXAR_DBG_DRCR, CORTEXAR_DBG_DRCR_CLR_STICKY_EXC);
 			return false;
 		}
 	}
 	return true;
 }
 
+/* Read a block of uint32_t's through the DTR. Assumes the address to read data from is already loaded in r0. */
+bool cortexar_dbg_dtr_read(
+	adiv5_access_port_s *const ap, const target_addr_t base, uint32_t *const dest, const size_t count)
+{
+	/* Read each of the uint32_t's checking for failure */
+	for (size_t offset = 0; offset < count; ++offset) {
+		if (!cortexar_dbg_run_read_insn(ap, base, ARM_LDC_R0_POSTINC4_DTRTX_INSN, dest + offset))
+			return false; /* Propagate failure if it happens */
+	}
+	return true; /* Signal success */
+}
+
+/* Write a block of uint32_t's through the DTR. Assumes the address to write data to is already loaded in r0. */
+bool cortexar_dbg_dtr_write(
+	adiv5_access_port_s *const ap, const target_addr_t base, const uint32_t *const src, const size_t count)
+{
+	/* Write each of the uint32_t's checking for failure */
+	for (size_t offset = 0; offset < count; ++offset) {
+		if (!cortexar_dbg_run_write_insn(ap, base, ARM_STC_DTRRX_R0_POSTINC4_INSN, src[offset]))
+			return false; /* Propagate failure if it happens */
+	}
+	return true; /* Signal success */
+}
+
+void cortexar_dbg_core_regs_read(
+	adiv5_access_port_s *const ap, const target_addr_t base, uint32_t *const regs, const size_t count)
+{
+	for (size_t reg = 0U; reg < count && reg < CORTEXAR_DBG_GPR_COUNT; ++reg) {
+		/* Build an issue a core to coprocessor transfer for the register, ignoring DCSR.SDABORT */
+		(void)cortexar_dbg_run_read_insn(ap, base, ARM_MCR_INSN | ENCODE_CP_ACCESS(14, 0, reg, 0, 5, 0), regs + reg);
+	}
+}
+
+void cortexar_dbg_core_regs_write(
+	adiv5_access_port_s *const ap, const target_addr_t base, const uint32_t *const regs, const size_t count)
+{
+	for (size_t reg = 0U; reg < count && reg < CORTEXAR_DBG_GPR_COUNT; ++reg) {
+		/* Build and issue a coprocessor to core transfer for the register and send the new data */
+		(void)cortexar_dbg_run_write_insn(ap, base, ARM_MRC_INSN | ENCODE_CP_ACCESS(14, 0, reg, 0, 5, 0), regs[reg]);
+	}
+}
+
+bool cortexar_dbg_resume(adiv5_access_port_s *const ap, const target_addr_t base, const uint32_t dscr)
+{
+	cortexar_dbg_write32(ap, base, CORTEXAR_DBG_DSCR, dscr);
+	/* Ask to resume the core */
+	cortexar_dbg_write32(
+		ap, base, CORTEXAR_DBG_DRCR, CORTEXAR_DBG_DRCR_CLR_STICKY_EXC | CORTEXAR_DBG_DRCR_RESTART_REQ);
+
+	/* Then poll for when the core actually resumes */
+	platform_timeout_s timeout;
+	platform_timeout_set(&timeout, 250);
+	uint32_t status = CORTEXAR_DBG_DSCR_HALTED;
+	while (!(status & CORTEXAR_DBG_DSCR_RESTARTED) && !platform_timeout_is_expired(&timeout))
+		status = cortexar_dbg_read32(ap, base, CORTEXAR_DBG_DSCR);
+	return status & CORTEXAR_DBG_DSCR_RESTARTED;
+}
+
+static const cortexar_dbg_ops_s cortexar_local_dbg_ops = {
+	.run_insn = cortexar_dbg_run_insn,
+	.run_read_insn = cortexar_dbg_run_read_insn,
+	.run_write_insn = cortexar_dbg_run_write_insn,
+	.dtr_read = cortexar_dbg_dtr_read,
+	.dtr_write = cortexar_dbg_dtr_write,
+	.core_regs_read = cortexar_dbg_core_regs_read,
+	.core_regs_write = cortexar_dbg_core_regs_write,
+	.resume = cortexar_dbg_resume,
+};
+
+static inline bool cortexar_check_data_abort(target_s *const target, const bool result)
+{
+	/* If the operation triggered a synchronous data abort, record that for cortexar_check_error() */
+	if (!result) {
+		cortexar_priv_s *const priv = (cortexar_priv_s *)target->priv;
+		priv->core_status |= CORTEXAR_STATUS_DATA_FAULT;
+	}
+	return result;
+}
+
+static bool cortexar_run_insn(target_s *const target, const uint32_t insn)
+{
+	const cortexar_priv_s *const priv = (cortexar_priv_s *)target->priv;
+	return cortexar_check_data_abort(target, priv->dbg_ops->run_insn(priv->base.ap, priv->base.base_addr, insn));
+}
+
+static bool cortexar_run_read_insn(target_s *const target, const uint32_t insn, uint32_t *const result)
+{
+	const cortexar_priv_s *const priv = (cortexar_priv_s *)target->priv;
+	return cortexar_check_data_abort(
+		target, priv->dbg_ops->run_read_insn(priv->base.ap, priv->base.base_addr, insn, result));
+}
+
+static bool cortexar_run_write_insn(target_s *const target, const uint32_t insn, const uint32_t data)
+{
+	const cortexar_priv_s *const priv = (cortexar_priv_s *)target->priv;
+	return cortexar_check_data_abort(
+		target, priv->dbg_ops->run_write_insn(priv->base.ap, priv->base.base_addr, insn, data));
+}
+
 static inline uint32_t cortexar_core_reg_read(target_s *const target, const uint8_t reg)
 {
 	/* If the register is a GPR and not the program counter, use a "simple" MCR to read */
@@ -444,9 +555,9 @@ static inline uint32_t cortexar_core_reg_read(target_s *const target, const uint
 static void cortexar_core_regs_save(target_s *const target)
 {
 	cortexar_priv_s *const priv = (cortexar_priv_s *)target->priv;
-	/* Save out r0-r15 in that order (r15, aka pc, clobbers r0) */
-	for (size_t i = 0U; i < ARRAY_LENGTH(priv->core_regs.r); ++i)
-		priv->core_regs.r[i] = cortexar_core_reg_read(target, i);
+	/* Save out r0-r14 as a block, then r15 (aka pc) as reading it clobbers r0 */
+	priv->dbg_ops->core_regs_read(priv->base.ap, priv->base.base_addr, priv->core_regs.r, CORTEXAR_DBG_GPR_COUNT);
+	priv->core_regs.r[CORTEX_REG_PC] = cortexar_core_reg_read(target, CORTEX_REG_PC);
 	/* Read CPSR to r0 and retrieve it */
 	cortexar_run_insn(target, ARM_MRS_R0_CPSR_INSN);
 	priv->core_regs.cpsr = cortexar_core_reg_read(target, 0U);
@@ -513,11 +624,9 @@ static void cortexar_core_regs_restore(target_s *const target)
 	/* Fix up the program counter for the mode */
 	if (priv->core_regs.cpsr & CORTEXAR_CPSR_THUMB)
 		priv->core_regs.r[CORTEX_REG_PC] |= 1U;
-	/* Restore r1-15 in that order. Ignore r0 for the moment as it gets clobbered repeatedly */
-	for (size_t i = 1U; i < ARRAY_LENGTH(priv->core_regs.r); ++i)
-		cortexar_core_reg_write(target, i, priv->core_regs.r[i]);
-	/* Now we're done with the rest of the registers, restore r0 */
-	cortexar_core_reg_write(target, 0U, priv->core_regs.r[0U]);
+	/* Restore r15 (aka pc) first as writing it clobbers r0, then restore r0-r14 as a block */
+	cortexar_core_reg_write(target, CORTEX_REG_PC, priv->core_regs.r[CORTEX_REG_PC]);
+	priv->dbg_ops->core_regs_write(priv->base.ap, priv->base.base_addr, priv->core_regs.r, CORTEXAR_DBG_GPR_COUNT);
 }
 
 static void cortexar_float_regs_restore(target_s *const target)
@@ -698,6 +807,13 @@ static target_s *cortexar_probe(
 	target->priv = priv;
 	target->priv_free = cortex_priv_free;
 	priv->base.ap = ap;
+	priv->dbg_ops = &cortexar_local_dbg_ops;
+#if PC_HOSTED == 1
+	/* If the probe can run the debug operations itself, have it do so to save on round trips */
+	const cortexar_dbg_ops_s *const remote_dbg_ops = bmda_cortexar_dbg_ops();
+	if (remote_dbg_ops)
+		priv->dbg_ops = remote_dbg_ops;
+#endif
 	priv->base.base_addr = base_address;
 
 	target->reset = cortexar_reset;
@@ -912,12 +1028,9 @@ static bool cortexar_check_error(target_s *const target)
 /* Fast path for cortexar_mem_read(). Assumes the address to read data from is already loaded in r0. */
 static inline bool cortexr_mem_read_fast(target_s *const target, uint32_t *const dest, const size_t count)
 {
-	/* Read each of the uint32_t's checking for failure */
-	for (size_t offset = 0; offset < count; ++offset) {
-		if (!cortexar_run_read_insn(target, ARM_LDC_R0_POSTINC4_DTRTX_INSN, dest + offset))
-			return false; /* Propagate failure if it happens */
-	}
-	return true; /* Signal success */
+	const cortexar_priv_s *const priv = (cortexar_priv_s *)target->priv;
+	return cortexar_check_data_abort(
+		target, priv->dbg_ops->dtr_read(priv->base.ap, priv->base.base_addr, dest, count));
 }
 
 /* Slow path for cortexar_mem_read(). Trashes r0 and r1. */
@@ -1006,12 +1119,9 @@ static void cortexar_mem_read(target_s *const target, void *const dest, const ta
 /* Fast path for cortexar_mem_write(). Assumes the address to read data from is already loaded in r0. */
 static inline bool cortexr_mem_write_fast(target_s *const target, const uint32_t *const src, const size_t count)
 {
-	/* Read each of the uint32_t's checking for failure */
-	for (size_t offset = 0; offset < count; ++offset) {
-		if (!cortexar_run_write_insn(target, ARM_STC_DTRRX_R0_POSTINC4_INSN, src[offset]))
-			return false; /* Propagate failure if it happens */
-	}
-	return true; /* Signal success */
+	const cortexar_priv_s *const priv = (cortexar_priv_s *)target->priv;
+	return cortexar_check_data_abort(
+		target, priv->dbg_ops->dtr_write(priv->base.ap, priv->base.base_addr, src, count));
 }
 
 /* Slow path for cortexar_mem_write(). Trashes r0 and r1. */
@@ -1309,16 +1419,8 @@ static void cortexar_halt_resume(target_s *const target, const bool step)
 	if (target->target_options & TOPT_FLAVOUR_VIRT_MEM)
 		cortexar_coproc_write(target, CORTEXAR_ICIALLU, 0U);
 
-	cortex_dbg_write32(target, CORTEXAR_DBG_DSCR, dscr & ~CORTEXAR_DBG_DSCR_ITR_ENABLE);
-	/* Ask to resume the core */
-	cortex_dbg_write32(target, CORTEXAR_DBG_DRCR, CORTEXAR_DBG_DRCR_CLR_STICKY_EXC | CORTEXAR_DBG_DRCR_RESTART_REQ);
-
-	/* Then poll for when the core actually resumes */
-	platform_timeout_s timeout;
-	platform_timeout_set(&timeout, 250);
-	uint32_t status = CORTEXAR_DBG_DSCR_HALTED;
-	while (!(status & CORTEXAR_DBG_DSCR_RESTARTED) && !platform_timeout_is_expired(&timeout))
-		status = cortex_dbg_read32(target, CORTEXAR_DBG_DSCR);
+	/* Disable ITR again, ask to resume the core and then wait for it to actually resume */
+	priv->dbg_ops->resume(priv->base.ap, priv->base.base_addr, dscr & ~CORTEXAR_DBG_DSCR_ITR_ENABLE);
 }
 
 static void cortexar_config_breakpoint(
@@ -0,0 +1,74 @@
+/*
+ * This file is part of the Black Magic Debug project.
+ *
+ * Copyright (C) 2023 1BitSquared <info@1bitsquared.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TARGET_CORTEXAR_H
+#define TARGET_CORTEXAR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "adiv5.h"
+
+/*
+ * Complete debug operations against the debug unit of a Cortex-A/R core at `base` behind `ap`.
+ * The instruction routines return false if the instruction triggered a synchronous data abort (which is
+ * then cleared), the DTR block routines drive the core's r0 as a post-incrementing address and the
+ * register bank routines transfer r0 through r(count - 1).
+ */
+typedef struct cortexar_dbg_ops {
+	bool (*run_insn)(adiv5_access_port_s *ap, target_addr_t base, uint32_t insn);
+	bool (*run_read_insn)(adiv5_access_port_s *ap, target_addr_t base, uint32_t insn, uint32_t *result);
+	bool (*run_write_insn)(adiv5_access_port_s *ap, target_addr_t base, uint32_t insn, uint32_t data);
+	bool (*dtr_read)(adiv5_access_port_s *ap, target_addr_t base, uint32_t *dest, size_t count);
+	bool (*dtr_write)(adiv5_access_port_s *ap, target_addr_t base, const uint32_t *src, size_t count);
+	void (*core_regs_read)(adiv5_access_port_s *ap, target_addr_t base, uint32_t *regs, size_t count);
+	void (*core_regs_write)(adiv5_access_port_s *ap, target_addr_t base, const uint32_t *regs, size_t count);
+	bool (*resume)(adiv5_access_port_s *ap, target_addr_t base, uint32_t dscr);
+} cortexar_dbg_ops_s;
+
+/* The number of general purpose registers the register bank routines can transfer (r0-r14) */
+#define CORTEXAR_DBG_GPR_COUNT 15U
+
+bool cortexar_dbg_run_insn(adiv5_access_port_s *ap, target_addr_t base, uint32_t insn);
+bool cortexar_dbg_run_read_insn(adiv5_access_port_s *ap, target_addr_t base, uint32_t insn, uint32_t *result);
+bool cortexar_dbg_run_write_insn(adiv5_access_port_s *ap, target_addr_t base, uint32_t insn, uint32_t data);
+bool cortexar_dbg_dtr_read(adiv5_access_port_s *ap, target_addr_t base, uint32_t *dest, size_t count);
+bool cortexar_dbg_dtr_write(adiv5_access_port_s *ap, target_addr_t base, const uint32_t *src, size_t count);
+void cortexar_dbg_core_regs_read(adiv5_access_port_s *ap, target_addr_t base, uint32_t *regs, size_t count);
+void cortexar_dbg_core_regs_write(adiv5_access_port_s *ap, target_addr_t base, const uint32_t *regs, size_t count);
+bool cortexar_dbg_resume(adiv5_access_port_s *ap, target_addr_t base, uint32_t dscr);
+
+#if PC_HOSTED == 1
+const cortexar_dbg_ops_s *bmda_cortexar_dbg_ops(void);
+#endif
+
+#endif /*TARGET_CORTEXAR_H*/
@@ -1257,6 +1257,15 @@ bool cortexm_run_stub(target_s *target, uint32_t loadaddr, uint32_t r0, uint32_t
 	return bkpt_instr & 0xffU;
 }
 
+/* Check that the target is a Cortex-M with Thumb-2 (ARMv7-M or ARMv8-M Mainline) that can run the generic stubs */
+bool cortexm_can_run_thumb2_stub(const target_s *const target)
+{
+	if (target->halt_resume != cortexm_halt_resume)
+		return false;
+	const uint32_t partno = target->cpuid & CORTEX_CPUID_PARTNO_MASK;
+	return partno != CORTEX_M0 && partno != CORTEX_M0P && partno != CORTEX_M23;
+}
+
 /*
  * The following routines implement hardware breakpoints and watchpoints.
  * The Flash Patch and Breakpoint (FPB) and Data Watch and Trace (DWT)
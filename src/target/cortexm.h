@@ -32,6 +32,7 @@ extern unsigned cortexm_wait_timeout;
 
 #define CORTEXM_CPUID (CORTEXM_SCS_BASE + 0xd00U)
 #define CORTEXM_AIRCR (CORTEXM_SCS_BASE + 0xd0cU)
+#define CORTEXM_CCR   (CORTEXM_SCS_BASE + 0xd14U)
 #define CORTEXM_CFSR  (CORTEXM_SCS_BASE + 0xd28U)
 #define CORTEXM_HFSR  (CORTEXM_SCS_BASE + 0xd2cU)
 #define CORTEXM_DFSR  (CORTEXM_SCS_BASE + 0xd30U)
@@ -47,6 +48,10 @@ extern unsigned cortexm_wait_timeout;
 #define CORTEXM_CCSIDR (CORTEXM_SCS_BASE + 0xd80U)
 #define CORTEXM_CSSELR (CORTEXM_SCS_BASE + 0xd84U)
 
+/* Configuration and Control Register (CCR) - cache enables, ARMv7-M with caches only */
+#define CORTEXM_CCR_DC (1U << 16U)
+#define CORTEXM_CCR_IC (1U << 17U)
+
 /* Cache maintenance operations */
 #define CORTEXM_ICIALLU  (CORTEXM_SCS_BASE + 0xf50U)
 #define CORTEXM_DCCMVAC  (CORTEXM_SCS_BASE + 0xf68U)
@@ -170,6 +175,7 @@ bool cortexm_attach(target_s *target);
 void cortexm_detach(target_s *target);
 void cortexm_halt_resume(target_s *target, bool step);
 bool cortexm_run_stub(target_s *target, uint32_t loadaddr, uint32_t r0, uint32_t r1, uint32_t r2, uint32_t r3);
+bool cortexm_can_run_thumb2_stub(const target_s *target);
 int cortexm_mem_write_sized(target_s *target, target_addr_t dest, const void *src, size_t len, align_e align);
 
 #endif /* TARGET_CORTEXM_H */
@@ -0,0 +1,64 @@
+/*
+ * This file is part of the Black Magic Debug project.
+ *
+ * Copyright (C) 2023 1BitSquared <info@1bitsquared.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * GD32VF1 Flash write stub - programs a2 bytes from a0 (in SRAM) to a1 (in Flash) a halfword at a time
+ * through the FMC at a3, which must already be unlocked with PG set. Returns the FMC error flags in a0,
+ * so 0 on success. a2 must be a multiple of 2.
+ */
+
+	.option norvc
+
+	.equ FMC_STAT, 0x0c
+	.equ FMC_STAT_BUSY, 0x01
+	.equ FMC_STAT_ERROR_MASK, 0x14
+
+	.global gd32vf1_flash_write
+gd32vf1_flash_write:
+	add a2, a0, a2
+	li t1, 0
+loop:
+	bgeu a0, a2, done
+	lhu t0, 0(a0)
+	sh t0, 0(a1)
+wait:
+	lw t1, FMC_STAT(a3)
+	andi t2, t1, FMC_STAT_BUSY
+	bnez t2, wait
+	andi t1, t1, FMC_STAT_ERROR_MASK
+	bnez t1, done
+	addi a0, a0, 2
+	addi a1, a1, 2
+	j loop
+done:
+	mv a0, t1
+	ret
@@ -0,0 +1,188 @@
+/*
+ * This file is part of the Black Magic Debug project.
+ *
+ * Copyright (C) 2023 1BitSquared <info@1bitsquared.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * LPC43x0 SPI Flash agent - runs one complete SPI Flash transaction described
+ * by the mailbox pointed to by r0, over either the SPIFI controller or SSP0.
+ * The mailbox layout must match lpc43x0_spi_mailbox_s in lpc43xx.c.
+ */
+
+	.syntax unified
+	.thumb
+
+	.equ MAILBOX_INTERFACE, 0x00
+	.equ MAILBOX_FLAGS, 0x04
+	.equ MAILBOX_HEADER_LEN, 0x08
+	.equ MAILBOX_LENGTH, 0x0c
+	.equ MAILBOX_COMMAND, 0x10
+	.equ MAILBOX_ADDRESS, 0x14
+	.equ MAILBOX_HEADER, 0x18
+	.equ MAILBOX_DATA, 0x24
+
+	.equ FLAG_DATA_OUT, 0x01
+	.equ FLAG_POLL_BUSY, 0x02
+
+	.equ SPIFI_BASE, 0x40003000
+	.equ SPIFI_CMD, 0x04
+	.equ SPIFI_ADDR, 0x08
+	.equ SPIFI_DATA, 0x14
+	.equ SPIFI_STAT, 0x1c
+	.equ SPIFI_STAT_CMD_ACTIVE, 0x02
+	.equ SPIFI_STAT_INTRQ, 0x20
+	/* Serial, opcode-only frame, 1 byte data in, opcode 0x05 (read status) */
+	.equ SPIFI_CMD_READ_STATUS, 0x05200001
+
+	.equ SSP0_BASE, 0x40083000
+	.equ SSP0_DR, 0x08
+	.equ SSP0_SR, 0x0c
+	.equ SSP0_SR_BSY, 0x10
+
+	.equ GPIO_PORT0_SET, 0x400f6200
+	.equ GPIO_PORT0_CLR_OFFSET, 0x80
+	.equ SSP0_CS, 0x40
+
+	.equ SPI_OPCODE_READ_STATUS, 0x05
+	.equ SPI_STATUS_BUSY, 0x01
+
+	.global lpc43x0_spi_agent
+	.thumb_func
+lpc43x0_spi_agent:
+	ldr r1, [r0, #MAILBOX_LENGTH]
+	ldr r2, [r0, #MAILBOX_FLAGS]
+	add r3, r0, #MAILBOX_DATA
+	ldr r4, [r0, #MAILBOX_INTERFACE]
+	cbnz r4, spifi
+
+	/* SSP0: select the Flash and clock out the opcode, address and dummy bytes */
+	ldr r5, =SSP0_BASE
+	ldr r6, =GPIO_PORT0_SET
+	movs r7, #SSP0_CS
+	str r7, [r6]
+	ldr r4, [r0, #MAILBOX_HEADER_LEN]
+	add r12, r0, #MAILBOX_HEADER
+ssp0_header:
+	cbz r4, ssp0_data
+	ldrb r7, [r12], #1
+	bl ssp0_transfer
+	subs r4, #1
+	b ssp0_header
+ssp0_data:
+	cbz r1, ssp0_deselect
+	movs r7, #0
+	tst r2, #FLAG_DATA_OUT
+	it ne
+	ldrbne r7, [r3]
+	bl ssp0_transfer
+	tst r2, #FLAG_DATA_OUT
+	it eq
+	strbeq r7, [r3]
+	adds r3, #1
+	subs r1, #1
+	b ssp0_data
+ssp0_deselect:
+	movs r7, #SSP0_CS
+	str r7, [r6, #GPIO_PORT0_CLR_OFFSET]
+	tst r2, #FLAG_POLL_BUSY
+	beq done
+ssp0_poll:
+	movs r4, #SSP0_CS
+	str r4, [r6]
+	movs r7, #SPI_OPCODE_READ_STATUS
+	bl ssp0_transfer
+	movs r7, #0
+	bl ssp0_transfer
+	str r4, [r6, #GPIO_PORT0_CLR_OFFSET]
+	tst r7, #SPI_STATUS_BUSY
+	bne ssp0_poll
+	b done
+
+	/* SPIFI: program the address and command, then move the data through the data register */
+spifi:
+	ldr r5, =SPIFI_BASE
+	ldr r4, [r0, #MAILBOX_ADDRESS]
+	str r4, [r5, #SPIFI_ADDR]
+	ldr r4, [r0, #MAILBOX_COMMAND]
+	str r4, [r5, #SPIFI_CMD]
+	tst r2, #FLAG_DATA_OUT
+	beq spifi_read
+spifi_write:
+	cbz r1, spifi_complete
+	ldrb r7, [r3], #1
+	strb r7, [r5, #SPIFI_DATA]
+	subs r1, #1
+	b spifi_write
+spifi_read:
+	cbz r1, spifi_complete
+	ldrb r7, [r5, #SPIFI_DATA]
+	strb r7, [r3], #1
+	subs r1, #1
+	b spifi_read
+spifi_complete:
+	bl spifi_wait_complete
+	tst r2, #FLAG_POLL_BUSY
+	beq done
+spifi_poll:
+	ldr r4, =SPIFI_CMD_READ_STATUS
+	str r4, [r5, #SPIFI_CMD]
+	ldrb r7, [r5, #SPIFI_DATA]
+	bl spifi_wait_complete
+	tst r7, #SPI_STATUS_BUSY
+	bne spifi_poll
+
+	/* Signal completion with a non-zero breakpoint so it can be told apart from the stub failing to run */
+done:
+	bkpt #1
+
+	/* Exchange the byte in r7 with the Flash over SSP0 (r5 holds the SSP0 base) */
+	.thumb_func
+ssp0_transfer:
+	str r7, [r5, #SSP0_DR]
+1:
+	ldr r8, [r5, #SSP0_SR]
+	tst r8, #SSP0_SR_BSY
+	bne 1b
+	ldr r7, [r5, #SSP0_DR]
+	uxtb r7, r7
+	bx lr
+
+	/* Wait for the SPIFI command in flight to finish (r5 holds the SPIFI base) */
+	.thumb_func
+spifi_wait_complete:
+	ldr r8, [r5, #SPIFI_STAT]
+	tst r8, #SPIFI_STAT_CMD_ACTIVE
+	bne spifi_wait_complete
+	mov r8, #SPIFI_STAT_INTRQ
+	str r8, [r5, #SPIFI_STAT]
+	bx lr
+
+	.align 2
+	.ltorg
@@ -0,0 +1,102 @@
+/*
+ * This file is part of the Black Magic Debug project.
+ *
+ * Copyright (C) 2023 1BitSquared <info@1bitsquared.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Memory expander - decodes the stream from r0 to r1 into memory starting at r2.
+ * The stream is a sequence of tokens, as produced by mem_codec.c:
+ *   0x00-0x7f: literal, (token + 1) bytes follow to be copied as-is
+ *   0x80-0xbf: match, copy ((token & 0x3f) + 3) bytes from a 16-bit little endian
+ *              distance back in the output that follows
+ *   0xc0-0xff: word fill, ((token & 0x3f) << 16 | next 16 bits LE) + 1 copies of the
+ *              32-bit little endian word that follows, to a word aligned output
+ */
+
+	.syntax unified
+	.thumb
+
+	.global mem_expand
+	.thumb_func
+mem_expand:
+next:
+	cmp r0, r1
+	bhs done
+	ldrb r3, [r0], #1
+	cmp r3, #0x80
+	blo literal
+	cmp r3, #0xc0
+	bhs fill
+
+	and r3, r3, #0x3f
+	adds r3, #3
+	ldrb r4, [r0], #1
+	ldrb r5, [r0], #1
+	orr r4, r4, r5, lsl #8
+	sub r4, r2, r4
+1:
+	ldrb r5, [r4], #1
+	strb r5, [r2], #1
+	subs r3, #1
+	bne 1b
+	b next
+
+literal:
+	adds r3, #1
+1:
+	ldrb r4, [r0], #1
+	strb r4, [r2], #1
+	subs r3, #1
+	bne 1b
+	b next
+
+fill:
+	and r3, r3, #0x3f
+	ldrb r4, [r0], #1
+	ldrb r5, [r0], #1
+	orr r4, r4, r5, lsl #8
+	orr r3, r4, r3, lsl #16
+	adds r3, #1
+	ldrb r4, [r0], #1
+	ldrb r5, [r0], #1
+	orr r4, r4, r5, lsl #8
+	ldrb r5, [r0], #1
+	orr r4, r4, r5, lsl #16
+	ldrb r5, [r0], #1
+	orr r4, r4, r5, lsl #24
+1:
+	str r4, [r2], #4
+	subs r3, #1
+	bne 1b
+	b next
+
+	/* Signal completion with a non-zero breakpoint so it can be told apart from the stub failing to run */
+done:
+	bkpt #1
@@ -0,0 +1,229 @@
+/*
+ * This file is part of the Black Magic Debug project.
+ *
+ * Copyright (C) 2023 1BitSquared <info@1bitsquared.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Memory test and fill engine - runs one memory test operation over a word
+ * aligned region as described by the parameter block pointed to by r0. The
+ * parameter block layout must match memtest_params_s in memtest.c.
+ *
+ * Failures are counted in the parameter block and the first max_failures of
+ * them recorded as (address, expected, actual) triplets after it.
+ */
+
+	.syntax unified
+	.thumb
+
+	.equ PARAMS_OP, 0x00
+	.equ PARAMS_START, 0x04
+	.equ PARAMS_LENGTH, 0x08
+	.equ PARAMS_PATTERN, 0x0c
+	.equ PARAMS_FAILURES, 0x10
+	.equ PARAMS_MAX_FAILURES, 0x14
+	.equ PARAMS_FAILURE_LIST, 0x18
+
+	.equ OP_FILL, 0
+	.equ OP_WALKING_ONES, 1
+	.equ OP_ADDRESS_LINES, 2
+	.equ OP_MARCH_C, 3
+	.equ OP_PATTERN, 4
+
+	/* r1 = address, r2 = expected, r3 = actual are used when reporting failures */
+
+	/* Read every word from start to end checking it against expect, then write value to it */
+	.macro march_up expect, value
+	mov r1, r8
+1:
+	ldr r3, [r1]
+	cmp r3, \expect
+	itt ne
+	movne r2, \expect
+	blne record_failure
+	str \value, [r1], #4
+	cmp r1, r9
+	blo 1b
+	.endm
+
+	/* As march_up, but from end down to start */
+	.macro march_down expect, value
+	mov r1, r9
+1:
+	ldr r3, [r1, #-4]!
+	cmp r3, \expect
+	itt ne
+	movne r2, \expect
+	blne record_failure
+	str \value, [r1]
+	cmp r1, r8
+	bhi 1b
+	.endm
+
+	.global memtest
+	.thumb_func
+memtest:
+	ldr r8, [r0, #PARAMS_START]
+	ldr r7, [r0, #PARAMS_LENGTH]
+	add r9, r8, r7
+	ldr r10, [r0, #PARAMS_PATTERN]
+	mvn r5, r10
+	ldr r4, [r0, #PARAMS_OP]
+	cmp r4, #OP_WALKING_ONES
+	beq walking_ones
+	cmp r4, #OP_ADDRESS_LINES
+	beq address_lines
+	cmp r4, #OP_MARCH_C
+	beq march_c
+
+	/* Fill (and for the pattern test, verify) the region with the pattern */
+fill:
+	mov r1, r8
+1:
+	str r10, [r1], #4
+	cmp r1, r9
+	blo 1b
+	cmp r4, #OP_PATTERN
+	bne done
+verify:
+	mov r1, r8
+1:
+	ldr r3, [r1]
+	cmp r3, r10
+	itt ne
+	movne r2, r10
+	blne record_failure
+	adds r1, #4
+	cmp r1, r9
+	blo 1b
+	b done
+
+	/* Walk a 1 through each bit of the first word to check the data lines */
+walking_ones:
+	movs r4, #1
+1:
+	str r4, [r8]
+	ldr r3, [r8]
+	cmp r3, r4
+	ittt ne
+	movne r1, r8
+	movne r2, r4
+	blne record_failure
+	lsls r4, #1
+	bne 1b
+	b done
+
+	/* Check each power-of-two offset for address lines stuck high, low or shorted together */
+address_lines:
+	movs r6, #4
+1:
+	cmp r6, r7
+	bhs 2f
+	str r10, [r8, r6]
+	lsls r6, #1
+	b 1b
+2:
+	str r5, [r8]
+	movs r6, #4
+3:
+	cmp r6, r7
+	bhs 4f
+	ldr r3, [r8, r6]
+	cmp r3, r10
+	ittt ne
+	addne r1, r8, r6
+	movne r2, r10
+	blne record_failure
+	lsls r6, #1
+	b 3b
+4:
+	str r10, [r8]
+	movs r6, #4
+5:
+	cmp r6, r7
+	bhs done
+	str r5, [r8, r6]
+	ldr r3, [r8]
+	cmp r3, r10
+	ittt ne
+	movne r1, r8
+	movne r2, r10
+	blne record_failure
+	movs r4, #4
+6:
+	cmp r4, r7
+	bhs 7f
+	cmp r4, r6
+	beq 8f
+	ldr r3, [r8, r4]
+	cmp r3, r10
+	ittt ne
+	addne r1, r8, r4
+	movne r2, r10
+	blne record_failure
+8:
+	lsls r4, #1
+	b 6b
+7:
+	str r10, [r8, r6]
+	lsls r6, #1
+	b 5b
+
+	/* March C-: up(w0); up(r0, w1); up(r1, w0); down(r0, w1); down(r1, w0); up(r0) with 0 being the pattern */
+march_c:
+	mov r1, r8
+1:
+	str r10, [r1], #4
+	cmp r1, r9
+	blo 1b
+	march_up r10, r5
+	march_up r5, r10
+	march_down r10, r5
+	march_down r5, r10
+	b verify
+
+	/* Signal completion with a non-zero breakpoint so it can be told apart from the stub failing to run */
+done:
+	bkpt #1
+
+	/* Count a failure and record it if there's still room in the list */
+	.thumb_func
+record_failure:
+	ldr r12, [r0, #PARAMS_FAILURES]
+	ldr r11, [r0, #PARAMS_MAX_FAILURES]
+	cmp r12, r11
+	bhs 1f
+	add r11, r12, r12, lsl #1
+	add r11, r0, r11, lsl #2
+	add r11, #PARAMS_FAILURE_LIST
+	stm r11, {r1-r3}
+1:
+	add r12, #1
+	str r12, [r0, #PARAMS_FAILURES]
+	bx lr
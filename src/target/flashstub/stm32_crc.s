@@ -0,0 +1,59 @@
+/*
+ * This file is part of the Black Magic Debug project.
+ *
+ * Copyright (C) 2023 1BitSquared <info@1bitsquared.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * STM32 CRC unit feeder - pushes r1 words starting at r0 through the CRC unit at r2 and returns the
+ * result in r0. Words are byte-swapped on the way in so the result matches GDB's qCRC, which processes
+ * memory a byte at a time, most significant bit first. Only uses ARMv6-M instructions so it runs on
+ * the Cortex-M0/M0+ parts too. r1 must be non-zero.
+ */
+
+	.syntax unified
+	.thumb
+
+	.equ CRC_DR, 0x00
+	.equ CRC_CR, 0x08
+	.equ CRC_CR_RESET, 0x01
+
+	.global stm32_crc
+	.thumb_func
+stm32_crc:
+	movs r3, #CRC_CR_RESET
+	str r3, [r2, #CRC_CR]
+loop:
+	ldm r0!, {r3}
+	rev r3, r3
+	str r3, [r2, #CRC_DR]
+	subs r1, #1
+	bne loop
+	ldr r0, [r2, #CRC_DR]
+	bkpt #1
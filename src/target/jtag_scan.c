@@ -334,9 +334,24 @@ void jtag_dev_write_ir(const uint8_t dev_index, const uint32_t ir)
 }
 
 void jtag_dev_shift_dr(const uint8_t dev_index, uint8_t *data_out, const uint8_t *data_in, const size_t clock_cycles)
+{
+	jtag_dev_shift_dr_burst(dev_index, data_out, data_in, clock_cycles, true, true, 0U);
+}
+
+/*
+ * Perform one DR scan of a back-to-back run. The first scan of the run enters Shift-DR from Run-Test/Idle,
+ * and the rest go round from the previous scan's Exit1-DR via Update-DR, spending idle_cycles in Run-Test/Idle
+ * on the way for devices that need time between accesses (none makes the run one continuous Shift-DR sequence).
+ * Only the last scan of the run returns the TAP to Run-Test/Idle.
+ */
+void jtag_dev_shift_dr_burst(const uint8_t dev_index, uint8_t *data_out, const uint8_t *data_in,
+	const size_t clock_cycles, const bool first, const bool last, const uint8_t idle_cycles)
 {
 	jtag_dev_s *device = &jtag_devs[dev_index];
-	jtagtap_shift_dr();
+	if (first)
+		jtagtap_shift_dr();
+	else
+		jtagtap_next_shift_dr(idle_cycles);
 	jtag_proc.jtagtap_tdi_seq(false, ones, device->dr_prescan);
 	if (data_out)
 		jtag_proc.jtagtap_tdi_tdo_seq(
@@ -344,5 +359,6 @@ void jtag_dev_shift_dr(const uint8_t dev_index, uint8_t *data_out, const uint8_t
 	else
 		jtag_proc.jtagtap_tdi_seq(!device->dr_postscan, (const uint8_t *)data_in, clock_cycles);
 	jtag_proc.jtagtap_tdi_seq(true, ones, device->dr_postscan);
-	jtagtap_return_idle(1);
+	if (last)
+		jtagtap_return_idle(1);
 }
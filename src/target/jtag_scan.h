@@ -48,6 +48,8 @@ extern const uint8_t ones[8];
 
 void jtag_dev_write_ir(uint8_t jd_index, uint32_t ir);
 void jtag_dev_shift_dr(uint8_t jd_index, uint8_t *dout, const uint8_t *din, size_t ticks);
+void jtag_dev_shift_dr_burst(
+	uint8_t jd_index, uint8_t *dout, const uint8_t *din, size_t ticks, bool first, bool last, uint8_t idle_cycles);
 void jtag_add_device(uint32_t dev_index, const jtag_dev_s *jtag_dev);
 
 #endif /* TARGET_JTAG_SCAN_H */
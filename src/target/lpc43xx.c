@@ -217,6 +217,20 @@
 #define SPI43x0_SSP_SR_RNE 0x00000004U
 #define SPI43x0_SSP_SR_BSY 0x00000010U
 
+/*
+ * The SPI Flash agent and its mailbox live at the bottom of local SRAM2, which all parts have.
+ * Transfers smaller than the minimum length are cheaper done directly over the debug link than by running the agent.
+ */
+#define LPC43x0_SPI_AGENT_BASE        LPC43xx_LOCAL_SRAM2_BASE
+#define LPC43x0_SPI_AGENT_MAILBOX     ALIGN(LPC43x0_SPI_AGENT_BASE + sizeof(lpc43x0_spi_agent), 4U)
+#define LPC43x0_SPI_AGENT_BUFFER_SIZE 4096U
+#define LPC43x0_SPI_AGENT_MIN_LENGTH  8U
+
+#define LPC43x0_SPI_AGENT_INTERFACE_SSP0  0U
+#define LPC43x0_SPI_AGENT_INTERFACE_SPIFI 1U
+#define LPC43x0_SPI_AGENT_FLAG_DATA_OUT   (1U << 0U)
+#define LPC43x0_SPI_AGENT_FLAG_POLL_BUSY  (1U << 1U)
+
 #define LPC43xx_GPIO_BASE      0x400f4000U
 #define LPC43xx_GPIO_PORT0_DIR (LPC43xx_GPIO_BASE + 0x2000U)
 #define LPC43xx_GPIO_PORT1_DIR (LPC43xx_GPIO_BASE + 0x2004U)
@@ -254,9 +268,22 @@ typedef struct lpc43xx_priv {
 	uint32_t shadow_map;
 } lpc43xx_priv_s;
 
+/* This must match the mailbox layout used by flashstub/lpc43x0_spi.s */
+typedef struct lpc43x0_spi_mailbox {
+	uint32_t interface;
+	uint32_t flags;
+	uint32_t header_length;
+	uint32_t length;
+	uint32_t spifi_command;
+	uint32_t address;
+	uint8_t header[12];
+} lpc43x0_spi_mailbox_s;
+
 typedef struct lpc43x0_priv {
 	lpc43xx_spi_flash_s *flash;
 	lpc43x0_flash_interface_e interface;
+	bool agent_loaded;
+	uint32_t agent_saved_regs[CORTEXM_GENERAL_REG_COUNT + CORTEX_FLOAT_REG_COUNT];
 	uint32_t boot_address;
 	uint32_t spifi_memory_command;
 	uint32_t bank3_pin3_config;
@@ -276,6 +303,7 @@ static void lpc43x0_detach(target_s *target);
 static bool lpc43x0_enter_flash_mode(target_s *t);
 static bool lpc43x0_exit_flash_mode(target_s *t);
 static void lpc43x0_spi_abort(target_s *t);
+static void lpc43x0_spi_agent_load(target_s *t);
 static void lpc43x0_spi_read(target_s *target, uint16_t command, target_addr_t address, void *buffer, size_t length);
 static void lpc43x0_spi_write(
 	target_s *target, uint16_t command, target_addr_t address, const void *buffer, size_t length);
@@ -295,6 +323,10 @@ const command_s lpc43xx_cmd_list[] = {
 	{NULL, NULL, NULL},
 };
 
+static const uint16_t lpc43x0_spi_agent[] = {
+#include "flashstub/lpc43x0_spi.stub"
+};
+
 static void lpc43xx_add_iap_flash(target_s *target, uint32_t iap_entry, uint8_t bank, uint8_t base_sector,
 	uint32_t addr, size_t len, size_t erasesize)
 {
@@ -696,6 +728,7 @@ static bool lpc43x0_enter_flash_mode(target_s *const t)
 	priv->boot_address = target_mem_read32(t, LPC43xx_CREG_M4MEMMAP);
 	if (priv->boot_address != LPC43xx_LOCAL_SRAM1_BASE && priv->boot_address != LPC43xx_BOOT_ROM_BASE) {
 		lpc43x0_spi_abort(t);
+		lpc43x0_spi_agent_load(t);
 		return true;
 	}
 
@@ -754,6 +787,7 @@ static bool lpc43x0_enter_flash_mode(target_s *const t)
 	}
 
 	lpc43x0_spi_abort(t);
+	lpc43x0_spi_agent_load(t);
 	return true;
 }
 
@@ -761,6 +795,12 @@ static bool lpc43x0_exit_flash_mode(target_s *const t)
 {
 	lpc43x0_priv_s *priv = (lpc43x0_priv_s *)t->target_storage;
 
+	/* Put the core back how we found it if the agent was used */
+	if (priv->agent_loaded) {
+		target_regs_write(t, priv->agent_saved_regs);
+		priv->agent_loaded = false;
+	}
+
 	/* First restore any disturbed configuration */
 	switch (priv->interface) {
 	case FLASH_SPIFI:
@@ -848,31 +888,108 @@ static void lpc43x0_ssp0_setup_command(target_s *const t, const uint32_t command
 		lpc43x0_ssp0_transfer(t, 0U);
 }
 
-static void lpc43x0_spi_setup_xfer(
-	target_s *const target, const uint16_t command, const target_addr_t address, const size_t length)
+static uint32_t lpc43x0_spifi_command(const uint16_t command, const size_t length)
 {
 	/* Rebuild the command for the SPIFI controller */
-	uint32_t spifi_command = LPC43x0_SPIFI_CMD_SERIAL |
+	const uint32_t spifi_command = LPC43x0_SPIFI_CMD_SERIAL |
 		((command & SPI_FLASH_OPCODE_MASK) << LPC43x0_SPIFI_OPCODE_SHIFT) |
 		(((command & SPI_FLASH_DUMMY_MASK) >> SPI_FLASH_DUMMY_SHIFT) << LPC43x0_SPIFI_DUMMY_SHIFT) |
 		(((command & SPI_FLASH_DATA_MASK) >> SPI_FLASH_DATA_SHIFT) << LPC43x0_SPIFI_DATA_SHIFT) |
 		LPC43x0_SPIFI_DATA_LENGTH(length);
+	if ((command & SPI_FLASH_OPCODE_MODE_MASK) != SPI_FLASH_OPCODE_ONLY)
+		return spifi_command | LPC43x0_SPIFI_FRAME_OPCODE_3B_ADDR;
+	return spifi_command | LPC43x0_SPIFI_FRAME_OPCODE_ONLY;
+}
 
+static void lpc43x0_spi_setup_xfer(
+	target_s *const target, const uint16_t command, const target_addr_t address, const size_t length)
+{
 	/* Setup addressing for the instruction */
-	if ((command & SPI_FLASH_OPCODE_MODE_MASK) != SPI_FLASH_OPCODE_ONLY) {
+	if ((command & SPI_FLASH_OPCODE_MODE_MASK) != SPI_FLASH_OPCODE_ONLY)
 		target_mem_write32(target, LPC43x0_SPIFI_ADDR, address);
-		spifi_command |= LPC43x0_SPIFI_FRAME_OPCODE_3B_ADDR;
-	} else
-		spifi_command |= LPC43x0_SPIFI_FRAME_OPCODE_ONLY;
-
 	/* Write the resulting command to the command register */
-	target_mem_write32(target, LPC43x0_SPIFI_CMD, spifi_command);
+	target_mem_write32(target, LPC43x0_SPIFI_CMD, lpc43x0_spifi_command(command, length));
+}
+
+static void lpc43x0_spi_agent_load(target_s *const t)
+{
+	lpc43x0_priv_s *const priv = (lpc43x0_priv_s *)t->target_storage;
+	priv->agent_loaded = false;
+	if (priv->interface != FLASH_SPIFI && priv->interface != FLASH_SPI)
+		return;
+	/* Running the agent clobbers the core registers, so save them to restore when leaving Flash mode */
+	target_regs_read(t, priv->agent_saved_regs);
+	target_mem_write(t, LPC43x0_SPI_AGENT_BASE, lpc43x0_spi_agent, sizeof(lpc43x0_spi_agent));
+	priv->agent_loaded = !target_check_error(t);
+	if (!priv->agent_loaded)
+		DEBUG_WARN("Failed to load LPC43x0 SPI Flash agent, falling back to direct access\n");
+}
+
+/*
+ * Check whether a transfer should be run via the on-target agent. Only transfers that have an address
+ * can be split across multiple agent runs, so anything else must fit the agent's buffer in one go.
+ */
+static bool lpc43x0_spi_agent_usable(target_s *const target, const uint16_t command, const size_t length)
+{
+	const lpc43x0_priv_s *const priv = (const lpc43x0_priv_s *)target->target_storage;
+	if (!priv->agent_loaded || length < LPC43x0_SPI_AGENT_MIN_LENGTH)
+		return false;
+	return length <= LPC43x0_SPI_AGENT_BUFFER_SIZE ||
+		(command & SPI_FLASH_OPCODE_MODE_MASK) == SPI_FLASH_OPCODE_3B_ADDR;
+}
+
+/*
+ * Run one complete SPI transaction through the on-target agent. Writes (page programs) additionally have the
+ * agent poll the Flash's status register till the operation completes, so the status check that follows
+ * is answered first time.
+ */
+static bool lpc43x0_spi_agent_xfer(target_s *const target, const uint16_t command, const target_addr_t address,
+	uint8_t *const data, const size_t length, const bool data_out)
+{
+	lpc43x0_priv_s *const priv = (lpc43x0_priv_s *)target->target_storage;
+	const uint32_t buffer = LPC43x0_SPI_AGENT_MAILBOX + sizeof(lpc43x0_spi_mailbox_s);
+	const bool has_address = (command & SPI_FLASH_OPCODE_MODE_MASK) == SPI_FLASH_OPCODE_3B_ADDR;
+	const uint8_t dummy_bytes = (command & SPI_FLASH_DUMMY_MASK) >> SPI_FLASH_DUMMY_SHIFT;
+
+	for (size_t offset = 0; offset < length; offset += LPC43x0_SPI_AGENT_BUFFER_SIZE) {
+		const size_t amount = MIN(length - offset, LPC43x0_SPI_AGENT_BUFFER_SIZE);
+		const target_addr_t chunk_address = address + offset;
+		lpc43x0_spi_mailbox_s mailbox = {
+			.interface =
+				priv->interface == FLASH_SPIFI ? LPC43x0_SPI_AGENT_INTERFACE_SPIFI : LPC43x0_SPI_AGENT_INTERFACE_SSP0,
+			.flags = data_out ? LPC43x0_SPI_AGENT_FLAG_DATA_OUT | LPC43x0_SPI_AGENT_FLAG_POLL_BUSY : 0U,
+			.length = amount,
+			.spifi_command = lpc43x0_spifi_command(command, amount),
+			.address = chunk_address,
+		};
+		/* Build the opcode, address and dummy bytes for SSP0 */
+		mailbox.header[mailbox.header_length++] = command & SPI_FLASH_OPCODE_MASK;
+		if (has_address) {
+			mailbox.header[mailbox.header_length++] = (chunk_address >> 16U) & 0xffU;
+			mailbox.header[mailbox.header_length++] = (chunk_address >> 8U) & 0xffU;
+			mailbox.header[mailbox.header_length++] = chunk_address & 0xffU;
+		}
+		mailbox.header_length += dummy_bytes;
+
+		target_mem_write(target, LPC43x0_SPI_AGENT_MAILBOX, &mailbox, sizeof(mailbox));
+		if (data_out)
+			target_mem_write(target, buffer, data + offset, amount);
+		if (target_check_error(target) ||
+			!cortexm_run_stub(target, LPC43x0_SPI_AGENT_BASE, LPC43x0_SPI_AGENT_MAILBOX, 0U, 0U, 0U))
+			return false;
+		if (!data_out && target_mem_read(target, data + offset, buffer, amount))
+			return false;
+	}
+	return true;
 }
 
 static void lpc43x0_spi_read(target_s *const target, const uint16_t command, const target_addr_t address,
 	void *const buffer, const size_t length)
 {
 	lpc43x0_priv_s *const priv = (lpc43x0_priv_s *)target->target_storage;
+	if (lpc43x0_spi_agent_usable(target, command, length) &&
+		lpc43x0_spi_agent_xfer(target, command, address, (uint8_t *)buffer, length, false))
+		return;
 	if (priv->interface == FLASH_SPIFI) {
 		lpc43x0_spi_setup_xfer(target, command, address, length);
 		uint8_t *const data = (uint8_t *)buffer;
@@ -897,6 +1014,9 @@ static void lpc43x0_spi_write(target_s *const target, const uint16_t command, co
 	const void *const buffer, const size_t length)
 {
 	lpc43x0_priv_s *const priv = (lpc43x0_priv_s *)target->target_storage;
+	if (lpc43x0_spi_agent_usable(target, command, length) &&
+		lpc43x0_spi_agent_xfer(target, command, address, (uint8_t *)buffer, length, true))
+		return;
 	if (priv->interface == FLASH_SPIFI) {
 		lpc43x0_spi_setup_xfer(target, command, address, length);
 		const uint8_t *const data = (const uint8_t *)buffer;
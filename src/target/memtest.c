@@ -0,0 +1,210 @@
+/*
+ * This file is part of the Black Magic Debug project.
+ *
+ * Copyright (C) 2023 1BitSquared <info@1bitsquared.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * This file implements a target-resident memory test and fill engine for board bring-up.
+ * A small routine (flashstub/memtest.s) is uploaded to spare target RAM and run over the region under test,
+ * reporting back only the failures found, rather than every byte crossing the debug link twice.
+ */
+
+#include "general.h"
+#include "target.h"
+#include "target_internal.h"
+#include "cortexm.h"
+#include "memtest.h"
+
+/* Runs are split into chunks of this size to keep each well inside the stub execution timeout */
+#define MEMTEST_CHUNK_SIZE (1024U * 1024U)
+
+/* This must match the parameter block layout used by flashstub/memtest.s */
+typedef struct memtest_params {
+	uint32_t op;
+	uint32_t start;
+	uint32_t length;
+	uint32_t pattern;
+	uint32_t failures;
+	uint32_t max_failures;
+	memtest_failure_s failure[MEMTEST_MAX_REPORTED];
+} memtest_params_s;
+
+static const uint16_t memtest_stub[] = {
+#include "flashstub/memtest.stub"
+};
+
+#define MEMTEST_PARAMS_OFFSET  ALIGN(sizeof(memtest_stub), 4U)
+#define MEMTEST_WORKSPACE_SIZE (MEMTEST_PARAMS_OFFSET + sizeof(memtest_params_s))
+
+static const struct {
+	const char *name;
+	memtest_op_e op;
+} memtest_ops[] = {
+	{"fill", MEMTEST_FILL},
+	{"walk", MEMTEST_WALKING_ONES},
+	{"addr", MEMTEST_ADDRESS_LINES},
+	{"march", MEMTEST_MARCH_C},
+	{"pattern", MEMTEST_PATTERN},
+};
+
+static bool memtest_overlaps(const target_addr_t start, const size_t length, const target_addr_t addr)
+{
+	return addr < start + length && start < addr + MEMTEST_WORKSPACE_SIZE;
+}
+
+/* Find somewhere in the target's RAM to put the stub and its parameters that isn't part of the test region */
+static bool memtest_find_workspace(
+	target_s *const target, const target_addr_t start, const size_t length, target_addr_t *const workspace)
+{
+	for (const target_ram_s *ram = target->ram; ram; ram = ram->next) {
+		if (ram->length < MEMTEST_WORKSPACE_SIZE)
+			continue;
+		*workspace = ram->start;
+		if (!memtest_overlaps(start, length, *workspace))
+			return true;
+		*workspace = (ram->start + ram->length - MEMTEST_WORKSPACE_SIZE) & ~3U;
+		if (!memtest_overlaps(start, length, *workspace))
+			return true;
+	}
+	return false;
+}
+
+static bool memtest_run(target_s *const target, const target_addr_t workspace, const memtest_op_e op,
+	const target_addr_t start, const size_t length, const uint32_t pattern, memtest_result_s *const result)
+{
+	const target_addr_t params_addr = workspace + MEMTEST_PARAMS_OFFSET;
+	memtest_params_s params = {
+		.op = op,
+		.start = start,
+		.length = length,
+		.pattern = pattern,
+		.failures = 0U,
+		.max_failures = MEMTEST_MAX_REPORTED - result->reported,
+	};
+	const size_t header_size = offsetof(memtest_params_s, failure);
+	if (target_mem_write(target, params_addr, &params, header_size) ||
+		!cortexm_run_stub(target, workspace, params_addr, 0U, 0U, 0U) ||
+		target_mem_read(target, &params, params_addr, header_size))
+		return false;
+
+	const uint32_t recorded = MIN(params.failures, params.max_failures);
+	if (recorded) {
+		if (target_mem_read(target, result->failure + result->reported, params_addr + header_size,
+				recorded * sizeof(memtest_failure_s)))
+			return false;
+		result->reported += recorded;
+	}
+	result->failures += params.failures;
+	return true;
+}
+
+bool target_memtest(target_s *const target, const memtest_op_e op, const target_addr_t start, const size_t length,
+	const uint32_t pattern, memtest_result_s *const result)
+{
+	memset(result, 0, sizeof(*result));
+	if (!cortexm_can_run_thumb2_stub(target)) {
+		DEBUG_ERROR("memtest: only supported on ARMv7-M and ARMv8-M Mainline targets\n");
+		return false;
+	}
+	if ((start & 3U) || (length & 3U) || !length) {
+		DEBUG_ERROR("memtest: region must be word aligned and non-empty\n");
+		return false;
+	}
+	target_addr_t workspace = 0U;
+	if (!memtest_find_workspace(target, start, length, &workspace)) {
+		DEBUG_ERROR("memtest: no RAM outside the test region to run from\n");
+		return false;
+	}
+
+	/* Save what we're about to clobber so the target can carry on afterwards */
+	uint8_t saved_ram[MEMTEST_WORKSPACE_SIZE];
+	uint32_t saved_regs[CORTEXM_GENERAL_REG_COUNT + CORTEX_FLOAT_REG_COUNT];
+	target_regs_read(target, saved_regs);
+	if (target_mem_read(target, saved_ram, workspace, sizeof(saved_ram)) ||
+		target_mem_write(target, workspace, memtest_stub, sizeof(memtest_stub)))
+		return false;
+
+	bool success = true;
+	switch (op) {
+	case MEMTEST_WALKING_ONES:
+		/* The data lines only need checking on one word */
+		success = memtest_run(target, workspace, op, start, 4U, pattern, result);
+		break;
+	case MEMTEST_ADDRESS_LINES:
+		/* The address lines must be checked across the whole region in one go */
+		success = memtest_run(target, workspace, op, start, length, pattern, result);
+		break;
+	default:
+		for (size_t offset = 0; success && offset < length; offset += MEMTEST_CHUNK_SIZE)
+			success = memtest_run(
+				target, workspace, op, start + offset, MIN(length - offset, MEMTEST_CHUNK_SIZE), pattern, result);
+		break;
+	}
+
+	target_mem_write(target, workspace, saved_ram, sizeof(saved_ram));
+	target_regs_write(target, saved_regs);
+	return success && !target_check_error(target);
+}
+
+bool target_cmd_memtest(target_s *const target, const int argc, const char **const argv)
+{
+	const memtest_op_e *op = NULL;
+	if (argc >= 4) {
+		for (size_t i = 0; i < ARRAY_LENGTH(memtest_ops); ++i) {
+			if (!strcmp(argv[1], memtest_ops[i].name))
+				op = &memtest_ops[i].op;
+		}
+	}
+	if (!op) {
+		tc_printf(target, "usage: monitor memtest <fill|walk|addr|march|pattern> <address> <length> [pattern]\n");
+		return false;
+	}
+
+	const target_addr_t start = strtoul(argv[2], NULL, 0);
+	const size_t length = strtoul(argv[3], NULL, 0);
+	const uint32_t pattern = argc > 4 ? strtoul(argv[4], NULL, 0) : (*op == MEMTEST_FILL ? 0U : 0x55555555U);
+
+	memtest_result_s result;
+	const uint32_t start_time = platform_time_ms();
+	if (!target_memtest(target, *op, start, length, pattern, &result)) {
+		tc_printf(target, "Memory test could not be run on this region\n");
+		return false;
+	}
+	const uint32_t end_time = platform_time_ms();
+
+	for (uint32_t i = 0; i < result.reported; ++i)
+		tc_printf(target, "Failure at 0x%08" PRIx32 ": expected 0x%08" PRIx32 ", read 0x%08" PRIx32 "\n",
+			result.failure[i].address, result.failure[i].expected, result.failure[i].actual);
+	if (result.failures > result.reported)
+		tc_printf(target, "... and %" PRIu32 " more\n", result.failures - result.reported);
+	tc_printf(target, "%s of 0x%08" PRIx32 "+0x%" PRIx32 " %s, %" PRIu32 " failures in %" PRIu32 "ms\n", argv[1],
+		start, (uint32_t)length, result.failures ? "FAILED" : "passed", result.failures, end_time - start_time);
+	return !result.failures;
+}
@@ -0,0 +1,78 @@
+/*
+ * This file is part of the Black Magic Debug project.
+ *
+ * Copyright (C) 2023 1BitSquared <info@1bitsquared.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TARGET_MEMTEST_H
+#define TARGET_MEMTEST_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "target.h"
+
+typedef enum memtest_op {
+	MEMTEST_FILL,
+	MEMTEST_WALKING_ONES,
+	MEMTEST_ADDRESS_LINES,
+	MEMTEST_MARCH_C,
+	MEMTEST_PATTERN,
+} memtest_op_e;
+
+/* How many failing addresses get reported back in detail, the rest are only counted */
+#define MEMTEST_MAX_REPORTED 16U
+
+typedef struct memtest_failure {
+	uint32_t address;
+	uint32_t expected;
+	uint32_t actual;
+} memtest_failure_s;
+
+typedef struct memtest_result {
+	/* Total number of failing word accesses seen */
+	uint32_t failures;
+	/* Number of entries filled in the failure array */
+	uint32_t reported;
+	memtest_failure_s failure[MEMTEST_MAX_REPORTED];
+} memtest_result_s;
+
+/*
+ * Run a memory test or fill over the word aligned region `start` to `start + length` using a routine
+ * uploaded to and run on the target itself, so only the parameters and results cross the debug link.
+ * The routine is placed in a RAM region from the target's memory map that does not overlap the test region.
+ * Returns false if the operation could not be run at all, check the result for the failures found.
+ */
+bool target_memtest(
+	target_s *target, memtest_op_e op, target_addr_t start, size_t length, uint32_t pattern, memtest_result_s *result);
+
+/* Monitor command handler: memtest <fill|walk|addr|march|pattern> <address> <length> [pattern] */
+bool target_cmd_memtest(target_s *target, int argc, const char **argv);
+
+#endif /* TARGET_MEMTEST_H */
@@ -38,6 +38,7 @@
 #include "target.h"
 #include "target_internal.h"
 #include "cortex.h"
+#include "cortexm.h"
 
 /* TLV: Device info tag, address and expected value */
 #define DEVINFO_TAG_ADDR  0x00201004U
@@ -93,39 +94,65 @@
 /* Flash write buffer and stack */
 #define SRAM_STACK_OFFSET   0x00000200U /* A bit less than 512 stack room */
 #define SRAM_STACK_PTR      (SRAM_BASE + SRAM_STACK_OFFSET)
-#define SRAM_WRITE_BUFFER   SRAM_STACK_PTR /* Buffer right above stack */
-#define SRAM_WRITE_BUF_SIZE 0x00000400U    /* Write 1024 bytes at a tima */
+#define SRAM_TRAMPOLINE     SRAM_STACK_PTR            /* Programming trampoline right above stack */
+#define SRAM_DESCRIPTORS    (SRAM_TRAMPOLINE + 0x40U) /* Followed by the list of writes to do */
+#define SRAM_WRITE_BUFFER   (SRAM_BASE + 0x00000400U) /* Then the buffers for those writes */
+#define SRAM_WRITE_BUF_SIZE 0x00000400U               /* Write 1024 bytes at a time */
+#define WRITE_BATCH_SIZE    8U                        /* Number of writes to queue before calling the ROM */
+
+/* ROM call timeout in ms, the longest being a batch of writes */
+#define ROM_CALL_TIMEOUT 5000U
 
 /* Watchdog */
 #define WDT_A_WTDCTL 0x4000480cU /* Control register for watchdog */
 #define WDT_A_HOLD   0x5a88U     /* Clears and halts the watchdog */
 
+/* Write descriptor as consumed by the programming trampoline */
+typedef struct msp432_write_desc {
+	uint32_t buffer;
+	uint32_t dest;
+	uint32_t length;
+} msp432_write_desc_s;
+
 /* Support variables to call code in ROM */
 typedef struct msp432_flash {
 	target_flash_s f;
 	target_addr_t flash_protect_register; /* Address of the WEPROT register*/
 	target_addr_t flash_erase_sector_fn;  /* Erase flash sector routine in ROM*/
 	target_addr_t flash_program_fn;       /* Flash programming routine in ROM */
+	/* Flash session state, valid from prepare to done */
+	uint32_t saved_regs[CORTEXM_GENERAL_REG_COUNT + CORTEX_FLOAT_REG_COUNT];
+	uint32_t saved_protection; /* WEPROT value to restore when done */
+	uint32_t unprotected;      /* Sector protection bits cleared so far */
+	uint32_t queued_writes;    /* Number of write descriptors waiting to be run */
+	msp432_write_desc_s queue[WRITE_BATCH_SIZE];
 } msp432_flash_s;
 
+static const uint16_t msp432_flash_program_trampoline[] = {
+#include "flashstub/msp432p4.stub"
+};
+
+static bool msp432_flash_prepare(target_flash_s *f);
 static bool msp432_sector_erase(target_flash_s *f, target_addr_t addr);
 static bool msp432_flash_erase(target_flash_s *f, target_addr_t addr, size_t len);
 static bool msp432_flash_write(target_flash_s *f, target_addr_t dest, const void *src, size_t len);
+static bool msp432_flash_done(target_flash_s *f);
 
 /* Call a function in the MSP432 ROM (or anywhere else...)*/
 static void msp432_call_rom(target_s *t, uint32_t address, uint32_t *regs);
 
-/* Protect or unprotect the sector containing address */
-static inline uint32_t msp432_sector_unprotect(msp432_flash_s *mf, target_addr_t addr)
+/* Unprotect the sectors covering addr to addr + len, touching the protection register only if needed */
+static inline void msp432_sector_unprotect(msp432_flash_s *mf, target_addr_t addr, size_t len)
 {
-	/* Read the old protection register */
-	uint32_t old_mask = target_mem_read32(mf->f.t, mf->flash_protect_register);
-	/* Find the bit representing the sector and set it to 0  */
-	uint32_t sec_mask = ~(1U << ((addr - mf->f.start) / SECTOR_SIZE));
-	/* Clear the potection bit */
-	sec_mask &= old_mask;
-	target_mem_write32(mf->f.t, mf->flash_protect_register, sec_mask);
-	return old_mask;
+	uint32_t sec_mask = 0;
+	for (target_addr_t sector = addr & ~(SECTOR_SIZE - 1U); sector < addr + len; sector += SECTOR_SIZE)
+		sec_mask |= 1U << ((sector - mf->f.start) / SECTOR_SIZE);
+	if ((mf->unprotected & sec_mask) == sec_mask)
+		return;
+	mf->unprotected |= sec_mask;
+	/* Clear the protection bits */
+	target_mem_write32(mf->f.t, mf->flash_protect_register, mf->saved_protection & ~mf->unprotected);
+	DEBUG_INFO("Flash protect: 0x%08" PRIX32 "\n", mf->saved_protection & ~mf->unprotected);
 }
 
 /* Optional commands handlers */
@@ -154,8 +181,10 @@ static void msp432_add_flash(target_s *t, uint32_t addr, size_t length, target_a
 	f->start = addr;
 	f->length = length;
 	f->blocksize = SECTOR_SIZE;
+	f->prepare = msp432_flash_prepare;
 	f->erase = msp432_flash_erase;
 	f->write = msp432_flash_write;
+	f->done = msp432_flash_done;
 	f->writesize = SRAM_WRITE_BUF_SIZE;
 	f->erased = 0xff;
 	target_add_flash(t, f);
@@ -224,6 +253,64 @@ bool msp432p4_probe(target_s *t)
 }
 
 /* Flash operations */
+/*
+ * Start a Flash session: save the core context once, stop the watchdog and set up the return breakpoint,
+ * stack and programming trampoline so each ROM call after this is just a register write and resume
+ */
+static bool msp432_flash_prepare(target_flash_s *f)
+{
+	target_s *t = f->t;
+	msp432_flash_s *mf = (msp432_flash_s *)f;
+
+	target_regs_read(t, mf->saved_regs);
+	mf->saved_protection = target_mem_read32(t, mf->flash_protect_register);
+	mf->unprotected = 0;
+	mf->queued_writes = 0;
+
+	/* Kill watchdog */
+	target_mem_write16(t, WDT_A_WTDCTL, WDT_A_HOLD);
+	/* Breakpoint at the beginning of CODE SRAM alias area */
+	target_mem_write16(t, SRAM_CODE_BASE, CORTEX_THUMB_BREAKPOINT);
+	target_mem_write(t, SRAM_TRAMPOLINE, msp432_flash_program_trampoline, sizeof(msp432_flash_program_trampoline));
+	return !target_check_error(t);
+}
+
+/* Run all the queued writes through the trampoline in a single ROM session */
+static bool msp432_flash_run_queue(msp432_flash_s *mf)
+{
+	if (!mf->queued_writes)
+		return true;
+	target_s *t = mf->f.t;
+	target_mem_write(t, SRAM_DESCRIPTORS, mf->queue, mf->queued_writes * sizeof(msp432_write_desc_s));
+
+	uint32_t regs[CORTEXM_GENERAL_REG_COUNT + CORTEX_FLOAT_REG_COUNT];
+	memcpy(regs, mf->saved_regs, sizeof(regs));
+	regs[0] = SRAM_DESCRIPTORS;     // Address of the write descriptor list in R0
+	regs[1] = mf->queued_writes;    // Number of descriptors in R1
+	regs[2] = mf->flash_program_fn; // ROM programming routine in R2
+
+	DEBUG_INFO("Writing %" PRIu32 " blocks from 0x%08" PRIX32 "\n", mf->queued_writes, mf->queue[0].dest);
+	/* Call the trampoline */
+	msp432_call_rom(t, SRAM_TRAMPOLINE, regs);
+	mf->queued_writes = 0;
+
+	DEBUG_INFO("ROM return value: %" PRIu32 "\n", regs[0]);
+	// Result value in R0 is true for success
+	return regs[0] != 0;
+}
+
+/* End the Flash session: finish any queued writes then put back the protection and core context */
+static bool msp432_flash_done(target_flash_s *f)
+{
+	target_s *t = f->t;
+	msp432_flash_s *mf = (msp432_flash_s *)f;
+
+	const bool result = msp432_flash_run_queue(mf);
+	target_mem_write32(t, mf->flash_protect_register, mf->saved_protection);
+	target_regs_write(t, mf->saved_regs);
+	return result;
+}
+
 /* Erase a single sector at addr calling the ROM routine*/
 static bool msp432_sector_erase(target_flash_s *f, target_addr_t addr)
 {
@@ -231,12 +318,11 @@ static bool msp432_sector_erase(target_flash_s *f, target_addr_t addr)
 	msp432_flash_s *mf = (msp432_flash_s *)f;
 
 	/* Unprotect sector */
-	uint32_t old_prot = msp432_sector_unprotect(mf, addr);
-	DEBUG_WARN("Flash protect: 0x%08" PRIX32 "\n", target_mem_read32(t, mf->flash_protect_register));
+	msp432_sector_unprotect(mf, addr, 1U);
 
 	/* Prepare input data */
 	uint32_t regs[CORTEXM_GENERAL_REG_COUNT + CORTEX_FLOAT_REG_COUNT];
-	target_regs_read(t, regs);
+	memcpy(regs, mf->saved_regs, sizeof(regs));
 	regs[0] = addr; // Address of sector to erase in R0
 
 	DEBUG_INFO("Erasing sector at 0x%08" PRIX32 "\n", addr);
@@ -246,9 +332,6 @@ static bool msp432_sector_erase(target_flash_s *f, target_addr_t addr)
 
 	// Result value in R0 is true for success
 	DEBUG_INFO("ROM return value: %" PRIu32 "\n", regs[0]);
-
-	/* Restore original protection */
-	target_mem_write32(t, mf->flash_protect_register, old_prot);
 	return regs[0] != 0;
 }
 
@@ -270,38 +353,27 @@ static bool msp432_flash_erase(target_flash_s *f, target_addr_t addr, size_t len
 	return ret;
 }
 
-/* Program flash */
+/* Program flash - the write is staged in target RAM and queued to be done with others in one ROM call */
 static bool msp432_flash_write(target_flash_s *f, target_addr_t dest, const void *src, size_t len)
 {
 	msp432_flash_s *mf = (msp432_flash_s *)f;
 	target_s *t = f->t;
 
 	/* Prepare RAM buffer in target */
-	target_mem_write(t, SRAM_WRITE_BUFFER, src, len);
-
-	/* Unprotect sector, len is always < SECTOR_SIZE */
-	uint32_t old_prot = msp432_sector_unprotect(mf, dest);
+	const uint32_t buffer = SRAM_WRITE_BUFFER + mf->queued_writes * SRAM_WRITE_BUF_SIZE;
+	target_mem_write(t, buffer, src, len);
 
-	DEBUG_WARN("Flash protect: 0x%08" PRIX32 "\n", target_mem_read32(t, mf->flash_protect_register));
+	/* Unprotect the sector if this is the first write to it */
+	msp432_sector_unprotect(mf, dest, len);
 
-	/* Prepare input data */
-	uint32_t regs[t->regs_size / sizeof(uint32_t)]; // Use of VLA
-	target_regs_read(t, regs);
-	regs[0] = SRAM_WRITE_BUFFER; // Address of buffer to be flashed in R0
-	regs[1] = dest;              // Flash address to be write to in R1
-	regs[2] = len;               // Size of buffer to be flashed in R2
+	msp432_write_desc_s *const desc = &mf->queue[mf->queued_writes++];
+	desc->buffer = buffer;
+	desc->dest = dest;
+	desc->length = len;
 
-	DEBUG_INFO("Writing 0x%04" PRIX32 " bytes at 0x%08zu\n", dest, len);
-	/* Call ROM */
-	msp432_call_rom(t, mf->flash_program_fn, regs);
-
-	/* Restore original protection */
-	target_mem_write32(t, mf->flash_protect_register, old_prot);
-
-	DEBUG_INFO("ROM return value: %" PRIu32 "\n", regs[0]);
-
-	// Result value in R0 is true for success
-	return regs[0] != 0;
+	if (mf->queued_writes == WRITE_BATCH_SIZE)
+		return msp432_flash_run_queue(mf);
+	return !target_check_error(t);
 }
 
 /* Optional commands handlers */
@@ -319,11 +391,15 @@ static bool msp432_cmd_erase_main(target_s *t, int argc, const char **argv)
 
 	/* Erase first bank */
 	target_flash_s *f = target_flash_for_addr(t, MAIN_FLASH_BASE);
+	result &= msp432_flash_prepare(f);
 	result &= msp432_flash_erase(f, MAIN_FLASH_BASE, banksize);
+	result &= msp432_flash_done(f);
 
 	/* Erase second bank */
 	f = target_flash_for_addr(t, MAIN_FLASH_BASE + banksize);
+	result &= msp432_flash_prepare(f);
 	result &= msp432_flash_erase(f, MAIN_FLASH_BASE + banksize, banksize);
+	result &= msp432_flash_done(f);
 
 	return result;
 }
@@ -338,21 +414,22 @@ static bool msp432_cmd_sector_erase(target_s *t, int argc, const char **argv)
 	/* Find the flash structure (for the right protect register) */
 	target_flash_s *f = target_flash_for_addr(t, addr);
 
-	if (f)
-		return msp432_sector_erase(f, addr);
+	if (f) {
+		bool result = msp432_flash_prepare(f);
+		result &= msp432_sector_erase(f, addr);
+		result &= msp432_flash_done(f);
+		return result;
+	}
 	tc_printf(t, "Invalid sector address\n");
 	return false;
 }
 
-/* MSP432 ROM routine invocation */
+/*
+ * MSP432 ROM routine invocation, the watchdog and return breakpoint having been set up by msp432_flash_prepare().
+ * The routine's result is read back into regs[0].
+ */
 static void msp432_call_rom(target_s *t, uint32_t address, uint32_t *regs)
 {
-	/* Kill watchdog */
-	target_mem_write16(t, WDT_A_WTDCTL, WDT_A_HOLD);
-
-	/* Breakpoint at the beginning of CODE SRAM alias area */
-	target_mem_write16(t, SRAM_CODE_BASE, CORTEX_THUMB_BREAKPOINT);
-
 	/* Prepare registers */
 	regs[CORTEX_REG_MSP] = SRAM_STACK_PTR;     /* Stack space */
 	regs[CORTEX_REG_LR] = SRAM_CODE_BASE | 1U; /* Return to beginning of SRAM CODE alias */
@@ -361,9 +438,19 @@ static void msp432_call_rom(target_s *t, uint32_t address, uint32_t *regs)
 
 	/* Start the target and wait for it to halt again, which calls the routine setup above */
 	target_halt_resume(t, false);
-	while (!target_halt_poll(t, NULL))
-		continue;
+	platform_timeout_s timeout;
+	platform_timeout_set(&timeout, ROM_CALL_TIMEOUT);
+	while (!target_halt_poll(t, NULL)) {
+		if (platform_timeout_is_expired(&timeout)) {
+			DEBUG_ERROR("MSP432 ROM call timed out\n");
+			target_halt_request(t);
+			regs[0] = 0;
+			return;
+		}
+		/* The ROM routines take milliseconds to run, so don't hammer the debug link */
+		platform_delay(1);
+	}
 
-	// Read registers to get result
-	target_regs_read(t, regs);
+	// Read only R0 to get the result
+	target_reg_read(t, 0, &regs[0], sizeof(regs[0]));
 }
@@ -45,6 +45,7 @@ typedef struct riscv64_regs {
 static void riscv64_regs_read(target_s *target, void *data);
 static void riscv64_regs_write(target_s *target, const void *data);
 static void riscv64_mem_read(target_s *target, void *dest, target_addr_t src, size_t len);
+static void riscv64_mem_write(target_s *target, target_addr_t dest, const void *src, size_t len);
 
 bool riscv64_probe(target_s *const target)
 {
@@ -55,6 +56,10 @@ bool riscv64_probe(target_s *const target)
 	target->regs_read = riscv64_regs_read;
 	target->regs_write = riscv64_regs_write;
 	target->mem_read = riscv64_mem_read;
+	target->mem_write = riscv64_mem_write;
+
+	target->breakwatch_set = riscv_breakwatch_set;
+	target->breakwatch_clear = riscv_breakwatch_clear;
 
 	return false;
 }
@@ -65,13 +70,9 @@ static void riscv64_regs_read(target_s *const target, void *const data)
 	riscv_hart_s *const hart = riscv_hart_struct(target);
 	riscv64_regs_s *const regs = (riscv64_regs_s *)data;
 	const size_t gprs_count = hart->extensions & RV_ISA_EXT_EMBEDDED ? 16U : 32U;
-	/* Loop through reading out the GPRs */
-	for (size_t gpr = 0; gpr < gprs_count; ++gpr) {
-		// TODO: handle when this fails..
-		riscv_csr_read(hart, RV_GPR_BASE + gpr, &regs->gprs[gpr]);
-	}
-	/* Special access to grab the program counter that would be executed on resuming the hart */
-	riscv_csr_read(hart, RV_DPC, &regs->pc);
+	/* Read out the GPRs, then grab the program counter that would be executed on resuming the hart */
+	if (!riscv_gprs_read(hart, regs->gprs, gprs_count) || !riscv_csr_read(hart, RV_DPC, &regs->pc))
+		DEBUG_ERROR("Failed to read Hart registers: %u\n", hart->status);
 }
 
 static void riscv64_regs_write(target_s *const target, const void *const data)
@@ -80,63 +81,30 @@ static void riscv64_regs_write(target_s *const target, const void *const data)
 	riscv_hart_s *const hart = riscv_hart_struct(target);
 	riscv64_regs_s *const regs = (riscv64_regs_s *)data;
 	const size_t gprs_count = hart->extensions & RV_ISA_EXT_EMBEDDED ? 16U : 32U;
-	/* Loop through writing out the GPRs, except for the first which is always 0 */
-	for (size_t gpr = 1; gpr < gprs_count; ++gpr) {
-		// TODO: handle when this fails..
-		riscv_csr_write(hart, RV_GPR_BASE + gpr, &regs->gprs[gpr]);
-	}
-	/* Special access to poke in the program counter that will be executed on resuming the hart */
-	riscv_csr_write(hart, RV_DPC, &regs->pc);
+	/* Write out the GPRs (except x0 which is always 0), then poke in the program counter to resume at */
+	if (!riscv_gprs_write(hart, regs->gprs, gprs_count) || !riscv_csr_write(hart, RV_DPC, &regs->pc))
+		DEBUG_ERROR("Failed to write Hart registers: %u\n", hart->status);
 }
 
-/* Takes in data from abstract command arg0 and, based on the access width, unpacks it to dest */
-void riscv64_unpack_data(
-	void *const dest, const uint32_t data_low, const uint32_t data_high, const uint8_t access_width)
-{
-	switch (access_width) {
-	/* If the access was 32-bit or less, ignore data_high and delegate to the RV32 version of this function */
-	case RV_MEM_ACCESS_8_BIT:
-	case RV_MEM_ACCESS_16_BIT:
-	case RV_MEM_ACCESS_32_BIT:
-		riscv32_unpack_data(dest, data_low, access_width);
-		break;
-	case RV_MEM_ACCESS_64_BIT: {
-		/* Reconstruct the 64-bit value and copy it into the destination */
-		uint64_t value = ((uint64_t)data_high << 32U) | data_low;
-		memcpy(dest, &value, sizeof(value));
-		break;
-	}
-	}
-}
-
-/* XXX: target_addr_t supports only 32-bit addresses, artificially limiting this function */
+/* XXX: target_addr_t supports only 32-bit addresses, artificially limiting these functions */
 static void riscv64_mem_read(target_s *const target, void *const dest, const target_addr_t src, const size_t len)
 {
 	DEBUG_TARGET("Performing %zu byte read of %08" PRIx32 "\n", len, src);
 	/* If we're asked to do a 0-byte read, do nothing */
 	if (!len)
 		return;
-	riscv_hart_s *const hart = riscv_hart_struct(target);
-	/* Figure out the maxmial width of access to perform, up to the bitness of the target */
-	const uint8_t access_width = riscv_mem_access_width(hart, src, len);
-	const uint8_t access_length = 1U << access_width;
-	/* Build the access command */
-	const uint32_t command = RV_DM_ABST_CMD_ACCESS_MEM | RV_ABST_READ | (access_width << RV_ABST_MEM_ACCESS_SHIFT) |
-		(access_length < len ? RV_ABST_MEM_ADDR_POST_INC : 0U);
-	/* Write the address to read to arg1 */
-	if (!riscv_dm_write(hart->dbg_module, RV_DM_DATA2, src) || !riscv_dm_write(hart->dbg_module, RV_DM_DATA3, 0U))
+	/*
+	 * The remote protocol acceleration (dmi_bus->mem_read) only knows how to drive 32-bit Harts,
+	 * so always run the access locally here
+	 */
+	riscv_hart_mem_read(riscv_hart_struct(target), dest, src, len);
+}
+
+static void riscv64_mem_write(target_s *const target, const target_addr_t dest, const void *const src, const size_t len)
+{
+	DEBUG_TARGET("Performing %zu byte write of %08" PRIx32 "\n", len, dest);
+	/* If we're asked to do a 0-byte write, do nothing */
+	if (!len)
 		return;
-	uint8_t *const data = (uint8_t *)dest;
-	for (size_t offset = 0; offset < len; offset += access_length) {
-		/* Execute the read */
-		if (!riscv_dm_write(hart->dbg_module, RV_DM_ABST_COMMAND, command) || !riscv_command_wait_complete(hart))
-			return;
-		/* Extract back the data from arg0 */
-		uint32_t value_low = 0;
-		uint32_t value_high = 0;
-		if (!riscv_dm_read(hart->dbg_module, RV_DM_DATA0, &value_low) ||
-			!riscv_dm_read(hart->dbg_module, RV_DM_DATA1, &value_high))
-			return;
-		riscv64_unpack_data(data + offset, value_low, value_high, access_width);
-	}
+	riscv_hart_mem_write(riscv_hart_struct(target), dest, src, len);
 }
@@ -49,9 +49,12 @@
  * https://github.com/riscv/riscv-debug-spec/blob/master/riscv-debug-stable.pdf
  */
 
-#define RV_DM_CONTROL 0x10U
-#define RV_DM_STATUS  0x11U
-#define RV_DM_NEXT_DM 0x1dU
+#define RV_DM_CONTROL      0x10U
+#define RV_DM_STATUS       0x11U
+#define RV_DM_HAWINDOW_SEL 0x14U
+#define RV_DM_HAWINDOW     0x15U
+#define RV_DM_NEXT_DM      0x1dU
+#define RV_DM_HALT_SUMMARY 0x40U
 
 #define RV_DM_CTRL_ACTIVE          0x00000001U
 #define RV_DM_CTRL_HARTSEL_MASK    0x03ffffc0U
@@ -61,11 +64,13 @@
 #define RV_DM_CTRL_RESUME_REQ      0x40000000U
 #define RV_DM_CTRL_HART_RESET      0x20000000U
 #define RV_DM_CTRL_HART_ACK_RESET  0x10000000U
+#define RV_DM_CTRL_HASEL           0x04000000U
 #define RV_DM_CTRL_SYSTEM_RESET    0x00000002U
 #define RV_DM_CTRL_HARTSELLO_SHIFT 16U
 #define RV_DM_CTRL_HARTSELHI_SHIFT 4U
 
 #define RV_DM_STAT_ALL_RESUME_ACK 0x00020000U
+#define RV_DM_STAT_ANY_RESUME_ACK 0x00010000U
 #define RV_DM_STAT_NON_EXISTENT   0x00004000U
 #define RV_DM_STAT_ALL_HALTED     0x00000200U
 #define RV_DM_STAT_ALL_RESET      0x00080000U
@@ -73,7 +78,8 @@
 #define RV_DM_ABST_STATUS_BUSY       0x00001000U
 #define RV_DM_ABST_STATUS_DATA_COUNT 0x0000000fU
 
-#define RV_DM_SYSBUS_STATUS_ADDR_WIDTH_MASK 0x00000fe0U
+#define RV_DM_SYSBUS_STATUS_ADDR_WIDTH_MASK  0x00000fe0U
+#define RV_DM_SYSBUS_STATUS_ADDR_WIDTH_SHIFT 5U
 
 #define RV_CSR_FORCE_MASK   0xc000U
 #define RV_CSR_FORCE_32_BIT 0x4000U
@@ -102,6 +108,38 @@
 /* tdata2 -> selected trigger configuration register 2 */
 #define RV_TRIG_DATA_2 0x7a2U
 
+/* The trigger type is held in the top 4 bits of tdata1, and dmode in the bit below that */
+#define RV_TRIGGER_TYPE_SHIFT     4U
+#define RV_TRIGGER_DMODE_SHIFT    5U
+#define RV_TRIGGER_TYPE_MCONTROL  2U
+#define RV_TRIGGER_TYPE_MCONTROL6 6U
+
+/* Match when the processor tries to read the location */
+#define RV_MATCH_LOAD 0x00000001U
+/* Match when the processor tries to write the location */
+#define RV_MATCH_STORE 0x00000002U
+/* Match when the processor tries to execute the location */
+#define RV_MATCH_EXECUTE 0x00000004U
+/* Define that the match should occur in all/any mode */
+#define RV_MATCH_ANY_MODE 0x00000058U
+/* Set the match action to enter debug mode */
+#define RV_MATCH_ACTION_DEBUG_MODE 0x00001000U
+/* Chain this trigger to the next so that both have to match for the action to occur */
+#define RV_MATCH_CHAIN 0x00000800U
+/* These define how the address is compared against tdata2 (equality is the default) */
+#define RV_MATCH_GREATER_EQUAL 0x00000100U
+#define RV_MATCH_LESS_THAN     0x00000180U
+/* These two define the match timing (before-or-after operation execution), only present in mcontrol */
+#define RV_MATCH_BEFORE 0x00000000U
+#define RV_MATCH_AFTER  0x00040000U
+
+/* Sticky bits indicating the trigger fired */
+#define RV_MCONTROL_HIT   0x00100000U
+#define RV_MCONTROL6_HIT0 0x00400000U
+#define RV_MCONTROL6_HIT1 0x02000000U
+
+#define RV_MCONTROL6_SIZE_SHIFT 16U
+
 #define RV_ISA_EXTENSIONS_MASK 0x03ffffffU
 
 #define RV_VENDOR_JEP106_CONT_MASK 0x7fffff80U
@@ -110,6 +148,17 @@
 #define RV_DCSR_STEP       0x00000004U
 #define RV_DCSR_CAUSE_MASK 0x000001c0U
 #define RV_DCSR_STEPIE     0x00000800U
+#define RV_DCSR_EBREAKU    0x00001000U
+#define RV_DCSR_EBREAKS    0x00002000U
+#define RV_DCSR_EBREAKM    0x00008000U
+
+#define RV_INSN_EBREAK 0x00100073U
+
+#define RV_GPR_RA 1U
+#define RV_GPR_A0 10U
+
+#define RV_STUB_TIMEOUT        5000U
+#define RV_STUB_POLL_DELAY_MAX 32U
 
 #define RV_GPRS_COUNT 32U
 
@@ -274,6 +323,38 @@ void riscv_dmi_init(riscv_dmi_s *const dmi)
 	} while (base_addr != 0U);
 }
 
+/* Build the mask of all the DM's Harts, as used for both the hart array and halt summary */
+static inline uint32_t riscv_dm_harts_mask(const riscv_dm_s *const dbg_module)
+{
+	return dbg_module->hart_count >= 32U ? UINT32_MAX : (1U << dbg_module->hart_count) - 1U;
+}
+
+/* Work out what the DM offers for checking on and controlling all its Harts at once */
+static void riscv_dm_discover_hart_groups(riscv_dm_s *const dbg_module)
+{
+	/*
+	 * haltsum0 covers the 32 Harts in the window picked by hartsel[19:5], so if all the Harts are in the first
+	 * window, one read of it tells us the state of every Hart, whichever one is currently selected
+	 */
+	if (dbg_module->hart_count > 32U)
+		return;
+	dbg_module->flags |= RV_DM_FLAG_HALT_SUMMARY;
+
+	/* hasel is hardwired to 0 if the hart array mask is not implemented, so try selecting it */
+	const uint32_t harts_mask = riscv_dm_harts_mask(dbg_module);
+	uint32_t control = 0U;
+	uint32_t window = 0U;
+	const bool result = riscv_dm_write(dbg_module, RV_DM_CONTROL, RV_DM_CTRL_ACTIVE | RV_DM_CTRL_HASEL) &&
+		riscv_dm_read(dbg_module, RV_DM_CONTROL, &control) && (control & RV_DM_CTRL_HASEL) &&
+		/* If that worked, program the mask with all the DM's Harts and check it took */
+		riscv_dm_write(dbg_module, RV_DM_HAWINDOW_SEL, 0U) && riscv_dm_write(dbg_module, RV_DM_HAWINDOW, harts_mask) &&
+		riscv_dm_read(dbg_module, RV_DM_HAWINDOW, &window) && window == harts_mask;
+	if (!riscv_dm_write(dbg_module, RV_DM_CONTROL, RV_DM_CTRL_ACTIVE) || !result)
+		return;
+	dbg_module->flags |= RV_DM_FLAG_HART_ARRAY;
+	DEBUG_INFO("DM can halt and resume all %" PRIu32 " of its Harts together\n", dbg_module->hart_count);
+}
+
 static void riscv_dm_init(riscv_dm_s *const dbg_module)
 {
 	/* Attempt to activate the DM */
@@ -296,6 +377,7 @@ static void riscv_dm_init(riscv_dm_s *const dbg_module)
 		/* If the hart doesn't exist, the spec says to terminate scan */
 		if (status & RV_DM_STAT_NON_EXISTENT)
 			break;
+		dbg_module->hart_count = hart_idx + 1U;
 
 		riscv_hart_s *hart = calloc(1, sizeof(*hart));
 		if (!hart) { /* calloc failed: heap exhaustion */
@@ -309,6 +391,9 @@ static void riscv_dm_init(riscv_dm_s *const dbg_module)
 		if (!riscv_hart_init(hart))
 			free(hart);
 	}
+	/* With all the Harts found, see if we can deal with them as a group */
+	if (dbg_module->hart_count > 1U)
+		riscv_dm_discover_hart_groups(dbg_module);
 }
 
 static uint8_t riscv_isa_address_width(const uint32_t isa)
@@ -586,15 +671,24 @@ bool riscv_command_wait_complete(riscv_hart_s *const hart)
 	return hart->status == RISCV_HART_NO_ERROR;
 }
 
+bool riscv_abstract_command(riscv_hart_s *const hart, const uint32_t command)
+{
+	riscv_dmi_s *const dmi_bus = hart->dbg_module->dmi_bus;
+	/* If the DMI provides a way to run the whole command in one go (such as a remote probe), use that */
+	if (dmi_bus->abstract_command)
+		return dmi_bus->abstract_command(hart, command);
+	/* Otherwise start the command and wait for it to complete */
+	return riscv_dm_write(hart->dbg_module, RV_DM_ABST_COMMAND, command) && riscv_command_wait_complete(hart);
+}
+
 bool riscv_csr_read(riscv_hart_s *const hart, const uint16_t reg, void *const data)
 {
 	const uint8_t access_width = (reg & RV_CSR_FORCE_MASK) ? riscv_csr_access_width(reg) : hart->access_width;
 	DEBUG_TARGET("Reading %u-bit CSR %03x\n", access_width, reg & ~RV_CSR_FORCE_MASK);
 	/* Set up the register read and wait for it to complete */
-	if (!riscv_dm_write(hart->dbg_module, RV_DM_ABST_COMMAND,
-			RV_DM_ABST_CMD_ACCESS_REG | RV_ABST_READ | RV_REG_XFER | riscv_hart_access_width(access_width) |
-				(reg & ~RV_CSR_FORCE_MASK)) ||
-		!riscv_command_wait_complete(hart))
+	const uint32_t command = RV_DM_ABST_CMD_ACCESS_REG | RV_ABST_READ | RV_REG_XFER |
+		riscv_hart_access_width(access_width) | (reg & ~RV_CSR_FORCE_MASK);
+	if (!riscv_abstract_command(hart, command))
 		return false;
 	uint32_t *const value = (uint32_t *)data;
 	/* If we're doing a 128-bit read, grab the upper-most 2 uint32_t's */
@@ -624,11 +718,150 @@ bool riscv_csr_write(riscv_hart_s *const hart, const uint16_t reg, const void *c
 			riscv_dm_write(hart->dbg_module, RV_DM_DATA3, value[3])))
 		return false;
 	/* Configure and run the write */
-	if (!riscv_dm_write(hart->dbg_module, RV_DM_ABST_COMMAND,
-			RV_DM_ABST_CMD_ACCESS_REG | RV_ABST_WRITE | RV_REG_XFER | riscv_hart_access_width(access_width) |
-				(reg & ~RV_CSR_FORCE_MASK)))
+	const uint32_t command = RV_DM_ABST_CMD_ACCESS_REG | RV_ABST_WRITE | RV_REG_XFER |
+		riscv_hart_access_width(access_width) | (reg & ~RV_CSR_FORCE_MASK);
+	return riscv_abstract_command(hart, command);
+}
+
+/* Read the value in DATA0 (and DATA1 for 64-bit Harts), DATA0 last as that is the register which triggers autoexec */
+static bool riscv_gpr_read_data(riscv_hart_s *const hart, uint32_t *const value)
+{
+	if (hart->access_width == 64U && !riscv_dm_read(hart->dbg_module, RV_DM_DATA1, value + 1))
 		return false;
-	return riscv_command_wait_complete(hart);
+	return riscv_dm_read(hart->dbg_module, RV_DM_DATA0, value);
+}
+
+/* Write a value into DATA0 (and DATA1 for 64-bit Harts), DATA0 last as that is the register which triggers autoexec */
+static bool riscv_gpr_write_data(riscv_hart_s *const hart, const uint32_t *const value)
+{
+	if (hart->access_width == 64U && !riscv_dm_write(hart->dbg_module, RV_DM_DATA1, value[1]))
+		return false;
+	return riscv_dm_write(hart->dbg_module, RV_DM_DATA0, value[0]);
+}
+
+/* Turn on auto-execution of the last abstract command on DATA0 accesses, checking the DM actually implements it */
+static bool riscv_gprs_autoexec_enable(riscv_hart_s *const hart)
+{
+	uint32_t autoexec = 0U;
+	if (!riscv_dm_write(hart->dbg_module, RV_DM_ABST_AUTO, RV_ABST_AUTO_EXEC_DATA0) ||
+		!riscv_dm_read(hart->dbg_module, RV_DM_ABST_AUTO, &autoexec))
+		return false;
+	if (!(autoexec & RV_ABST_AUTO_EXEC_DATA0)) {
+		DEBUG_INFO("Hart does not support abstract command autoexec, using single register accesses\n");
+		hart->flags |= RV_HART_FLAG_NO_REG_AUTOEXEC;
+		return false;
+	}
+	return true;
+}
+
+/*
+ * Complete a batched GPR transfer: wait for the last command to finish so that turning autoexec back off
+ * does not collide with it, then report whether every command in the batch succeeded.
+ */
+static bool riscv_gprs_autoexec_complete(riscv_hart_s *const hart, const bool result)
+{
+	const bool complete = riscv_command_wait_complete(hart);
+	if (!riscv_dm_write(hart->dbg_module, RV_DM_ABST_AUTO, 0U))
+		return false;
+	/*
+	 * cmderr is sticky across the batch, so a failure here means one of the commands was not supported
+	 * (regno post-increment is optional) or that the DM was still busy when we accessed DATA0. Only the
+	 * former rules batching out for good, being busy can just be down to this particular run.
+	 */
+	if (!complete && hart->status == RISCV_HART_NOT_SUPP) {
+		DEBUG_INFO("Hart does not support batched register accesses, using single register accesses\n");
+		hart->flags |= RV_HART_FLAG_NO_REG_AUTOEXEC;
+	}
+	return result && complete;
+}
+
+/*
+ * Read x0 through x(count - 1) using a single abstract command that post-increments regno, re-run
+ * by the DM on each read of DATA0 - this makes each GPR after the first cost one or two DMI reads.
+ */
+static bool riscv_gprs_read_batched(riscv_hart_s *const hart, uint32_t *const regs, const size_t count)
+{
+	const size_t words = hart->access_width / 32U;
+	const uint32_t command = RV_DM_ABST_CMD_ACCESS_REG | RV_ABST_READ | RV_REG_XFER | RV_REG_POST_INC |
+		riscv_hart_access_width(hart->access_width) | RV_GPR_BASE;
+	if (!riscv_abstract_command(hart, command) || !riscv_gprs_autoexec_enable(hart))
+		return false;
+	/* Each read of DATA0 hands back the current GPR and kicks off the read of the next one */
+	riscv_dmi_s *const dmi_bus = hart->dbg_module->dmi_bus;
+	dmi_bus->faulted = false;
+	bool result = true;
+	for (size_t gpr = 0; result && gpr + 1U < count; ++gpr)
+		result = riscv_gpr_read_data(hart, regs + gpr * words);
+	/*
+	 * A DATA0 access the transport had to retry may have already triggered autoexec the first time,
+	 * shifting every later GPR by one slot - so give up on the batch if anything at all went wrong
+	 */
+	if (!riscv_gprs_autoexec_complete(hart, result && !dmi_bus->faulted))
+		return false;
+	/* With autoexec off again, grab the final GPR without triggering a further command */
+	return riscv_gpr_read_data(hart, regs + (count - 1U) * words);
+}
+
+/* Write x1 through x(count - 1) using a single abstract command re-run by the DM on each write of DATA0 */
+static bool riscv_gprs_write_batched(riscv_hart_s *const hart, const uint32_t *const regs, const size_t count)
+{
+	const size_t words = hart->access_width / 32U;
+	const uint32_t command = RV_DM_ABST_CMD_ACCESS_REG | RV_ABST_WRITE | RV_REG_XFER | RV_REG_POST_INC |
+		riscv_hart_access_width(hart->access_width) | (RV_GPR_BASE + 1U);
+	if (!riscv_gpr_write_data(hart, regs + words) || !riscv_abstract_command(hart, command) ||
+		!riscv_gprs_autoexec_enable(hart))
+		return false;
+	/* Each write of DATA0 now writes the next GPR */
+	riscv_dmi_s *const dmi_bus = hart->dbg_module->dmi_bus;
+	dmi_bus->faulted = false;
+	bool result = true;
+	for (size_t gpr = 2U; result && gpr < count; ++gpr)
+		result = riscv_gpr_write_data(hart, regs + gpr * words);
+	/* As for reads, a retried DATA0 write may have run the command twice, so redo the lot one at a time */
+	return riscv_gprs_autoexec_complete(hart, result && !dmi_bus->faulted);
+}
+
+static bool riscv_gprs_batched_available(const riscv_hart_s *const hart, const size_t count)
+{
+	/* The register arrays used by the 32- and 64-bit Hart support don't cater to 128-bit GPRs */
+	return !(hart->flags & RV_HART_FLAG_NO_REG_AUTOEXEC) && hart->access_width <= 64U && count > 2U;
+}
+
+/* Read GPRs x0 through x(count - 1) into data, which must be laid out as an array of Hart native width values */
+bool riscv_gprs_read(riscv_hart_s *const hart, void *const data, const size_t count)
+{
+	uint32_t *const regs = (uint32_t *)data;
+	if (riscv_gprs_batched_available(hart, count) && riscv_gprs_read_batched(hart, regs, count))
+		return true;
+	/* Otherwise fall back to reading the GPRs out one at a time */
+	const size_t words = hart->access_width / 32U;
+	for (size_t gpr = 0; gpr < count; ++gpr) {
+		if (!riscv_csr_read(hart, RV_GPR_BASE + gpr, regs + gpr * words)) {
+			/* Make sure the failure is visible to target_check_error() even if it was a DMI fault */
+			if (hart->status == RISCV_HART_NO_ERROR)
+				hart->status = RISCV_HART_OTHER;
+			return false;
+		}
+	}
+	return true;
+}
+
+/* Write GPRs x1 through x(count - 1) from data (laid out as for riscv_gprs_read()), x0 being hard-wired to 0 */
+bool riscv_gprs_write(riscv_hart_s *const hart, const void *const data, const size_t count)
+{
+	const uint32_t *const regs = (const uint32_t *)data;
+	if (riscv_gprs_batched_available(hart, count) && riscv_gprs_write_batched(hart, regs, count))
+		return true;
+	/* Otherwise fall back to writing the GPRs one at a time */
+	const size_t words = hart->access_width / 32U;
+	for (size_t gpr = 1; gpr < count; ++gpr) {
+		if (!riscv_csr_write(hart, RV_GPR_BASE + gpr, regs + gpr * words)) {
+			if (hart->status == RISCV_HART_NO_ERROR)
+				hart->status = RISCV_HART_OTHER;
+			return false;
+		}
+	}
+	return true;
 }
 
 uint8_t riscv_mem_access_width(const riscv_hart_s *const hart, const target_addr_t address, const size_t length)
@@ -706,7 +939,7 @@ static void riscv_hart_discover_triggers(riscv_hart_s *const hart)
 static void riscv_hart_memory_access_type(riscv_hart_s *const hart)
 {
 	uint32_t sysbus_status;
-	hart->flags &= (uint8_t)~RV_HART_FLAG_MEMORY_SYSBUS;
+	hart->flags &= (uint8_t)~(RV_HART_FLAG_MEMORY_SYSBUS | RV_HART_FLAG_SYSBUS_ADDR64);
 	/*
 	 * Try reading the system bus access control and status register.
 	 * Check if the value read back is non-zero for the sbasize field
@@ -716,35 +949,54 @@ static void riscv_hart_memory_access_type(riscv_hart_s *const hart)
 		return;
 	/* If all the checks passed, we now have a valid system bus so can proceed with using it for memory access */
 	hart->flags = RV_HART_FLAG_MEMORY_SYSBUS | (sysbus_status & RV_HART_FLAG_ACCESS_WIDTH_MASK);
+	/* If the bus addresses are wider than 32 bits, the upper address register must be driven too */
+	const uint8_t sysbus_addr_width =
+		(sysbus_status & RV_DM_SYSBUS_STATUS_ADDR_WIDTH_MASK) >> RV_DM_SYSBUS_STATUS_ADDR_WIDTH_SHIFT;
+	if (sysbus_addr_width > 32U)
+		hart->flags |= RV_HART_FLAG_SYSBUS_ADDR64;
 	/* Make sure the system bus is not in any kind of error state */
 	(void)riscv_dm_write(hart->dbg_module, RV_DM_SYSBUS_CTRLSTATUS, 0x00407000U);
 }
 
+/* Convert a breakwatch length in bytes to the mcontrol size field encoding, returning 0 (any) if not encodable */
 riscv_match_size_e riscv_breakwatch_match_size(const size_t size)
 {
 	switch (size) {
-	case 8U:
+	case 1U:
 		return RV_MATCH_SIZE_8_BIT;
-	case 16U:
+	case 2U:
 		return RV_MATCH_SIZE_16_BIT;
-	case 32U:
+	case 4U:
 		return RV_MATCH_SIZE_32_BIT;
-	case 48U:
+	case 6U:
 		return RV_MATCH_SIZE_48_BIT;
-	case 64U:
+	case 8U:
 		return RV_MATCH_SIZE_64_BIT;
-	case 80U:
+	case 10U:
 		return RV_MATCH_SIZE_80_BIT;
-	case 96U:
+	case 12U:
 		return RV_MATCH_SIZE_96_BIT;
-	case 112U:
+	case 14U:
 		return RV_MATCH_SIZE_112_BIT;
-	case 128U:
+	case 16U:
 		return RV_MATCH_SIZE_128_BIT;
 	}
 	return 0;
 }
 
+/*
+ * Convert a breakwatch length in bytes to the mcontrol6 size field encoding, returning 0 (any) if not encodable.
+ * Here 8-, 16- and 32-bit are 1-3, after which each step of 16 bits adds 1.
+ */
+static uint32_t riscv_mcontrol6_match_size(const size_t size)
+{
+	if (size == 1U || size == 2U)
+		return size << RV_MCONTROL6_SIZE_SHIFT;
+	if (size > 16U || (size & 1U) || size < 4U)
+		return 0U;
+	return ((size >> 1U) + 1U) << RV_MCONTROL6_SIZE_SHIFT;
+}
+
 bool riscv_config_trigger(riscv_hart_s *const hart, const uint32_t trigger, const riscv_trigger_state_e mode,
 	const void *const config, const void *const address)
 {
@@ -763,6 +1015,218 @@ bool riscv_config_trigger(riscv_hart_s *const hart, const uint32_t trigger, cons
 	return result;
 }
 
+/* Build the top of tdata1 - the trigger type and (if setting it up) dmode, which sit in the Hart's top 5 bits */
+static uint64_t riscv_trigger_header(const riscv_hart_s *const hart, const uint32_t type, const bool debug_only)
+{
+	const uint64_t header = (uint64_t)type << (hart->access_width - RV_TRIGGER_TYPE_SHIFT);
+	return debug_only ? header | (1ULL << (hart->access_width - RV_TRIGGER_DMODE_SHIFT)) : header;
+}
+
+/*
+ * Find `count` consecutive unused triggers (as chains can only be formed from a trigger to the next one)
+ * that all support one of the address match trigger types, preferring mcontrol over mcontrol6.
+ * Returns the trigger type found, or 0 if none were suitable.
+ */
+static uint32_t riscv_trigger_find(const riscv_hart_s *const hart, const uint32_t count, uint32_t *const first)
+{
+	const uint32_t types[] = {RV_TRIGGER_TYPE_MCONTROL, RV_TRIGGER_TYPE_MCONTROL6};
+	for (size_t idx = 0; idx < ARRAY_LENGTH(types); ++idx) {
+		const uint32_t support = 1U << types[idx];
+		uint32_t run = 0;
+		for (uint32_t trigger = 0; trigger < hart->triggers; ++trigger) {
+			const uint32_t trigger_use = hart->trigger_uses[trigger];
+			/* Make sure it's unused and that it supports the type, restarting the run if not */
+			if ((trigger_use & RV_TRIGGER_MODE_MASK) != RISCV_TRIGGER_MODE_UNUSED || !(trigger_use & support)) {
+				run = 0;
+				continue;
+			}
+			if (++run == count) {
+				*first = trigger + 1U - count;
+				return types[idx];
+			}
+		}
+	}
+	return 0U;
+}
+
+/*
+ * The following can be used as a key for understanding the various return results from the breakwatch functions:
+ * 0 -> success
+ * 1 -> not supported
+ * -1 -> an error occured
+ */
+
+int riscv_breakwatch_set(target_s *const target, breakwatch_s *const breakwatch)
+{
+	riscv_hart_s *const hart = riscv_hart_struct(target);
+	/* Work out what kind of match is needed for the requested breakwatch type */
+	uint32_t match = 0;
+	uint32_t timing = RV_MATCH_BEFORE;
+	riscv_trigger_state_e mode = RISCV_TRIGGER_MODE_WATCHPOINT;
+	switch (breakwatch->type) {
+	case TARGET_BREAK_HARD:
+		match = RV_MATCH_EXECUTE;
+		mode = RISCV_TRIGGER_MODE_BREAKPOINT;
+		break;
+	case TARGET_WATCH_READ:
+		match = RV_MATCH_LOAD;
+		timing = RV_MATCH_AFTER;
+		break;
+	case TARGET_WATCH_WRITE:
+		match = RV_MATCH_STORE;
+		break;
+	case TARGET_WATCH_ACCESS:
+		match = RV_MATCH_LOAD | RV_MATCH_STORE;
+		timing = RV_MATCH_AFTER;
+		break;
+	default:
+		/* If the breakwatch type is not one of the above, tell the debugger we don't support it */
+		return 1;
+	}
+
+	/*
+	 * Watchpoints whose length maps onto a size field encoding get a single trigger matching exactly that
+	 * access size. Anything else (and all breakpoints, where the instruction length is irrelevant) is instead
+	 * matched by the address alone, using a chained pair of triggers covering [addr, addr + size) for watches.
+	 * mcontrol on RV32 Harts can only encode up to 32-bit as the upper size bits don't exist there.
+	 */
+	uint32_t first = 0;
+	uint32_t type = riscv_trigger_find(hart, 1U, &first);
+	uint64_t size = 0;
+	uint32_t count = 1U;
+	if (mode == RISCV_TRIGGER_MODE_WATCHPOINT) {
+		if (type == RV_TRIGGER_TYPE_MCONTROL6)
+			size = riscv_mcontrol6_match_size(breakwatch->size);
+		else if (type == RV_TRIGGER_TYPE_MCONTROL && (hart->access_width == 64U || breakwatch->size <= 4U))
+			size = riscv_breakwatch_match_size(breakwatch->size);
+		/*
+		 * If the size can't be matched exactly, it has to be a range - matching just the start address would
+		 * silently miss accesses to the rest of the watched region, so fail if there's no pair of triggers free
+		 */
+		if (type && !size && breakwatch->size > 1U) {
+			type = riscv_trigger_find(hart, 2U, &first);
+			count = 2U;
+		}
+	}
+	/* If no suitable triggers are available, return an error */
+	if (!type)
+		return -1;
+
+	/* Build the common part of the config, mcontrol6 having lost the timing field */
+	const uint64_t config = riscv_trigger_header(hart, type, true) | RV_MATCH_ANY_MODE | RV_MATCH_ACTION_DEBUG_MODE |
+		match | size | (type == RV_TRIGGER_TYPE_MCONTROL ? timing : 0U);
+	bool result = false;
+	if (count == 1U) {
+		const uint64_t address = breakwatch->addr;
+		result = riscv_config_trigger(hart, first, mode, &config, &address);
+	} else {
+		/* Chain a >= start trigger into a < end trigger so that the pair fires only for accesses in the range */
+		const uint64_t config_start = config | RV_MATCH_CHAIN | RV_MATCH_GREATER_EQUAL;
+		const uint64_t config_end = config | RV_MATCH_LESS_THAN;
+		const uint64_t address_start = breakwatch->addr;
+		const uint64_t address_end = (uint64_t)breakwatch->addr + breakwatch->size;
+		result = riscv_config_trigger(hart, first, mode, &config_start, &address_start) &&
+			riscv_config_trigger(hart, first + 1U, mode, &config_end, &address_end);
+	}
+	/* Store the triggers used in the breakwatch structure, even on failure so they can be released */
+	breakwatch->reserved[0] = first;
+	breakwatch->reserved[1] = count;
+	if (!result) {
+		riscv_breakwatch_clear(target, breakwatch);
+		return -1;
+	}
+	return 0;
+}
+
+int riscv_breakwatch_clear(target_s *const target, breakwatch_s *const breakwatch)
+{
+	riscv_hart_s *const hart = riscv_hart_struct(target);
+	bool result = true;
+	for (uint32_t trigger = breakwatch->reserved[0]; trigger < breakwatch->reserved[0] + breakwatch->reserved[1];
+		 ++trigger) {
+		/* Leave the type in place but clear all the match and action bits to disable the trigger */
+		const uint32_t type = hart->trigger_uses[trigger] & (1U << RV_TRIGGER_TYPE_MCONTROL) ?
+			RV_TRIGGER_TYPE_MCONTROL :
+			RV_TRIGGER_TYPE_MCONTROL6;
+		const uint64_t config = riscv_trigger_header(hart, type, false);
+		const uint64_t address = 0;
+		result &= riscv_config_trigger(hart, trigger, RISCV_TRIGGER_MODE_UNUSED, &config, &address);
+	}
+	return result ? 0 : -1;
+}
+
+/* Check if any of a breakwatch's triggers fired, clearing their (sticky) hit bits if so */
+static bool riscv_trigger_check_hit(riscv_hart_s *const hart, const uint32_t first, const uint32_t count)
+{
+	bool hit = false;
+	for (uint32_t trigger = first; trigger < first + count; ++trigger) {
+		uint64_t config = 0;
+		if (!riscv_csr_write(hart, RV_TRIG_SELECT | RV_CSR_FORCE_32_BIT, &trigger) ||
+			!riscv_csr_read(hart, RV_TRIG_DATA_1, &config))
+			return false;
+		/* Figure out which hit bits to look at from the trigger's type */
+		const uint32_t type = (config >> (hart->access_width - RV_TRIGGER_TYPE_SHIFT)) & 0xfU;
+		const uint64_t hit_mask =
+			type == RV_TRIGGER_TYPE_MCONTROL6 ? RV_MCONTROL6_HIT0 | RV_MCONTROL6_HIT1 : RV_MCONTROL_HIT;
+		if (!(config & hit_mask))
+			continue;
+		hit = true;
+		config &= ~hit_mask;
+		(void)riscv_csr_write(hart, RV_TRIG_DATA_1, &config);
+	}
+	return hit;
+}
+
+static bool riscv_breakwatch_is_watch(const breakwatch_s *const breakwatch)
+{
+	return breakwatch->type == TARGET_WATCH_READ || breakwatch->type == TARGET_WATCH_WRITE ||
+		breakwatch->type == TARGET_WATCH_ACCESS;
+}
+
+/*
+ * Work out which trigger caused the Hart to halt by reading back tdata1 for each one in use in a single pass.
+ * If the hit bits are not implemented, fall back to comparing the PC against the breakpoints,
+ * and assume the watchpoint if there's only one.
+ */
+static target_halt_reason_e riscv_trigger_halt_reason(target_s *const target, target_addr_t *const watch)
+{
+	riscv_hart_s *const hart = riscv_hart_struct(target);
+	const breakwatch_s *triggered = NULL;
+	const breakwatch_s *last_watch = NULL;
+	size_t watches = 0;
+	for (const breakwatch_s *breakwatch = target->bw_list; breakwatch; breakwatch = breakwatch->next) {
+		const bool is_watch = riscv_breakwatch_is_watch(breakwatch);
+		if (!is_watch && breakwatch->type != TARGET_BREAK_HARD)
+			continue;
+		if (is_watch) {
+			last_watch = breakwatch;
+			++watches;
+		}
+		/* Check every breakwatch, even after finding the one that fired, so all the hit bits get cleared */
+		if (riscv_trigger_check_hit(hart, breakwatch->reserved[0], breakwatch->reserved[1]) && !triggered)
+			triggered = breakwatch;
+	}
+
+	if (!triggered) {
+		uint64_t program_counter = 0;
+		if (riscv_csr_read(hart, RV_DPC, &program_counter)) {
+			for (const breakwatch_s *breakwatch = target->bw_list; breakwatch; breakwatch = breakwatch->next) {
+				if (breakwatch->type == TARGET_BREAK_HARD && breakwatch->addr == program_counter)
+					return TARGET_HALT_BREAKPOINT;
+			}
+		}
+		if (watches != 1U)
+			return TARGET_HALT_BREAKPOINT;
+		triggered = last_watch;
+	}
+
+	if (!riscv_breakwatch_is_watch(triggered))
+		return TARGET_HALT_BREAKPOINT;
+	if (watch)
+		*watch = triggered->addr;
+	return TARGET_HALT_WATCHPOINT;
+}
+
 static bool riscv_attach(target_s *const target)
 {
 	riscv_hart_s *const hart = riscv_hart_struct(target);
@@ -808,8 +1272,10 @@ static bool riscv_dm_poll_state(riscv_dm_s *const dbg_module, const uint32_t sta
 static void riscv_halt_request(target_s *const target)
 {
 	riscv_hart_s *const hart = riscv_hart_struct(target);
+	/* If the DM can, halt all its Harts together so the whole system stops at once */
+	const uint32_t group = (hart->dbg_module->flags & RV_DM_FLAG_HART_ARRAY) ? RV_DM_CTRL_HASEL : 0U;
 	/* Request the hart to halt */
-	if (!riscv_dm_write(hart->dbg_module, RV_DM_CONTROL, hart->hartsel | RV_DM_CTRL_HALT_REQ))
+	if (!riscv_dm_write(hart->dbg_module, RV_DM_CONTROL, hart->hartsel | group | RV_DM_CTRL_HALT_REQ))
 		return;
 	/* Poll for the hart to become halted */
 	if (!riscv_dm_poll_state(hart->dbg_module, RV_DM_STAT_ALL_HALTED))
@@ -818,6 +1284,22 @@ static void riscv_halt_request(target_s *const target)
 	(void)riscv_dm_write(hart->dbg_module, RV_DM_CONTROL, hart->hartsel);
 }
 
+/* Request the selected Hart(s) resume, where group is RV_DM_CTRL_HASEL to resume the DM's Harts together */
+static bool riscv_hart_resume(riscv_hart_s *const hart, const uint32_t group)
+{
+	/* Request the hart to resume */
+	if (!riscv_dm_write(hart->dbg_module, RV_DM_CONTROL, hart->hartsel | group | RV_DM_CTRL_RESUME_REQ))
+		return false;
+	/*
+	 * Poll for the hart to become resumed. A group member that was already running never acknowledges,
+	 * so for a group resume it's enough that any of them did
+	 */
+	const bool resumed =
+		riscv_dm_poll_state(hart->dbg_module, group ? RV_DM_STAT_ANY_RESUME_ACK : RV_DM_STAT_ALL_RESUME_ACK);
+	/* Clear the request, even if it timed out, so it is not left pending in dmcontrol */
+	return riscv_dm_write(hart->dbg_module, RV_DM_CONTROL, hart->hartsel) && resumed;
+}
+
 static void riscv_halt_resume(target_s *target, const bool step)
 {
 	riscv_hart_s *const hart = riscv_hart_struct(target);
@@ -831,27 +1313,41 @@ static void riscv_halt_resume(target_s *target, const bool step)
 		stepping_config &= ~(RV_DCSR_STEP | RV_DCSR_STEPIE);
 	if (!riscv_csr_write(hart, RV_DCSR | RV_CSR_FORCE_32_BIT, &stepping_config))
 		return;
-	/* Request the hart to resume */
-	if (!riscv_dm_write(hart->dbg_module, RV_DM_CONTROL, hart->hartsel | RV_DM_CTRL_RESUME_REQ))
-		return;
-	/* Poll for the hart to become resumed */
-	if (!riscv_dm_poll_state(hart->dbg_module, RV_DM_STAT_ALL_RESUME_ACK))
-		return;
-	/* Clear the request now we've got it resumed */
-	(void)riscv_dm_write(hart->dbg_module, RV_DM_CONTROL, hart->hartsel);
+	/* Unless we're single-stepping this Hart, resume all the DM's Harts together if we can */
+	const uint32_t group = !step && (hart->dbg_module->flags & RV_DM_FLAG_HART_ARRAY) ? RV_DM_CTRL_HASEL : 0U;
+	if (!riscv_hart_resume(hart, group))
+		DEBUG_WARN("Hart failed to resume\n");
 }
 
 static target_halt_reason_e riscv_halt_poll(target_s *const target, target_addr_t *const watch)
 {
-	(void)watch;
 	riscv_hart_s *const hart = riscv_hart_struct(target);
+	riscv_dm_s *const dbg_module = hart->dbg_module;
 	uint32_t status = 0;
-	/* Check if the hart is currently halted */
-	if (!riscv_dm_read(hart->dbg_module, RV_DM_STATUS, &status))
-		return TARGET_HALT_ERROR;
-	/* If the hart is currently running, exit out early */
-	if (!(status & RV_DM_STAT_ALL_HALTED))
-		return TARGET_HALT_RUNNING;
+	if (dbg_module->flags & RV_DM_FLAG_HALT_SUMMARY) {
+		/* Check the halt summary for if the hart is currently halted, exiting out early if it's running */
+		if (!riscv_dm_read(dbg_module, RV_DM_HALT_SUMMARY, &status))
+			return TARGET_HALT_ERROR;
+		if (!(status & (1U << hart->hart_idx)))
+			return TARGET_HALT_RUNNING;
+		/* Another Hart may have been selected since, so make sure it's this one we're asking about */
+		if (!riscv_dm_write(dbg_module, RV_DM_CONTROL, hart->hartsel))
+			return TARGET_HALT_ERROR;
+		/*
+		 * If the DM can halt its Harts together, stop the rest of them too so the whole system is stopped
+		 * while we look at it, and they can all be resumed together afterwards
+		 */
+		const uint32_t harts_mask = riscv_dm_harts_mask(dbg_module);
+		if ((dbg_module->flags & RV_DM_FLAG_HART_ARRAY) && (status & harts_mask) != harts_mask)
+			riscv_halt_request(target);
+	} else {
+		/* Check if the hart is currently halted */
+		if (!riscv_dm_read(dbg_module, RV_DM_STATUS, &status))
+			return TARGET_HALT_ERROR;
+		/* If the hart is currently running, exit out early */
+		if (!(status & RV_DM_STAT_ALL_HALTED))
+			return TARGET_HALT_RUNNING;
+	}
 	/* Read out DCSR to find out why we're halted */
 	if (!riscv_csr_read(hart, RV_DCSR, &status))
 		return TARGET_HALT_ERROR;
@@ -859,8 +1355,7 @@ static target_halt_reason_e riscv_halt_poll(target_s *const target, target_addr_
 	/* Dispatch on the cause code */
 	switch (status) {
 	case RV_HALT_CAUSE_TRIGGER:
-		/* XXX: Need to read out the triggers to find the one causing this, and grab the watch value */
-		return TARGET_HALT_BREAKPOINT;
+		return riscv_trigger_halt_reason(target, watch);
 	case RV_HALT_CAUSE_STEP:
 		return TARGET_HALT_STEPPING;
 	default:
@@ -870,6 +1365,86 @@ static target_halt_reason_e riscv_halt_poll(target_s *const target, target_addr_
 	return TARGET_HALT_REQUEST;
 }
 
+/* Write a 32-bit value into a Hart native width register, zero extending it */
+static bool riscv_stub_reg_write(riscv_hart_s *const hart, const uint16_t reg, const uint32_t value)
+{
+	const uint32_t data[4] = {value};
+	return riscv_csr_write(hart, reg, data);
+}
+
+/*
+ * Load and run a stub on the Hart, returning its a0 in result. The stub is written to loadaddr and followed by an
+ * ebreak which ra is pointed at, so the stub may either return normally or execute an ebreak itself. Up to 4
+ * arguments are passed in a0-a3. As with the Cortex-M stubs, the stack may not be available and must not be used.
+ */
+bool riscv_run_stub(target_s *const target, const uint32_t loadaddr, const void *const stub, const size_t stub_length,
+	const uint32_t a0, const uint32_t a1, const uint32_t a2, const uint32_t a3, uint32_t *const result)
+{
+	riscv_hart_s *const hart = riscv_hart_struct(target);
+	/* Load the stub followed by the ebreak for it to return to */
+	const uint32_t return_addr = ALIGN(loadaddr + stub_length, 4U);
+	const uint32_t ebreak = RV_INSN_EBREAK;
+	if (target_mem_write(target, loadaddr, stub, stub_length) ||
+		target_mem_write(target, return_addr, &ebreak, sizeof(ebreak)))
+		return false;
+
+	/* Make ebreak drop the Hart back into Debug Mode, whatever privilege mode it's in, rather than trapping */
+	uint32_t dcsr = 0U;
+	if (!riscv_csr_read(hart, RV_DCSR | RV_CSR_FORCE_32_BIT, &dcsr))
+		return false;
+	const uint32_t stub_dcsr =
+		(dcsr & ~(RV_DCSR_STEP | RV_DCSR_STEPIE)) | RV_DCSR_EBREAKM | RV_DCSR_EBREAKS | RV_DCSR_EBREAKU;
+	if (!riscv_csr_write(hart, RV_DCSR | RV_CSR_FORCE_32_BIT, &stub_dcsr))
+		return false;
+
+	/* Load the arguments, return address and entry point, then set the stub running */
+	const uint32_t args[4] = {a0, a1, a2, a3};
+	bool success = true;
+	for (uint16_t arg = 0U; success && arg < 4U; ++arg)
+		success = riscv_stub_reg_write(hart, RV_GPR_BASE + RV_GPR_A0 + arg, args[arg]);
+	if (success && riscv_stub_reg_write(hart, RV_GPR_BASE + RV_GPR_RA, return_addr) &&
+		riscv_stub_reg_write(hart, RV_DPC, loadaddr) && riscv_hart_resume(hart, 0U)) {
+
+		/* Wait for the stub to finish, backing off the polling so longer-running stubs don't keep the DMI busy */
+		platform_timeout_s timeout;
+		platform_timeout_set(&timeout, RV_STUB_TIMEOUT);
+		/* Only this Hart is resumed, so the DM status can be used to check on it */
+		uint32_t delay = 1U;
+		uint32_t status = 0U;
+		while (success && !(status & RV_DM_STAT_ALL_HALTED)) {
+			success = riscv_dm_read(hart->dbg_module, RV_DM_STATUS, &status);
+			if (success && !(status & RV_DM_STAT_ALL_HALTED)) {
+				if (platform_timeout_is_expired(&timeout)) {
+					DEBUG_WARN("Stub hung\n");
+					riscv_halt_request(target);
+					success = false;
+					break;
+				}
+				platform_delay(delay);
+				if (delay < RV_STUB_POLL_DELAY_MAX)
+					delay <<= 1U;
+			}
+		}
+
+		/* Check the Hart halted because of an ebreak, and if it did, read back the result */
+		uint32_t cause = 0U;
+		success = success && riscv_csr_read(hart, RV_DCSR | RV_CSR_FORCE_32_BIT, &cause);
+		if (success && (cause & RV_DCSR_CAUSE_MASK) != RV_HALT_CAUSE_EBREAK) {
+			DEBUG_WARN("Stub halted with unexpected cause %" PRIu32 "\n", (cause & RV_DCSR_CAUSE_MASK) >> 6U);
+			success = false;
+		}
+		uint32_t value[4] = {0U};
+		success = success && riscv_csr_read(hart, RV_GPR_BASE + RV_GPR_A0, value);
+		*result = value[0];
+	} else
+		success = false;
+
+	/* Put the ebreak handling back how it was */
+	if (!riscv_csr_write(hart, RV_DCSR | RV_CSR_FORCE_32_BIT, &dcsr))
+		return false;
+	return success;
+}
+
 /* Do note that this can be used with a riscv_halt_request() call to initiate halt-on-reset debugging */
 static void riscv_reset(target_s *const target)
 {
@@ -37,6 +37,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "target.h"
+#include "target_internal.h"
 
 typedef enum riscv_debug_version {
 	RISCV_DEBUG_UNKNOWN,
@@ -92,8 +93,11 @@ typedef enum riscv_match_size {
 #define RV_HART_FLAG_ACCESS_WIDTH_16BIT 0x02U
 #define RV_HART_FLAG_ACCESS_WIDTH_32BIT 0x04U
 #define RV_HART_FLAG_ACCESS_WIDTH_64BIT 0x08U
+#define RV_HART_FLAG_NO_REG_AUTOEXEC    0x20U
+#define RV_HART_FLAG_SYSBUS_ADDR64      0x40U
 
 typedef struct riscv_dmi riscv_dmi_s;
+typedef struct riscv_hart riscv_hart_s;
 
 /* This structure represents a version-agnostic Debug Module Interface on a RISC-V device */
 struct riscv_dmi {
@@ -106,11 +110,17 @@ struct riscv_dmi {
 	uint8_t idle_cycles;
 	uint8_t address_width;
 	uint8_t fault;
+	/* Sticky: set on any DMI status other than success, including ones the transport retried */
+	bool faulted;
 
 	void (*prepare)(target_s *target);
 	void (*quiesce)(target_s *target);
 	bool (*read)(riscv_dmi_s *dmi, uint32_t address, uint32_t *value);
 	bool (*write)(riscv_dmi_s *dmi, uint32_t address, uint32_t value);
+	/* Optional accelerated routines for running an abstract command and for 32-bit Hart memory access */
+	bool (*abstract_command)(riscv_hart_s *hart, uint32_t command);
+	void (*mem_read)(riscv_hart_s *hart, void *dest, target_addr_t src, size_t len);
+	void (*mem_write)(riscv_hart_s *hart, target_addr_t dest, const void *src, size_t len);
 };
 
 /* This represents a specific Debug Module on the DMI bus */
@@ -120,12 +130,18 @@ typedef struct riscv_dm {
 	riscv_dmi_s *dmi_bus;
 	uint32_t base;
 	riscv_debug_version_e version;
+	uint32_t hart_count;
+	uint8_t flags;
 } riscv_dm_s;
 
+/* These defines specify DM-wide capabilities for dealing with several Harts at once */
+#define RV_DM_FLAG_HALT_SUMMARY 0x01U
+#define RV_DM_FLAG_HART_ARRAY   0x02U
+
 #define RV_TRIGGERS_MAX 8U
 
 /* This represents a specifc Hart on a DM */
-typedef struct riscv_hart {
+struct riscv_hart {
 	riscv_dm_s *dbg_module;
 	uint32_t hart_idx;
 	uint32_t hartsel;
@@ -142,7 +158,7 @@ typedef struct riscv_hart {
 
 	uint32_t triggers;
 	uint32_t trigger_uses[RV_TRIGGERS_MAX];
-} riscv_hart_s;
+};
 
 #define RV_STATUS_VERSION_MASK 0x0000000fU
 
@@ -152,6 +168,7 @@ typedef struct riscv_hart {
 #define RV_DM_DATA3             0x07U
 #define RV_DM_ABST_CTRLSTATUS   0x16U
 #define RV_DM_ABST_COMMAND      0x17U
+#define RV_DM_ABST_AUTO         0x18U
 #define RV_DM_SYSBUS_CTRLSTATUS 0x38U
 #define RV_DM_SYSBUS_ADDR0      0x39U
 #define RV_DM_SYSBUS_ADDR1      0x3aU
@@ -167,6 +184,9 @@ typedef struct riscv_hart {
 #define RV_REG_ACCESS_32_BIT  0x00200000U
 #define RV_REG_ACCESS_64_BIT  0x00300000U
 #define RV_REG_ACCESS_128_BIT 0x00400000U
+#define RV_REG_POST_INC       0x00080000U
+
+#define RV_ABST_AUTO_EXEC_DATA0 0x00000001U
 
 #define RV_MEM_ACCESS_8_BIT   0x0U
 #define RV_MEM_ACCESS_16_BIT  0x1U
@@ -215,22 +235,38 @@ typedef struct riscv_hart {
 #define RV_CSR_MIP        0x344
 
 void riscv_jtag_dtm_handler(uint8_t dev_index);
+#if PC_HOSTED == 0
+void riscv_jtag_dmi_setup(riscv_dmi_s *dmi);
+#else
+void bmda_riscv_jtag_dtm_init(riscv_dmi_s *dmi);
+#endif
 void riscv_dmi_init(riscv_dmi_s *dmi);
 riscv_hart_s *riscv_hart_struct(target_s *target);
 
 bool riscv_dm_read(riscv_dm_s *dbg_module, uint8_t address, uint32_t *value);
 bool riscv_dm_write(riscv_dm_s *dbg_module, uint8_t address, uint32_t value);
 bool riscv_command_wait_complete(riscv_hart_s *hart);
+bool riscv_abstract_command(riscv_hart_s *hart, uint32_t command);
 bool riscv_csr_read(riscv_hart_s *hart, uint16_t reg, void *data);
 bool riscv_csr_write(riscv_hart_s *hart, uint16_t reg, const void *data);
+bool riscv_gprs_read(riscv_hart_s *hart, void *data, size_t count);
+bool riscv_gprs_write(riscv_hart_s *hart, const void *data, size_t count);
 riscv_match_size_e riscv_breakwatch_match_size(size_t size);
 bool riscv_config_trigger(
 	riscv_hart_s *hart, uint32_t trigger, riscv_trigger_state_e mode, const void *config, const void *address);
+int riscv_breakwatch_set(target_s *target, breakwatch_s *breakwatch);
+int riscv_breakwatch_clear(target_s *target, breakwatch_s *breakwatch);
+bool riscv_run_stub(target_s *target, uint32_t loadaddr, const void *stub, size_t stub_length, uint32_t a0,
+	uint32_t a1, uint32_t a2, uint32_t a3, uint32_t *result);
 
 uint8_t riscv_mem_access_width(const riscv_hart_s *hart, target_addr_t address, size_t length);
 void riscv32_unpack_data(void *dest, uint32_t data, uint8_t access_width);
 uint32_t riscv32_pack_data(const void *src, uint8_t access_width);
+void riscv64_unpack_data(void *dest, uint32_t data_low, uint32_t data_high, uint8_t access_width);
+void riscv64_pack_data(const void *src, uint8_t access_width, uint32_t *data_low, uint32_t *data_high);
 
+void riscv_hart_mem_read(riscv_hart_s *hart, void *dest, target_addr_t src, size_t len);
+void riscv_hart_mem_write(riscv_hart_s *hart, target_addr_t dest, const void *src, size_t len);
 void riscv32_mem_read(target_s *target, void *dest, target_addr_t src, size_t len);
 void riscv32_mem_write(target_s *target, target_addr_t dest, const void *src, size_t len);
 
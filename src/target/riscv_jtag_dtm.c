@@ -112,10 +112,27 @@ static void riscv_jtag_dtm_init(riscv_dmi_s *const dmi)
 	dmi->quiesce = riscv_jtag_quiesce;
 	dmi->read = riscv_jtag_dmi_read;
 	dmi->write = riscv_jtag_dmi_write;
+#if PC_HOSTED == 1
+	bmda_riscv_jtag_dtm_init(dmi);
+#endif
 
 	riscv_dmi_init(dmi);
 }
 
+#if PC_HOSTED == 0
+/*
+ * Set up a DMI structure for use by the remote protocol. The host has already discovered the DTM,
+ * filling in the device index, idle cycles and address width, and keeps the TAP in DMI mode around
+ * its requests - so we only have to make our view of the IR agree and wire up the access routines.
+ */
+void riscv_jtag_dmi_setup(riscv_dmi_s *const dmi)
+{
+	jtag_devs[dmi->dev_index].current_ir = IR_DMI;
+	dmi->read = riscv_jtag_dmi_read;
+	dmi->write = riscv_jtag_dmi_write;
+}
+#endif
+
 /* Shift (read + write) the Debug Transport Module Control/Status (DTMCS) register */
 uint32_t riscv_shift_dtmcs(const riscv_dmi_s *const dmi, const uint32_t control)
 {
@@ -178,6 +195,8 @@ static bool riscv_dmi_transfer(riscv_dmi_s *const dmi, const uint8_t operation,
 	}
 
 	dmi->fault = status;
+	if (status != RV_DMI_SUCCESS)
+		dmi->faulted = true;
 	/* If we get straight failure, do a DMI reset */
 	if (status == RV_DMI_FAILURE || status == RV_DMI_TOO_SOON)
 		riscv_dmi_reset(dmi);
@@ -0,0 +1,462 @@
+/*
+ * This file is part of the Black Magic Debug project.
+ *
+ * Copyright (C) 2023 1BitSquared <info@1bitsquared.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * This file implements the memory access machinery shared between RV32 and RV64 Harts,
+ * both via the abstract command interface and via the system bus when the DM provides one.
+ */
+
+#include "general.h"
+#include "target.h"
+#include "target_internal.h"
+#include "riscv_debug.h"
+
+/* Takes in data from abstract command arg0 and, based on the access width, unpacks it to dest */
+void riscv32_unpack_data(void *const dest, const uint32_t data, const uint8_t access_width)
+{
+	switch (access_width) {
+	case RV_MEM_ACCESS_8_BIT: {
+		const uint8_t value = data & 0xffU;
+		memcpy(dest, &value, sizeof(value));
+		break;
+	}
+	case RV_MEM_ACCESS_16_BIT: {
+		const uint16_t value = data & 0xffffU;
+		memcpy(dest, &value, sizeof(value));
+		break;
+	}
+	case RV_MEM_ACCESS_32_BIT:
+		memcpy(dest, &data, sizeof(data));
+		break;
+	}
+}
+
+/* Takes in data from src, based on the access width, to be written to abstract command arg0 and packs it */
+uint32_t riscv32_pack_data(const void *const src, const uint8_t access_width)
+{
+	switch (access_width) {
+	case RV_MEM_ACCESS_8_BIT: {
+		uint8_t value = 0;
+		memcpy(&value, src, sizeof(value));
+		return value;
+	}
+	case RV_MEM_ACCESS_16_BIT: {
+		uint16_t value = 0;
+		memcpy(&value, src, sizeof(value));
+		return value;
+	}
+	case RV_MEM_ACCESS_32_BIT: {
+		uint32_t value = 0;
+		memcpy(&value, src, sizeof(value));
+		return value;
+	}
+	}
+	return 0;
+}
+
+/* Takes in data from abstract command arg0 and, based on the access width, unpacks it to dest */
+void riscv64_unpack_data(
+	void *const dest, const uint32_t data_low, const uint32_t data_high, const uint8_t access_width)
+{
+	switch (access_width) {
+	/* If the access was 32-bit or less, ignore data_high and delegate to the RV32 version of this function */
+	case RV_MEM_ACCESS_8_BIT:
+	case RV_MEM_ACCESS_16_BIT:
+	case RV_MEM_ACCESS_32_BIT:
+		riscv32_unpack_data(dest, data_low, access_width);
+		break;
+	case RV_MEM_ACCESS_64_BIT: {
+		/* Reconstruct the 64-bit value and copy it into the destination */
+		const uint64_t value = ((uint64_t)data_high << 32U) | data_low;
+		memcpy(dest, &value, sizeof(value));
+		break;
+	}
+	}
+}
+
+/* Takes in data from src, based on the access width, and packs it into the low and high halves of arg0 */
+void riscv64_pack_data(
+	const void *const src, const uint8_t access_width, uint32_t *const data_low, uint32_t *const data_high)
+{
+	if (access_width == RV_MEM_ACCESS_64_BIT) {
+		uint64_t value = 0;
+		memcpy(&value, src, sizeof(value));
+		*data_low = (uint32_t)value;
+		*data_high = (uint32_t)(value >> 32U);
+	} else {
+		*data_low = riscv32_pack_data(src, access_width);
+		*data_high = 0U;
+	}
+}
+
+/*
+ * Abstract memory accesses take the address in arg1, which for a 32-bit Hart is DATA1,
+ * and for a 64-bit Hart is DATA2 (low half) and DATA3 (high half)
+ */
+static bool riscv_abstract_mem_address(riscv_hart_s *const hart, const target_addr_t address)
+{
+	if (hart->access_width == 64U)
+		return riscv_dm_write(hart->dbg_module, RV_DM_DATA2, address) &&
+			riscv_dm_write(hart->dbg_module, RV_DM_DATA3, 0U);
+	return riscv_dm_write(hart->dbg_module, RV_DM_DATA1, address);
+}
+
+static void riscv_abstract_mem_read(
+	riscv_hart_s *const hart, void *const dest, const target_addr_t src, const size_t len)
+{
+	/* Figure out the maximal width of access to perform, up to the bitness of the target */
+	const uint8_t access_width = riscv_mem_access_width(hart, src, len);
+	const uint8_t access_length = 1U << access_width;
+	/* Build the access command */
+	const uint32_t command = RV_DM_ABST_CMD_ACCESS_MEM | RV_ABST_READ | (access_width << RV_ABST_MEM_ACCESS_SHIFT) |
+		(access_length < len ? RV_ABST_MEM_ADDR_POST_INC : 0U);
+	/* Write the address to read to arg1 */
+	if (!riscv_abstract_mem_address(hart, src))
+		return;
+	uint8_t *const data = (uint8_t *)dest;
+	for (size_t offset = 0; offset < len; offset += access_length) {
+		/* Execute the read */
+		if (!riscv_abstract_command(hart, command))
+			return;
+		/* Extract back the data from arg0, only touching the high half for 64-bit accesses */
+		uint32_t value_low = 0;
+		uint32_t value_high = 0;
+		if (!riscv_dm_read(hart->dbg_module, RV_DM_DATA0, &value_low) ||
+			(access_width == RV_MEM_ACCESS_64_BIT && !riscv_dm_read(hart->dbg_module, RV_DM_DATA1, &value_high)))
+			return;
+		riscv64_unpack_data(data + offset, value_low, value_high, access_width);
+	}
+}
+
+static void riscv_abstract_mem_write(
+	riscv_hart_s *const hart, const target_addr_t dest, const void *const src, const size_t len)
+{
+	/* Figure out the maxmial width of access to perform, up to the bitness of the target */
+	const uint8_t access_width = riscv_mem_access_width(hart, dest, len);
+	const uint8_t access_length = 1U << access_width;
+	/* Build the access command */
+	const uint32_t command = RV_DM_ABST_CMD_ACCESS_MEM | RV_ABST_WRITE | (access_width << RV_ABST_MEM_ACCESS_SHIFT) |
+		(access_length < len ? RV_ABST_MEM_ADDR_POST_INC : 0U);
+	/* Write the address to write to arg1 */
+	if (!riscv_abstract_mem_address(hart, dest))
+		return;
+	const uint8_t *const data = (const uint8_t *)src;
+	for (size_t offset = 0; offset < len; offset += access_length) {
+		/* Pack the data to write into arg0 */
+		uint32_t value_low = 0;
+		uint32_t value_high = 0;
+		riscv64_pack_data(data + offset, access_width, &value_low, &value_high);
+		if ((access_width == RV_MEM_ACCESS_64_BIT && !riscv_dm_write(hart->dbg_module, RV_DM_DATA1, value_high)) ||
+			!riscv_dm_write(hart->dbg_module, RV_DM_DATA0, value_low))
+			return;
+		/* Execute the write */
+		if (!riscv_abstract_command(hart, command))
+			return;
+	}
+}
+
+static void riscv_sysbus_check(riscv_hart_s *const hart)
+{
+	uint32_t status = 0;
+	/* Read back the system bus status */
+	if (!riscv_dm_read(hart->dbg_module, RV_DM_SYSBUS_CTRLSTATUS, &status))
+		return;
+	/* Store the result and reset the value in the control/status register */
+	hart->status = (status >> 12U) & RISCV_HART_OTHER;
+	if (!riscv_dm_write(hart->dbg_module, RV_DM_SYSBUS_CTRLSTATUS, RISCV_HART_OTHER << 12U))
+		return;
+	/* If something goes wrong, tell the user */
+	if (hart->status != RISCV_HART_NO_ERROR)
+		DEBUG_WARN("memory access failed: %u\n", hart->status);
+}
+
+/*
+ * Set up the system bus address for an access. If the bus is wider than 32 bits, the high half
+ * must be written first as writing the low half is what triggers any read-on-address access
+ */
+static bool riscv_sysbus_address(riscv_hart_s *const hart, const target_addr_t address)
+{
+	if ((hart->flags & RV_HART_FLAG_SYSBUS_ADDR64) && !riscv_dm_write(hart->dbg_module, RV_DM_SYSBUS_ADDR1, 0U))
+		return false;
+	return riscv_dm_write(hart->dbg_module, RV_DM_SYSBUS_ADDR0, address);
+}
+
+/*
+ * Figure out the maximal width of access to perform on the system bus. This starts from the widest
+ * naturally aligned access up to the bitness of the target, then is capped at the widest access the
+ * bus actually supports so, for example, 64-bit accesses on a 32-bit-only bus get split into pairs
+ * of 32-bit accesses rather than being widened to something that doesn't exist
+ */
+static uint8_t riscv_sysbus_access_width(const riscv_hart_s *const hart, const target_addr_t address, const size_t len)
+{
+	uint8_t access_width = riscv_mem_access_width(hart, address, len);
+	const uint8_t supported = hart->flags & RV_HART_FLAG_ACCESS_WIDTH_MASK;
+	/* If the bus supports nothing at or above the requested width, step down to the widest it does support */
+	if (supported && !(supported >> access_width)) {
+		while (!((supported >> access_width) & 1U))
+			--access_width;
+	}
+	return access_width;
+}
+
+static void riscv_sysbus_mem_native_read(riscv_hart_s *const hart, void *const dest, const target_addr_t src,
+	const size_t len, const uint8_t access_width, const uint8_t access_length)
+{
+	/* Build the access command */
+	const uint32_t command = ((uint32_t)access_width << RV_SYSBUS_MEM_ACCESS_SHIFT) | RV_SYSBUS_MEM_READ_ON_ADDR |
+		(access_length < len ? RV_SYSBUS_MEM_ADDR_POST_INC | RV_SYSBUS_MEM_READ_ON_DATA : 0U);
+	/*
+	 * Write the command setup to the access control register
+	 * Then set up the read by writing the address to the address register
+	 */
+	if (!riscv_dm_write(hart->dbg_module, RV_DM_SYSBUS_CTRLSTATUS, command) || !riscv_sysbus_address(hart, src))
+		return;
+	uint8_t *const data = (uint8_t *)dest;
+	for (size_t offset = 0; offset < len; offset += access_length) {
+		uint32_t status = RV_SYSBUS_STATUS_BUSY;
+		/* Wait for the current read cycle to complete */
+		while (status & RV_SYSBUS_STATUS_BUSY) {
+			if (!riscv_dm_read(hart->dbg_module, RV_DM_SYSBUS_CTRLSTATUS, &status))
+				return;
+		}
+		/* If this would be the last read, clean up the access control register */
+		if (offset + access_length == len && (command & RV_SYSBUS_MEM_ADDR_POST_INC)) {
+			if (!riscv_dm_write(hart->dbg_module, RV_DM_SYSBUS_CTRLSTATUS, 0))
+				return;
+		}
+		/*
+		 * Read back and unpack the data for this block. For 64-bit accesses, the high half has to be read
+		 * first as reading the low half is what triggers the next read-on-data access
+		 */
+		uint32_t value_low = 0;
+		uint32_t value_high = 0;
+		if ((access_width == RV_MEM_ACCESS_64_BIT &&
+				!riscv_dm_read(hart->dbg_module, RV_DM_SYSBUS_DATA1, &value_high)) ||
+			!riscv_dm_read(hart->dbg_module, RV_DM_SYSBUS_DATA0, &value_low))
+			return;
+		riscv64_unpack_data(data + offset, value_low, value_high, access_width);
+	}
+	riscv_sysbus_check(hart);
+}
+
+static void riscv_sysbus_mem_adjusted_read(riscv_hart_s *const hart, void *const dest, const target_addr_t src,
+	const uint8_t access_length, const uint8_t access_width, const uint8_t native_access_length)
+{
+	/*
+	 * Run a single native read of the aligned block containing the requested bytes into a scratch buffer
+	 * large enough for the widest (64-bit) access, then copy out just the part that was asked for
+	 */
+	uint8_t value[8U] = {0};
+	const target_addr_t offset = src & (native_access_length - 1U);
+	riscv_sysbus_mem_native_read(hart, value, src - offset, native_access_length, access_width, native_access_length);
+	memcpy(dest, value + offset, access_length);
+}
+
+static void riscv_sysbus_mem_read(
+	riscv_hart_s *const hart, void *const dest, const target_addr_t src, const size_t len)
+{
+	/* Figure out the maxmial width of access to perform, up to what the bus supports */
+	const uint8_t access_width = riscv_sysbus_access_width(hart, src, len);
+	const uint8_t access_length = (uint8_t)(1U << access_width);
+	/* Check if the access is a natural/native width */
+	if (hart->flags & access_length) {
+		riscv_sysbus_mem_native_read(hart, dest, src, len, access_width, access_length);
+		return;
+	}
+
+	/* If we were unable to do this using a native access, find the next largest supported access width */
+	uint8_t native_access_width = access_width;
+	while (!((hart->flags >> native_access_width) & 1U) && native_access_width < RV_MEM_ACCESS_64_BIT)
+		++native_access_width;
+	const uint8_t native_access_length = (uint8_t)(1U << native_access_width);
+
+	/* Figure out how much the length is getting adjusted by in the first read to make it aligned */
+	const target_addr_t length_adjustment = src & (native_access_length - 1U);
+	/*
+	 * Having done this, figure out how long the resulting read actually is so we can fill enough of the
+	 * destination buffer with a single read
+	 */
+	const uint8_t read_length =
+		len + length_adjustment <= native_access_length ? len : native_access_length - length_adjustment;
+
+	/* Do the initial adjusted access */
+	size_t remainder = len;
+	target_addr_t address = src;
+	uint8_t *data = (uint8_t *)dest;
+	riscv_sysbus_mem_adjusted_read(hart, data, address, read_length, native_access_width, native_access_length);
+
+	/* After doing the initial access, adjust the location of the next and do any follow-up accesses required */
+	remainder -= read_length;
+	address += read_length;
+	data += read_length;
+
+	/*
+	 * Now we're aligned to the wider access width, do another set of reads if there's
+	 * any remainder. Do this till we either reach nothing left, or we have another small left-over amount
+	 */
+	if (!remainder)
+		return;
+	const size_t amount = remainder & ~(native_access_length - 1U);
+	if (amount)
+		riscv_sysbus_mem_native_read(hart, data, address, amount, native_access_width, native_access_length);
+	remainder -= amount;
+	address += (uint32_t)amount;
+	data += amount;
+
+	/* If there's any data left to read, do another adjusted access to grab it */
+	if (remainder)
+		riscv_sysbus_mem_adjusted_read(hart, data, address, remainder, native_access_width, native_access_length);
+}
+
+static void riscv_sysbus_mem_native_write(riscv_hart_s *const hart, const target_addr_t dest, const void *const src,
+	const size_t len, const uint8_t access_width, const uint8_t access_length)
+{
+	/* Build the access command */
+	const uint32_t command = ((uint32_t)access_width << RV_SYSBUS_MEM_ACCESS_SHIFT) |
+		(access_length < len ? RV_SYSBUS_MEM_ADDR_POST_INC : 0U);
+	/*
+	 * Write the command setup to the access control register
+	 * Then set up the write by writing the address to the address register
+	 */
+	if (!riscv_dm_write(hart->dbg_module, RV_DM_SYSBUS_CTRLSTATUS, command) || !riscv_sysbus_address(hart, dest))
+		return;
+	const uint8_t *const data = (const uint8_t *)src;
+	for (size_t offset = 0; offset < len; offset += access_length) {
+		/*
+		 * Pack the data for this block and write it. For 64-bit accesses, the high half has to be written
+		 * first as writing the low half is what triggers the bus access
+		 */
+		uint32_t value_low = 0;
+		uint32_t value_high = 0;
+		riscv64_pack_data(data + offset, access_width, &value_low, &value_high);
+		if ((access_width == RV_MEM_ACCESS_64_BIT &&
+				!riscv_dm_write(hart->dbg_module, RV_DM_SYSBUS_DATA1, value_high)) ||
+			!riscv_dm_write(hart->dbg_module, RV_DM_SYSBUS_DATA0, value_low))
+			return;
+
+		uint32_t status = RV_SYSBUS_STATUS_BUSY;
+		/* Wait for the current write cycle to complete */
+		while (status & RV_SYSBUS_STATUS_BUSY) {
+			if (!riscv_dm_read(hart->dbg_module, RV_DM_SYSBUS_CTRLSTATUS, &status))
+				return;
+		}
+	}
+	riscv_sysbus_check(hart);
+}
+
+static void riscv_sysbus_mem_adjusted_write(riscv_hart_s *const hart, const target_addr_t dest, const void *const src,
+	const uint8_t access_length, const uint8_t access_width, const uint8_t native_access_length)
+{
+	/*
+	 * The basic premise here is that we have to read to correctly write - to do a N bit write with a
+	 * wider access primitive, we first have to read back what's at the target aligned location, replace
+	 * the correct set of bytes in the target value, then write the new combined value back
+	 */
+	uint8_t value[8U] = {0};
+	const target_addr_t offset = dest & (native_access_length - 1U);
+	const target_addr_t address = dest - offset;
+	riscv_sysbus_mem_native_read(hart, value, address, native_access_length, access_width, native_access_length);
+	memcpy(value + offset, src, access_length);
+	riscv_sysbus_mem_native_write(hart, address, value, native_access_length, access_width, native_access_length);
+}
+
+static void riscv_sysbus_mem_write(
+	riscv_hart_s *const hart, const target_addr_t dest, const void *const src, const size_t len)
+{
+	/* Figure out the maxmial width of access to perform, up to what the bus supports */
+	const uint8_t access_width = riscv_sysbus_access_width(hart, dest, len);
+	const uint8_t access_length = 1U << access_width;
+	/* Check if the access is a natural/native width */
+	if (hart->flags & access_length) {
+		riscv_sysbus_mem_native_write(hart, dest, src, len, access_width, access_length);
+		return;
+	}
+
+	/* If we were unable to do this using a native access, find the next largest supported access width */
+	uint8_t native_access_width = access_width;
+	while (!((hart->flags >> native_access_width) & 1U) && native_access_width < RV_MEM_ACCESS_64_BIT)
+		++native_access_width;
+	const uint8_t native_access_length = (uint8_t)(1U << native_access_width);
+
+	/* Figure out how much the length is getting adjusted by in the first write to make it aligned */
+	const target_addr_t length_adjustment = dest & (native_access_length - 1U);
+	/*
+	 * Having done this, figure out how long the resulting write actually is so we can fill enough of the
+	 * destination buffer with a single write
+	 */
+	const uint8_t write_length =
+		len + length_adjustment <= native_access_length ? len : native_access_length - length_adjustment;
+
+	/* Do the initial adjusted access */
+	size_t remainder = len;
+	target_addr_t address = dest;
+	const uint8_t *data = (const uint8_t *)src;
+	riscv_sysbus_mem_adjusted_write(hart, address, data, write_length, native_access_width, native_access_length);
+
+	/* After doing the initial access, adjust the location of the next and do any follow-up accesses required */
+	remainder -= write_length;
+	address += write_length;
+	data += write_length;
+
+	/*
+	 * Now we're aligned to the wider access width, do another set of writes if there's
+	 * any remainder. Do this till we either reach nothing left, or we have another small left-over amount
+	 */
+	if (!remainder)
+		return;
+	const size_t amount = remainder & ~(native_access_length - 1U);
+	if (amount)
+		riscv_sysbus_mem_native_write(hart, address, data, amount, native_access_width, native_access_length);
+	remainder -= amount;
+	address += (uint32_t)amount;
+	data += amount;
+
+	/* If there's any data left to write, do another adjusted access to perform it */
+	if (remainder)
+		riscv_sysbus_mem_adjusted_write(hart, address, data, remainder, native_access_width, native_access_length);
+}
+
+void riscv_hart_mem_read(riscv_hart_s *const hart, void *const dest, const target_addr_t src, const size_t len)
+{
+	if (hart->flags & RV_HART_FLAG_MEMORY_SYSBUS)
+		riscv_sysbus_mem_read(hart, dest, src, len);
+	else
+		riscv_abstract_mem_read(hart, dest, src, len);
+}
+
+void riscv_hart_mem_write(riscv_hart_s *const hart, const target_addr_t dest, const void *const src, const size_t len)
+{
+	if (hart->flags & RV_HART_FLAG_MEMORY_SYSBUS)
+		riscv_sysbus_mem_write(hart, dest, src, len);
+	else
+		riscv_abstract_mem_write(hart, dest, src, len);
+}
@@ -0,0 +1,155 @@
+/*
+ * This file is part of the Black Magic Debug project.
+ *
+ * Copyright (C) 2023 1BitSquared <info@1bitsquared.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * This file implements the chip-level operations the SAM Device Service Unit (DSU) can perform
+ * on its own - CRC, blank checking, chip erase and MBIST - so that they don't need any help from
+ * the core or for the memory involved to be read back over the debug link.
+ */
+
+#include "general.h"
+#include "target_internal.h"
+#include "crc32.h"
+#include "sam_dsu.h"
+
+#define SAM_DSU_STATUSA_MASK \
+	(SAM_DSU_STATUSA_PERR | SAM_DSU_STATUSA_FAIL | SAM_DSU_STATUSA_BERR | SAM_DSU_STATUSA_DONE)
+/* Longest time to wait between polls of STATUSA in milliseconds */
+#define SAM_DSU_POLL_DELAY_MAX 16U
+/* Generous upper bounds on how long each operation can take in milliseconds, for a wedged DSU */
+#define SAM_DSU_CRC_TIMEOUT   5000U
+#define SAM_DSU_ERASE_TIMEOUT 20000U
+#define SAM_DSU_MBIST_TIMEOUT 10000U
+
+static void sam_dsu_start(target_s *const target, const uint32_t command)
+{
+	/* Clear the status bits left over from any previous operation, then kick off the new one */
+	target_mem_write32(target, SAM_DSU_CTRLSTAT, SAM_DSU_STATUSA_MASK);
+	target_mem_write32(target, SAM_DSU_CTRLSTAT, command);
+}
+
+bool sam_dsu_wait_ready(
+	target_s *const target, uint32_t *const status, const uint32_t deadline_ms, platform_timeout_s *const print_progress)
+{
+	platform_timeout_s deadline;
+	platform_timeout_set(&deadline, deadline_ms);
+	uint32_t delay = 0U;
+	while (true) {
+		const uint32_t ctrlstat = target_mem_read32(target, SAM_DSU_CTRLSTAT);
+		if (target_check_error(target))
+			return false;
+		if (ctrlstat & (SAM_DSU_STATUSA_DONE | SAM_DSU_STATUSA_PERR | SAM_DSU_STATUSA_FAIL)) {
+			*status = ctrlstat;
+			return true;
+		}
+		if (platform_timeout_is_expired(&deadline)) {
+			DEBUG_ERROR("DSU operation timed out, CTRLSTAT %08" PRIx32 "\n", ctrlstat);
+			return false;
+		}
+		if (print_progress)
+			target_print_progress(print_progress);
+		/* Poll back to back at first as most operations are quick, then back off up to the limit */
+		if (delay)
+			platform_delay(delay);
+		delay = delay ? MIN(delay * 2U, SAM_DSU_POLL_DELAY_MAX) : 1U;
+	}
+}
+
+bool sam_dsu_crc32(target_s *const target, uint32_t *const result, const target_addr_t base, const size_t len)
+{
+	/* ADDRESS and LENGTH both hold word quantities in their upper 30 bits */
+	if (!len || (base & 3U) || (len & 3U))
+		return false;
+
+	target_mem_write32(target, SAM_DSU_ADDRESS, base);
+	target_mem_write32(target, SAM_DSU_LENGTH, len);
+	target_mem_write32(target, SAM_DSU_DATA, 0xffffffffU);
+	sam_dsu_start(target, SAM_DSU_CTRL_CRC);
+
+	uint32_t status = 0;
+	if (!sam_dsu_wait_ready(target, &status, SAM_DSU_CRC_TIMEOUT, NULL))
+		return false;
+	if (status & (SAM_DSU_STATUSA_PERR | SAM_DSU_STATUSA_FAIL | SAM_DSU_STATUSA_BERR)) {
+		DEBUG_WARN("DSU CRC of 0x%08" PRIx32 "+%" PRIu32 " failed, status %08" PRIx32 "\n", base, (uint32_t)len,
+			status);
+		return false;
+	}
+	/* DATA holds the raw CRC register, so invert it to give the standard result */
+	*result = ~target_mem_read32(target, SAM_DSU_DATA);
+	return !target_check_error(target);
+}
+
+bool sam_dsu_is_blank(target_s *const target, const target_addr_t base, const size_t len)
+{
+	/* Erase blocks are almost always the same size, so keep the expected CRC from last time around */
+	static size_t blank_len = 0U;
+	static uint32_t blank_crc = 0U;
+	if (len != blank_len) {
+		uint8_t erased[64U];
+		memset(erased, 0xff, sizeof(erased));
+		blank_crc = 0U;
+		for (size_t offset = 0; offset < len; offset += sizeof(erased))
+			blank_crc = crc32_ieee_update(blank_crc, erased, MIN(sizeof(erased), len - offset));
+		blank_len = len;
+	}
+
+	uint32_t crc = 0;
+	return sam_dsu_crc32(target, &crc, base, len) && crc == blank_crc;
+}
+
+bool sam_dsu_chip_erase(target_s *const target)
+{
+	sam_dsu_start(target, SAM_DSU_CTRL_CHIP_ERASE);
+
+	uint32_t status = 0;
+	platform_timeout_s timeout;
+	platform_timeout_set(&timeout, 500);
+	if (!sam_dsu_wait_ready(target, &status, SAM_DSU_ERASE_TIMEOUT, &timeout))
+		return false;
+
+	/* Test the protection error bit in Status A */
+	if (status & SAM_DSU_STATUSA_PERR) {
+		tc_printf(target, "Erase failed due to a protection error.\n");
+		return true;
+	}
+
+	/* Test the fail bit in Status A */
+	return !(status & SAM_DSU_STATUSA_FAIL);
+}
+
+bool sam_dsu_mbist(target_s *const target, const uint32_t address, const uint32_t length, uint32_t *const status)
+{
+	target_mem_write32(target, SAM_DSU_ADDRESS, address);
+	target_mem_write32(target, SAM_DSU_LENGTH, length);
+	sam_dsu_start(target, SAM_DSU_CTRL_MBIST);
+	return sam_dsu_wait_ready(target, status, SAM_DSU_MBIST_TIMEOUT, NULL);
+}
@@ -0,0 +1,78 @@
+/*
+ * This file is part of the Black Magic Debug project.
+ *
+ * Copyright (C) 2023 1BitSquared <info@1bitsquared.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TARGET_SAM_DSU_H
+#define TARGET_SAM_DSU_H
+
+#include <stdint.h>
+#include "target_internal.h"
+
+/*
+ * Device Service Unit (DSU) services shared by the SAM D1x/D2x/L2x/C2x and D5x/E5x drivers.
+ * The DSU sits at the same address with the same register layout on all of them.
+ */
+
+#define SAM_DSU            0x41002000U
+#define SAM_DSU_EXT_ACCESS (SAM_DSU + 0x100U)
+#define SAM_DSU_CTRLSTAT   (SAM_DSU_EXT_ACCESS + 0x00U)
+#define SAM_DSU_ADDRESS    (SAM_DSU_EXT_ACCESS + 0x04U)
+#define SAM_DSU_LENGTH     (SAM_DSU_EXT_ACCESS + 0x08U)
+#define SAM_DSU_DATA       (SAM_DSU_EXT_ACCESS + 0x0cU)
+
+/* Control and Status Register (CTRLSTAT) */
+#define SAM_DSU_CTRL_CHIP_ERASE (1U << 4U)
+#define SAM_DSU_CTRL_MBIST      (1U << 3U)
+#define SAM_DSU_CTRL_CRC        (1U << 2U)
+#define SAM_DSU_STATUSA_PERR    (1U << 12U)
+#define SAM_DSU_STATUSA_FAIL    (1U << 11U)
+#define SAM_DSU_STATUSA_BERR    (1U << 10U)
+#define SAM_DSU_STATUSA_DONE    (1U << 8U)
+
+/*
+ * Wait for the operation in flight to finish, backing off between polls of STATUSA so long operations
+ * don't flood the link. Returns the final CTRLSTAT value in status, or false if the operation has not
+ * finished within deadline_ms milliseconds. Prints progress if print_progress is given.
+ */
+bool sam_dsu_wait_ready(target_s *target, uint32_t *status, uint32_t deadline_ms, platform_timeout_s *print_progress);
+/* Compute the IEEE 802.3 CRC-32 of a word aligned range, suitable for use as the target's crc32_ieee hook */
+bool sam_dsu_crc32(target_s *target, uint32_t *result, target_addr_t base, size_t len);
+/* Check whether a word aligned range of Flash is erased using the DSU's CRC rather than reading it back */
+bool sam_dsu_is_blank(target_s *target, target_addr_t base, size_t len);
+/* Erase the whole device, suitable for use as the target's mass_erase hook */
+bool sam_dsu_chip_erase(target_s *target);
+/*
+ * Run the memory built-in self test with the given ADDRESS and LENGTH register values.
+ * Returns false if the test could not be run, else the final CTRLSTAT value is returned in status.
+ */
+bool sam_dsu_mbist(target_s *target, uint32_t address, uint32_t length, uint32_t *status);
+
+#endif /* TARGET_SAM_DSU_H */
@@ -41,11 +41,10 @@
 #include "target.h"
 #include "target_internal.h"
 #include "cortexm.h"
+#include "sam_dsu.h"
 
 static bool samd_flash_erase(target_flash_s *f, target_addr_t addr, size_t len);
 static bool samd_flash_write(target_flash_s *f, target_addr_t dest, const void *src, size_t len);
-/* NB: This is not marked static on purpose as it's used by samx5x.c. */
-bool samd_mass_erase(target_s *t);
 
 static bool samd_cmd_lock_flash(target_s *t, int argc, const char **argv);
 static bool samd_cmd_unlock_flash(target_s *t, int argc, const char **argv);
@@ -112,21 +111,12 @@ const command_s samd_cmd_list[] = {
 #define SAMD_DSU            0x41002000U
 #define SAMD_DSU_EXT_ACCESS (SAMD_DSU + 0x100U)
 #define SAMD_DSU_CTRLSTAT   (SAMD_DSU_EXT_ACCESS + 0x0U)
-#define SAMD_DSU_ADDRESS    (SAMD_DSU_EXT_ACCESS + 0x4U)
-#define SAMD_DSU_LENGTH     (SAMD_DSU_EXT_ACCESS + 0x8U)
 #define SAMD_DSU_DID        (SAMD_DSU_EXT_ACCESS + 0x018U)
 #define SAMD_DSU_PID        (SAMD_DSU + 0x1000U)
 #define SAMD_DSU_CID        (SAMD_DSU + 0x1010U)
 
-/* Control and Status Register (CTRLSTAT) */
-#define SAMD_CTRL_CHIP_ERASE (1U << 4U)
-#define SAMD_CTRL_MBIST      (1U << 3U)
-#define SAMD_CTRL_CRC        (1U << 2U)
-#define SAMD_STATUSA_PERR    (1U << 12U)
-#define SAMD_STATUSA_FAIL    (1U << 11U)
-#define SAMD_STATUSA_BERR    (1U << 10U)
+/* Control and Status Register (CTRLSTAT), see sam_dsu.h for the bits used by DSU operations */
 #define SAMD_STATUSA_CRSTEXT (1U << 9U)
-#define SAMD_STATUSA_DONE    (1U << 8U)
 #define SAMD_STATUSB_PROT    (1U << 16U)
 
 /* Device Identification Register (DID) */
@@ -547,7 +537,8 @@ bool samd_probe(target_s *t)
 	/* Setup Target */
 	t->driver = priv_storage->samd_variant_string;
 	t->reset = samd_reset;
-	t->mass_erase = samd_mass_erase;
+	t->mass_erase = sam_dsu_chip_erase;
+	t->crc32_ieee = sam_dsu_crc32;
 
 	if (samd.series == 20 && samd.revision == 'B') {
 		/*
@@ -615,25 +606,14 @@ static bool samd_wait_nvm_ready(target_s *t)
 	return true;
 }
 
-static bool samd_wait_dsu_ready(target_s *const t, uint32_t *const result, platform_timeout_s *const timeout)
-{
-	uint32_t status = 0;
-	while ((status & (SAMD_STATUSA_DONE | SAMD_STATUSA_PERR | SAMD_STATUSA_FAIL)) == 0) {
-		status = target_mem_read32(t, SAMD_DSU_CTRLSTAT);
-		if (target_check_error(t))
-			return false;
-		if (timeout)
-			target_print_progress(timeout);
-	}
-	*result = status;
-	return true;
-}
-
-/* Erase flash row by row */
+/* Erase flash row by row, skipping rows the DSU reports are already blank */
 static bool samd_flash_erase(target_flash_s *const f, const target_addr_t addr, const size_t len)
 {
 	target_s *t = f->t;
 	for (size_t offset = 0; offset < len; offset += f->blocksize) {
+		if (sam_dsu_is_blank(t, addr + offset, f->blocksize))
+			continue;
+
 		/*
 		 * Write address of first word in row to erase it
 		 * Must be shifted right for 16-bit address, see Datasheet §20.8.8 Address
@@ -679,31 +659,6 @@ static bool samd_flash_write(target_flash_s *f, target_addr_t dest, const void *
 	return true;
 }
 
-/* Uses the Device Service Unit to erase the entire flash */
-bool samd_mass_erase(target_s *t)
-{
-	/* Clear the DSU status bits */
-	target_mem_write32(t, SAMD_DSU_CTRLSTAT, SAMD_STATUSA_DONE | SAMD_STATUSA_PERR | SAMD_STATUSA_FAIL);
-
-	/* Erase all */
-	target_mem_write32(t, SAMD_DSU_CTRLSTAT, SAMD_CTRL_CHIP_ERASE);
-
-	uint32_t status = 0;
-	platform_timeout_s timeout;
-	platform_timeout_set(&timeout, 500);
-	if (!samd_wait_dsu_ready(t, &status, &timeout))
-		return false;
-
-	/* Test the protection error bit in Status A */
-	if (status & SAMD_STATUSA_PERR) {
-		tc_printf(t, "Erase failed due to a protection error.\n");
-		return true;
-	}
-
-	/* Test the fail bit in Status A */
-	return !(status & SAMD_STATUSA_FAIL);
-}
-
 /*
  * Sets the NVM region lock bits in the User Row. This value is read
  * at startup as the default value for the lock bits, and hence does
@@ -887,29 +842,20 @@ static bool samd_cmd_mbist(target_s *t, int argc, const char **argv)
 {
 	(void)argc;
 	(void)argv;
-	/* Write the memory parameters to the DSU */
-	target_mem_write32(t, SAMD_DSU_ADDRESS, 0);
-	target_mem_write32(t, SAMD_DSU_LENGTH, samd_flash_size(t));
-
-	/* Clear the fail bit */
-	target_mem_write32(t, SAMD_DSU_CTRLSTAT, SAMD_STATUSA_FAIL);
-
-	/* Write the MBIST command */
-	target_mem_write32(t, SAMD_DSU_CTRLSTAT, SAMD_CTRL_MBIST);
-
+	/* Run the test over the whole of Flash */
 	uint32_t status = 0;
-	if (!samd_wait_dsu_ready(t, &status, NULL))
+	if (!sam_dsu_mbist(t, 0, samd_flash_size(t), &status))
 		return false;
 
 	/* Test the protection error bit in Status A */
-	if (status & SAMD_STATUSA_PERR) {
+	if (status & SAM_DSU_STATUSA_PERR) {
 		tc_printf(t, "MBIST not run due to protection error.\n");
 		return true;
 	}
 
 	/* Test the fail bit in Status A */
-	if (status & SAMD_STATUSA_FAIL)
-		tc_printf(t, "MBIST Fail @ 0x%08" PRIx32 "\n", target_mem_read32(t, SAMD_DSU_ADDRESS));
+	if (status & SAM_DSU_STATUSA_FAIL)
+		tc_printf(t, "MBIST Fail @ 0x%08" PRIx32 "\n", target_mem_read32(t, SAM_DSU_ADDRESS));
 	else
 		tc_printf(t, "MBIST Passed!\n");
 	return true;
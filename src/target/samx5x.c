@@ -39,6 +39,7 @@
 #include "target.h"
 #include "target_internal.h"
 #include "cortex.h"
+#include "sam_dsu.h"
 
 static bool samx5x_flash_erase(target_flash_s *f, target_addr_t addr, size_t len);
 static bool samx5x_flash_write(target_flash_s *f, target_addr_t dest, const void *src, size_t len);
@@ -51,10 +52,6 @@ static bool samx5x_cmd_serial(target_s *t, int argc, const char **argv);
 static bool samx5x_cmd_ssb(target_s *t, int argc, const char **argv);
 static bool samx5x_cmd_update_user_word(target_s *t, int argc, const char **argv);
 
-/* (The SAM D1x/2x implementation of erase_all is reused as it's identical)*/
-bool samd_mass_erase(target_s *t);
-#define samx5x_mass_erase samd_mass_erase
-
 #ifdef SAMX5X_EXTRA_CMDS
 static bool samx5x_cmd_mbist(target_s *t, int argc, const char **argv);
 static bool samx5x_cmd_write8(target_s *t, int argc, const char **argv);
@@ -137,22 +134,12 @@ const command_s samx5x_cmd_list[] = {
 #define SAMX5X_DSU            0x41002000U
 #define SAMX5X_DSU_EXT_ACCESS (SAMX5X_DSU + 0x100U)
 #define SAMX5X_DSU_CTRLSTAT   (SAMX5X_DSU_EXT_ACCESS + 0x00U)
-#define SAMX5X_DSU_ADDRESS    (SAMX5X_DSU_EXT_ACCESS + 0x04U)
-#define SAMX5X_DSU_LENGTH     (SAMX5X_DSU_EXT_ACCESS + 0x08U)
-#define SAMX5X_DSU_DATA       (SAMX5X_DSU_EXT_ACCESS + 0x0cU)
 #define SAMX5X_DSU_DID        (SAMX5X_DSU_EXT_ACCESS + 0x18U)
 #define SAMX5X_DSU_PID        (SAMX5X_DSU + 0x1000U)
 #define SAMX5X_DSU_CID        (SAMX5X_DSU + 0x1010U)
 
 /* Control and Status Register (CTRLSTAT) */
-#define SAMX5X_CTRL_CHIP_ERASE (1U << 4U)
-#define SAMX5X_CTRL_MBIST      (1U << 3U)
-#define SAMX5X_CTRL_CRC        (1U << 2U)
-#define SAMX5X_STATUSA_PERR    (1U << 12U)
-#define SAMX5X_STATUSA_FAIL    (1U << 11U)
-#define SAMX5X_STATUSA_BERR    (1U << 10U)
 #define SAMX5X_STATUSA_CRSTEXT (1U << 9U)
-#define SAMX5X_STATUSA_DONE    (1U << 8U)
 #define SAMX5X_STATUSB_PROT    (1U << 16U)
 
 /*
@@ -349,7 +336,8 @@ bool samx5x_probe(target_s *t)
 	/* Setup Target */
 	t->driver = priv_storage->samx5x_variant_string;
 	t->reset = samx5x_reset;
-	t->mass_erase = samx5x_mass_erase;
+	t->mass_erase = sam_dsu_chip_erase;
+	t->crc32_ieee = sam_dsu_crc32;
 
 	/*
 	 * Overload the default cortexm attach when the samx5x is protected.
@@ -485,22 +473,24 @@ static bool samx5x_flash_erase(target_flash_s *f, target_addr_t addr, size_t len
 			is_first_section = false;
 		}
 
-		/* Issue the erase command */
-		target_mem_write32(t, SAMX5X_NVMC_CTRLB, SAMX5X_CTRLB_CMD_KEY | SAMX5X_CTRLB_CMD_ERASEBLOCK);
+		/* Issue the erase command unless the DSU reports the block is already blank */
+		if (!sam_dsu_is_blank(t, addr + offset, f->blocksize)) {
+			target_mem_write32(t, SAMX5X_NVMC_CTRLB, SAMX5X_CTRLB_CMD_KEY | SAMX5X_CTRLB_CMD_ERASEBLOCK);
+
+			/* Poll for NVM Ready */
+			while ((target_mem_read32(t, SAMX5X_NVMC_STATUS) & SAMX5X_STATUS_READY) == 0) {
+				if (target_check_error(t) || samx5x_check_nvm_error(t)) {
+					DEBUG_WARN("NVM Ready\n");
+					return false;
+				}
+			}
 
-		/* Poll for NVM Ready */
-		while ((target_mem_read32(t, SAMX5X_NVMC_STATUS) & SAMX5X_STATUS_READY) == 0) {
 			if (target_check_error(t) || samx5x_check_nvm_error(t)) {
-				DEBUG_WARN("NVM Ready\n");
+				DEBUG_ERROR("Error\n");
 				return false;
 			}
 		}
 
-		if (target_check_error(t) || samx5x_check_nvm_error(t)) {
-			DEBUG_ERROR("Error\n");
-			return false;
-		}
-
 		/* If we've just finished writing to a flash region, lock it. */
 		const size_t next_offset = offset + f->blocksize;
 		if ((next_offset % lock_region_size) == 0)
@@ -844,33 +834,20 @@ static bool samx5x_cmd_mbist(target_s *t, int argc, const char **argv)
 	 * Similarly, the length must also be left shifted by 2 as the
 	 * two least significant bits of that register are unused
 	 */
-	target_mem_write32(t, SAMX5X_DSU_ADDRESS, SAMX5X_RAM_START);
-	target_mem_write32(t, SAMX5X_DSU_LENGTH, samx5x_ram_size(t) << 2U);
-
-	/* Clear the fail and protection error bits */
-	target_mem_write32(t, SAMX5X_DSU_CTRLSTAT, SAMX5X_STATUSA_FAIL | SAMX5X_STATUSA_PERR);
-
-	/* Write the MBIST command */
-	target_mem_write32(t, SAMX5X_DSU_CTRLSTAT, SAMX5X_CTRL_MBIST);
-
-	/* Poll for DSU Ready */
 	uint32_t status = 0;
-	while ((status & (SAMX5X_STATUSA_DONE | SAMX5X_STATUSA_PERR | SAMX5X_STATUSA_FAIL)) == 0) {
-		status = target_mem_read32(t, SAMX5X_DSU_CTRLSTAT);
-		if (target_check_error(t))
-			return false;
-	}
+	if (!sam_dsu_mbist(t, SAMX5X_RAM_START, samx5x_ram_size(t) << 2U, &status))
+		return false;
 
 	/* Test the protection error bit in Status A */
-	if (status & SAMX5X_STATUSA_PERR) {
+	if (status & SAM_DSU_STATUSA_PERR) {
 		tc_printf(t, "MBIST not run due to protection error.\n");
 		return true;
 	}
 
 	/* Test the fail bit in Status A */
-	if (status & SAMX5X_STATUSA_FAIL) {
-		const uint32_t data = target_mem_read32(t, SAMX5X_DSU_DATA);
-		tc_printf(t, "MBIST Fail @ 0x%08" PRIx32 " (bit %u in phase %u)\n", target_mem_read32(t, SAMX5X_DSU_ADDRESS),
+	if (status & SAM_DSU_STATUSA_FAIL) {
+		const uint32_t data = target_mem_read32(t, SAM_DSU_DATA);
+		tc_printf(t, "MBIST Fail @ 0x%08" PRIx32 " (bit %u in phase %u)\n", target_mem_read32(t, SAM_DSU_ADDRESS),
 			data & 0x1fU, data >> 8U);
 	} else
 		tc_printf(t, "MBIST Passed!\n");
@@ -25,6 +25,25 @@
 #include "target_internal.h"
 #include "adiv5.h"
 
+/* Which of the CRC unit's configuration registers exist and so have to be put back to their defaults */
+#define STM32_CRC_PROGRAMMABLE_INIT (1U << 0U)
+#define STM32_CRC_PROGRAMMABLE_POLY (1U << 1U)
+
+/* Description of a family's CRC unit for use by stm32_crc32() */
+typedef struct stm32_crc_unit {
+	/* Base address of the CRC unit */
+	uint32_t base;
+	/* RCC register and bit that clock the CRC unit */
+	uint32_t rcc_enable_reg;
+	uint32_t rcc_enable_bit;
+	/* Executable RAM present on every part of the family for the stub to run from */
+	uint32_t stub_addr;
+	uint8_t flags;
+} stm32_crc_unit_s;
+
+/* Compute the GDB qCRC CRC-32 over a range using the part's CRC unit, returns false if it could not be used */
+bool stm32_crc32(target_s *target, const stm32_crc_unit_s *unit, uint32_t *result, target_addr_t base, size_t len);
+
 static inline const char *stm32_psize_to_string(const align_e psize)
 {
 	switch (psize) {
@@ -0,0 +1,163 @@
+/*
+ * This file is part of the Black Magic Debug project.
+ *
+ * Copyright (C) 2023 1BitSquared <info@1bitsquared.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * This file implements the target CRC hook shared by the STM32 families with a CRC unit.
+ *
+ * The unit's default configuration (polynomial 0x04c11db7, initial value 0xffffffff, no bit reversal)
+ * is exactly the CRC-32 that GDB's qCRC packet asks for, so a small stub run on the target can push
+ * the requested range through it and only the result has to come back over the debug link.
+ */
+
+#include "general.h"
+#include "target_internal.h"
+#include "cortexm.h"
+#include "stm32_common.h"
+
+#define STM32_CRC_DR   0x00U
+#define STM32_CRC_CR   0x08U
+#define STM32_CRC_INIT 0x10U
+#define STM32_CRC_POL  0x14U
+
+#define STM32_CRC_CR_RESET (1U << 0U)
+
+#define STM32_CRC_INIT_VALUE 0xffffffffU
+#define STM32_CRC_POLYNOMIAL 0x04c11db7U
+
+/* Below this, reading the range back is quicker than setting up and running the stub */
+#define STM32_CRC_MIN_LENGTH 1024U
+
+static const uint16_t stm32_crc_stub[] = {
+#include "flashstub/stm32_crc.stub"
+};
+
+/* Continue a CRC over the last few bytes of the range the unit could not be fed as whole words */
+static uint32_t stm32_crc_bytes(uint32_t crc, const uint8_t *const data, const size_t len)
+{
+	for (size_t offset = 0; offset < len; ++offset) {
+		crc ^= data[offset] << 24U;
+		for (size_t i = 0; i < 8U; ++i) {
+			if (crc & 0x80000000U)
+				crc = (crc << 1U) ^ STM32_CRC_POLYNOMIAL;
+			else
+				crc <<= 1U;
+		}
+	}
+	return crc;
+}
+
+/*
+ * Undo the 32 rounds of the unit's shift register that feeding it a word performs, giving the value the
+ * register has to hold, XOR the word, for the unit to end up holding the value passed in
+ */
+static uint32_t stm32_crc_unshift(uint32_t crc)
+{
+	for (size_t i = 0; i < 32U; ++i) {
+		if (crc & 1U)
+			crc = ((crc ^ STM32_CRC_POLYNOMIAL) >> 1U) | 0x80000000U;
+		else
+			crc >>= 1U;
+	}
+	return crc;
+}
+
+bool stm32_crc32(target_s *const target, const stm32_crc_unit_s *const unit, uint32_t *const result,
+	const target_addr_t base, const size_t len)
+{
+	/*
+	 * The unit can only be fed whole words, and the stub needs a halted core with its caches off so it runs
+	 * the code just written and sees what is actually in memory rather than any stale cache lines. The range
+	 * also must not cover where the stub goes, or the stub would be hashed in place of what it overwrote.
+	 */
+	if ((base & 3U) || len < STM32_CRC_MIN_LENGTH ||
+		(unit->stub_addr < base + len && base < unit->stub_addr + sizeof(stm32_crc_stub)) ||
+		!(target_mem_read32(target, CORTEXM_DHCSR) & CORTEXM_DHCSR_S_HALT) ||
+		(target_mem_read32(target, CORTEXM_CCR) & (CORTEXM_CCR_DC | CORTEXM_CCR_IC)))
+		return false;
+
+	uint32_t saved_regs[CORTEXM_GENERAL_REG_COUNT + CORTEX_FLOAT_REG_COUNT];
+	uint16_t saved_ram[ARRAY_LENGTH(stm32_crc_stub)];
+	target_regs_read(target, saved_regs);
+	const uint32_t clock_enable = target_mem_read32(target, unit->rcc_enable_reg);
+	if (target_mem_read(target, saved_ram, unit->stub_addr, sizeof(saved_ram)))
+		return false;
+
+	/* Clock the unit and save its state, as firmware may be part way through a CRC of its own */
+	target_mem_write32(target, unit->rcc_enable_reg, clock_enable | unit->rcc_enable_bit);
+	const uint32_t saved_cr = target_mem_read32(target, unit->base + STM32_CRC_CR);
+	const uint32_t saved_dr = target_mem_read32(target, unit->base + STM32_CRC_DR);
+	const uint32_t saved_init =
+		unit->flags & STM32_CRC_PROGRAMMABLE_INIT ? target_mem_read32(target, unit->base + STM32_CRC_INIT) : 0U;
+	const uint32_t saved_pol =
+		unit->flags & STM32_CRC_PROGRAMMABLE_POLY ? target_mem_read32(target, unit->base + STM32_CRC_POL) : 0U;
+
+	/* Put it into the configuration GDB's CRC expects */
+	if (unit->flags & STM32_CRC_PROGRAMMABLE_INIT)
+		target_mem_write32(target, unit->base + STM32_CRC_INIT, STM32_CRC_INIT_VALUE);
+	if (unit->flags & STM32_CRC_PROGRAMMABLE_POLY)
+		target_mem_write32(target, unit->base + STM32_CRC_POL, STM32_CRC_POLYNOMIAL);
+
+	const size_t words = len >> 2U;
+	bool success = !target_mem_write(target, unit->stub_addr, stm32_crc_stub, sizeof(stm32_crc_stub)) &&
+		cortexm_run_stub(target, unit->stub_addr, base, words, unit->base, 0);
+	uint32_t crc = 0;
+	if (success)
+		success = target_reg_read(target, 0U, &crc, sizeof(crc)) == sizeof(crc);
+
+	const size_t remainder = len & 3U;
+	if (success && remainder) {
+		uint8_t bytes[4U];
+		success = !target_mem_read(target, bytes, base + (words << 2U), remainder);
+		crc = stm32_crc_bytes(crc, bytes, remainder);
+	}
+
+	/*
+	 * DR can't be written directly, so reset the unit while it is still in our configuration and feed it
+	 * the one word that takes it from the initial value to the saved one, then restore the configuration
+	 */
+	target_mem_write32(target, unit->base + STM32_CRC_CR, STM32_CRC_CR_RESET);
+	target_mem_write32(target, unit->base + STM32_CRC_DR, stm32_crc_unshift(saved_dr) ^ STM32_CRC_INIT_VALUE);
+	if (unit->flags & STM32_CRC_PROGRAMMABLE_INIT)
+		target_mem_write32(target, unit->base + STM32_CRC_INIT, saved_init);
+	if (unit->flags & STM32_CRC_PROGRAMMABLE_POLY)
+		target_mem_write32(target, unit->base + STM32_CRC_POL, saved_pol);
+	target_mem_write32(target, unit->base + STM32_CRC_CR, saved_cr & ~STM32_CRC_CR_RESET);
+
+	target_mem_write(target, unit->stub_addr, saved_ram, sizeof(saved_ram));
+	target_mem_write32(target, unit->rcc_enable_reg, clock_enable);
+	target_regs_write(target, saved_regs);
+	if (!success || target_check_error(target))
+		return false;
+	DEBUG_INFO("CRC of %" PRIu32 " bytes at 0x%08" PRIx32 " computed by the target's CRC unit\n", (uint32_t)len, base);
+	*result = crc;
+	return true;
+}
@@ -42,6 +42,10 @@
 #include "target_internal.h"
 #include "cortexm.h"
 #include "jep106.h"
+#include "stm32_common.h"
+#ifdef ENABLE_RISCV
+#include "riscv_debug.h"
+#endif
 
 static bool stm32f1_cmd_option(target_s *target, int argc, const char **argv);
 
@@ -53,6 +57,9 @@ const command_s stm32f1_cmd_list[] = {
 static bool stm32f1_flash_erase(target_flash_s *flash, target_addr_t addr, size_t len);
 static bool stm32f1_flash_write(target_flash_s *flash, target_addr_t dest, const void *src, size_t len);
 static bool stm32f1_mass_erase(target_s *target);
+static bool stm32f1_protection_read(target_s *target, uint32_t *words);
+static bool stm32f1_protection_write(target_s *target, const uint32_t *words, uint32_t changed_mask);
+static bool stm32f1_crc32(target_s *target, uint32_t *result, target_addr_t base, size_t len);
 
 /* Flash Program ad Erase Controller Register Map */
 #define FPEC_BASE     0x40022000U
@@ -109,6 +116,46 @@ static bool stm32f1_mass_erase(target_s *target);
 #define DBGMCU_IDCODE_MM32L0 0x40013400U
 #define DBGMCU_IDCODE_MM32F3 0x40007080U
 
+#define STM32F1_CRC_BASE       0x40023000U
+#define STM32F1_RCC_AHBENR     0x40021014U
+#define STM32F1_RCC_AHBENR_CRC (1U << 6U)
+
+/*
+ * The F1's CRC unit is fixed function, the F0's has a programmable initial value
+ * and the F07/F09's and F3's are fully programmable
+ */
+static const stm32_crc_unit_s stm32f1_crc_unit = {
+	.base = STM32F1_CRC_BASE,
+	.rcc_enable_reg = STM32F1_RCC_AHBENR,
+	.rcc_enable_bit = STM32F1_RCC_AHBENR_CRC,
+	.stub_addr = 0x20000000U,
+	.flags = 0U,
+};
+
+static const stm32_crc_unit_s stm32f0_crc_unit = {
+	.base = STM32F1_CRC_BASE,
+	.rcc_enable_reg = STM32F1_RCC_AHBENR,
+	.rcc_enable_bit = STM32F1_RCC_AHBENR_CRC,
+	.stub_addr = 0x20000000U,
+	.flags = STM32_CRC_PROGRAMMABLE_INIT,
+};
+
+static const stm32_crc_unit_s stm32f07_crc_unit = {
+	.base = STM32F1_CRC_BASE,
+	.rcc_enable_reg = STM32F1_RCC_AHBENR,
+	.rcc_enable_bit = STM32F1_RCC_AHBENR_CRC,
+	.stub_addr = 0x20000000U,
+	.flags = STM32_CRC_PROGRAMMABLE_INIT | STM32_CRC_PROGRAMMABLE_POLY,
+};
+
+static const stm32_crc_unit_s stm32f3_crc_unit = {
+	.base = STM32F1_CRC_BASE,
+	.rcc_enable_reg = STM32F1_RCC_AHBENR,
+	.rcc_enable_bit = STM32F1_RCC_AHBENR_CRC,
+	.stub_addr = 0x20000000U,
+	.flags = STM32_CRC_PROGRAMMABLE_INIT | STM32_CRC_PROGRAMMABLE_POLY,
+};
+
 static void stm32f1_add_flash(target_s *target, uint32_t addr, size_t length, size_t erasesize)
 {
 	target_flash_s *flash = calloc(1, sizeof(*flash));
@@ -175,6 +222,9 @@ bool gd32f1_probe(target_s *target)
 
 	target->part_id = device_id;
 	target->mass_erase = stm32f1_mass_erase;
+	target->protection_words = 8U;
+	target->protection_read = stm32f1_protection_read;
+	target->protection_write = stm32f1_protection_write;
 	target_add_ram(target, 0x20000000, ram_size * 1024U);
 	stm32f1_add_flash(target, 0x8000000, (size_t)flash_size * 1024U, block_size);
 	target_add_commands(target, stm32f1_cmd_list, target->driver);
@@ -183,6 +233,13 @@ bool gd32f1_probe(target_s *target)
 }
 
 #ifdef ENABLE_RISCV
+#define GD32VF1_STUB_ADDR   0x20000000U
+#define GD32VF1_STUB_BUFFER 0x20000100U
+
+static const uint16_t gd32vf1_flash_write_stub[] = {
+#include "flashstub/gd32vf1.stub"
+};
+
 /* Identify RISC-V GD32VF1 chips */
 bool gd32vf1_probe(target_s *const target)
 {
@@ -456,6 +513,9 @@ bool stm32f1_probe(target_s *target)
 	const uint16_t device_id = stm32f1_read_idcode(target);
 
 	target->mass_erase = stm32f1_mass_erase;
+	target->protection_words = 8U;
+	target->protection_read = stm32f1_protection_read;
+	target->protection_write = stm32f1_protection_write;
 	size_t flash_size = 0;
 	size_t block_size = 0x400;
 
@@ -472,8 +532,10 @@ bool stm32f1_probe(target_s *target)
 		if ((ap->idr >> 28U) > 1U) {
 			target->driver = "STM32F1 (clone) medium density";
 			DEBUG_WARN("Detected clone STM32F1\n");
-		} else
+		} else {
 			target->driver = "STM32F1 medium density";
+			target->crc32 = stm32f1_crc32;
+		}
 		target->part_id = device_id;
 		return true;
 
@@ -482,6 +544,7 @@ bool stm32f1_probe(target_s *target)
 	case 0x428U: /* Value Line, High Density */
 		target->driver = "STM32F1  VL density";
 		target->part_id = device_id;
+		target->crc32 = stm32f1_crc32;
 		target_add_ram(target, 0x20000000, 0x10000);
 		stm32f1_add_flash(target, 0x8000000, 0x80000, 0x800);
 		target_add_commands(target, stm32f1_cmd_list, "STM32 HF/CL/VL-HD");
@@ -490,6 +553,7 @@ bool stm32f1_probe(target_s *target)
 	case 0x430U: /* XL-density */
 		target->driver = "STM32F1  XL density";
 		target->part_id = device_id;
+		target->crc32 = stm32f1_crc32;
 		target_add_ram(target, 0x20000000, 0x18000);
 		stm32f1_add_flash(target, 0x8000000, 0x80000, 0x800);
 		stm32f1_add_flash(target, 0x8080000, 0x80000, 0x800);
@@ -506,6 +570,7 @@ bool stm32f1_probe(target_s *target)
 	case 0x439U: /* STM32F302C8 */
 		target->driver = "STM32F3";
 		target->part_id = device_id;
+		target->crc32 = stm32f1_crc32;
 		target_add_ram(target, 0x20000000, 0x10000);
 		stm32f1_add_flash(target, 0x8000000, 0x80000, 0x800);
 		target_add_commands(target, stm32f1_cmd_list, "STM32F3");
@@ -540,16 +605,45 @@ bool stm32f1_probe(target_s *target)
 
 	default: /* NONE */
 		target->mass_erase = NULL;
+		target->protection_words = 0U;
+		target->protection_read = NULL;
+		target->protection_write = NULL;
 		return false;
 	}
 
 	target->part_id = device_id;
+	target->crc32 = stm32f1_crc32;
 	target_add_ram(target, 0x20000000, 0x5000);
 	stm32f1_add_flash(target, 0x8000000, flash_size, block_size);
 	target_add_commands(target, stm32f1_cmd_list, "STM32F0");
 	return true;
 }
 
+static bool stm32f1_crc32(target_s *target, uint32_t *result, target_addr_t base, size_t len)
+{
+	switch (target->part_id) {
+	case 0x410U: /* Medium density */
+	case 0x412U: /* Low density */
+	case 0x420U: /* Value Line, Low-/Medium density */
+	case 0x414U: /* High density */
+	case 0x418U: /* Connectivity Line */
+	case 0x428U: /* Value Line, High Density */
+	case 0x430U: /* XL-density */
+		return stm32_crc32(target, &stm32f1_crc_unit, result, base, len);
+	case 0x438U: /* STM32F303x6/8 and STM32F328 */
+	case 0x422U: /* STM32F30x */
+	case 0x446U: /* STM32F303xD/E and STM32F398xE */
+	case 0x432U: /* STM32F37x */
+	case 0x439U: /* STM32F302C8 */
+		return stm32_crc32(target, &stm32f3_crc_unit, result, base, len);
+	case 0x448U: /* STM32F07 */
+	case 0x442U: /* STM32F09 */
+		return stm32_crc32(target, &stm32f07_crc_unit, result, base, len);
+	default: /* STM32F03/F04/F05 */
+		return stm32_crc32(target, &stm32f0_crc_unit, result, base, len);
+	}
+}
+
 static bool stm32f1_flash_unlock(target_s *target, uint32_t bank_offset)
 {
 	target_mem_write32(target, FLASH_KEYR + bank_offset, KEY1);
@@ -624,6 +718,25 @@ static bool stm32f1_flash_erase(target_flash_s *flash, target_addr_t addr, size_
 	return stm32f1_flash_busy_wait(target, bank_offset, NULL);
 }
 
+/* Program Flash on GD32VF1 parts by having a stub on the Hart do it rather than a DMI round trip per halfword */
+static bool gd32vf1_flash_write(
+	target_s *const target, const target_addr_t dest, const void *const src, const size_t len)
+{
+#ifdef ENABLE_RISCV
+	if (target_mem_write(target, GD32VF1_STUB_BUFFER, src, len))
+		return false;
+	uint32_t result = 0U;
+	if (!riscv_run_stub(target, GD32VF1_STUB_ADDR, gd32vf1_flash_write_stub, sizeof(gd32vf1_flash_write_stub),
+			GD32VF1_STUB_BUFFER, dest, len, FPEC_BASE, &result))
+		return false;
+	if (result)
+		DEBUG_ERROR("gd32vf1 flash error 0x%" PRIx32 "\n", result);
+	return !result;
+#else
+	return !target_mem_write(target, dest, src, len);
+#endif
+}
+
 static size_t stm32f1_bank1_length(target_addr_t addr, size_t len)
 {
 	if (addr >= FLASH_BANK_SPLIT)
@@ -644,10 +757,11 @@ static bool stm32f1_flash_write(target_flash_s *flash, target_addr_t dest, const
 		stm32f1_flash_clear_eop(target, FLASH_BANK1_OFFSET);
 
 		target_mem_write32(target, FLASH_CR, FLASH_CR_PG);
-		/* Use the target API instead of a direct Cortex-M call for GD32VF103 parts */
-		if (target->designer_code == JEP106_MANUFACTURER_RV_GIGADEVICE && target->cpuid == 0x80000022U)
-			target_mem_write(target, dest, src, offset);
-		else
+		/* GD32VF103 parts are RISC-V, so program them using a stub rather than a direct Cortex-M call */
+		if (target->designer_code == JEP106_MANUFACTURER_RV_GIGADEVICE && target->cpuid == 0x80000022U) {
+			if (!gd32vf1_flash_write(target, dest, src, offset))
+				return false;
+		} else
 			cortexm_mem_write_sized(target, dest, src, offset, ALIGN_16BIT);
 
 		/* Wait for completion or an error */
@@ -803,6 +917,58 @@ static bool stm32f1_option_write(target_s *const target, const uint32_t addr, co
 	return true;
 }
 
+static bool stm32f1_protection_read(target_s *const target, uint32_t *const words)
+{
+	/* Read all 8 option half-words in one go and expand them out, one per word */
+	uint16_t opt_val[8U];
+	if (target_mem_read(target, opt_val, FLASH_OBP_RDP, sizeof(opt_val)))
+		return false;
+	for (size_t i = 0U; i < 8U; ++i)
+		words[i] = opt_val[i];
+	return true;
+}
+
+static bool stm32f1_protection_write(target_s *const target, const uint32_t *const words, const uint32_t changed_mask)
+{
+	/* Several of the compatible parts treat 0xcc as an irreversible level 2 lock, so never write that */
+	if ((changed_mask & 1U) && (words[0] & 0xffU) == 0xccU) {
+		tc_printf(target, "Refusing to set level 2 protection, use level 1 instead\n");
+		return false;
+	}
+
+	uint16_t opt_val[8U];
+	if (target_mem_read(target, opt_val, FLASH_OBP_RDP, sizeof(opt_val)))
+		return false;
+
+	/*
+	 * Option half-words can only be programmed from the erased state, so we only have to pay for an
+	 * erase (and rewrite everything) if one of the changed half-words is not already erased.
+	 */
+	bool erase_needed = false;
+	for (size_t i = 0U; i < 8U; ++i) {
+		if ((changed_mask & (1U << i)) && opt_val[i] != 0xffffU)
+			erase_needed = true;
+	}
+
+	if (!stm32f1_flash_unlock(target, FLASH_BANK1_OFFSET))
+		return false;
+	target_mem_write32(target, FLASH_OPTKEYR, KEY1);
+	target_mem_write32(target, FLASH_OPTKEYR, KEY2);
+	if (erase_needed && !stm32f1_option_erase(target))
+		return false;
+
+	/* GD32E230 is a special case as target_mem_write16 does not work */
+	const bool write16_broken = target->part_id == 0x410U && (target->cpuid & CORTEX_CPUID_PARTNO_MASK) == CORTEX_M23;
+	for (size_t i = 0U; i < 8U; ++i) {
+		if (!erase_needed && !(changed_mask & (1U << i)))
+			continue;
+		if (!stm32f1_option_write_erased(target, i, words[i] & 0xffffU, write16_broken))
+			return false;
+	}
+	tc_printf(target, "Option bytes take effect on the next reset\n");
+	return true;
+}
+
 static bool stm32f1_cmd_option(target_s *target, int argc, const char **argv)
 {
 	const uint32_t read_protected = target_mem_read32(target, FLASH_OBR) & FLASH_OBR_RDPRT;
@@ -53,6 +53,7 @@ static void stm32f4_detach(target_s *t);
 static bool stm32f4_flash_erase(target_flash_s *f, target_addr_t addr, size_t len);
 static bool stm32f4_flash_write(target_flash_s *f, target_addr_t dest, const void *src, size_t len);
 static bool stm32f4_mass_erase(target_s *t);
+static bool stm32f4_crc32(target_s *t, uint32_t *result, target_addr_t base, size_t len);
 
 /* Flash Program and Erase Controller Register Map */
 #define FPEC_BASE     0x40023c00U
@@ -112,6 +113,28 @@ static bool stm32f4_mass_erase(target_s *t);
 #define DBGMCU_CR_DBG_STOP    (0x1U << 1U)
 #define DBGMCU_CR_DBG_STANDBY (0x1U << 2U)
 
+#define STM32F4_CRC_BASE        0x40023000U
+#define STM32F4_RCC_AHB1ENR     0x40023830U
+#define STM32F4_RCC_AHB1ENR_CRC (1U << 12U)
+
+/* The F2's and F4's CRC unit is fixed function */
+static const stm32_crc_unit_s stm32f4_crc_unit = {
+	.base = STM32F4_CRC_BASE,
+	.rcc_enable_reg = STM32F4_RCC_AHB1ENR,
+	.rcc_enable_bit = STM32F4_RCC_AHB1ENR_CRC,
+	.stub_addr = 0x20000000U,
+	.flags = 0U,
+};
+
+/* The F7's is fully programmable, and the stub runs from ITCM as the size of DTCM varies across the family */
+static const stm32_crc_unit_s stm32f7_crc_unit = {
+	.base = STM32F4_CRC_BASE,
+	.rcc_enable_reg = STM32F4_RCC_AHB1ENR,
+	.rcc_enable_bit = STM32F4_RCC_AHB1ENR_CRC,
+	.stub_addr = 0x00000000U,
+	.flags = STM32_CRC_PROGRAMMABLE_INIT | STM32_CRC_PROGRAMMABLE_POLY,
+};
+
 typedef struct stm32f4_flash {
 	target_flash_s f;
 	align_e psize;
@@ -237,6 +260,7 @@ bool stm32f4_probe(target_s *t)
 		t->attach = stm32f4_attach;
 		t->detach = stm32f4_detach;
 		t->mass_erase = stm32f4_mass_erase;
+		t->crc32 = stm32f4_crc32;
 		t->driver = stm32f4_get_chip_name(device_id);
 		t->part_id = device_id;
 		target_add_commands(t, stm32f4_cmd_list, t->driver);
@@ -532,6 +556,12 @@ static bool stm32f4_flash_write(target_flash_s *f, target_addr_t dest, const voi
 	return stm32f4_flash_busy_wait(t, NULL);
 }
 
+static bool stm32f4_crc32(target_s *const t, uint32_t *const result, const target_addr_t base, const size_t len)
+{
+	const stm32_crc_unit_s *const unit = stm32f4_device_is_f7(t->part_id) ? &stm32f7_crc_unit : &stm32f4_crc_unit;
+	return stm32_crc32(t, unit, result, base, len);
+}
+
 static bool stm32f4_mass_erase(target_s *t)
 {
 	/* XXX: Is it correct to grab the most recently added Flash region here? What is this really trying to do? */
@@ -50,6 +50,7 @@
 #include "target_internal.h"
 #include "cortexm.h"
 #include "command.h"
+#include "stm32_common.h"
 
 /* Flash */
 #define FLASH_START            0x08000000U
@@ -140,6 +141,19 @@
 #define G0_RCC_BASE       0x40021000U
 #define RCC_APBENR1       (G0_RCC_BASE + 0x3cU)
 #define RCC_APBENR1_DBGEN (1U << 27U)
+#define RCC_AHBENR        (G0_RCC_BASE + 0x38U)
+#define RCC_AHBENR_CRCEN  (1U << 12U)
+
+/* CRC */
+#define G0_CRC_BASE 0x40023000U
+
+static const stm32_crc_unit_s stm32g0_crc_unit = {
+	.base = G0_CRC_BASE,
+	.rcc_enable_reg = RCC_AHBENR,
+	.rcc_enable_bit = RCC_AHBENR_CRCEN,
+	.stub_addr = RAM_START,
+	.flags = STM32_CRC_PROGRAMMABLE_INIT | STM32_CRC_PROGRAMMABLE_POLY,
+};
 
 /* DBG */
 #define DBG_BASE                  0x40015800U
@@ -178,6 +192,7 @@ static void stm32g0_detach(target_s *t);
 static bool stm32g0_flash_erase(target_flash_s *f, target_addr_t addr, size_t len);
 static bool stm32g0_flash_write(target_flash_s *f, target_addr_t dest, const void *src, size_t len);
 static bool stm32g0_mass_erase(target_s *t);
+static bool stm32g0_crc32(target_s *t, uint32_t *result, target_addr_t base, size_t len);
 
 /* Custom commands */
 static bool stm32g0_cmd_erase_bank(target_s *t, int argc, const char **argv);
@@ -276,6 +291,7 @@ bool stm32g0_probe(target_s *t)
 	t->attach = stm32g0_attach;
 	t->detach = stm32g0_detach;
 	t->mass_erase = stm32g0_mass_erase;
+	t->crc32 = stm32g0_crc32;
 	target_add_commands(t, stm32g0_cmd_list, t->driver);
 
 	/* Save private storage */
@@ -478,6 +494,11 @@ static bool stm32g0_flash_write(target_flash_s *f, target_addr_t dest, const voi
 	return true;
 }
 
+static bool stm32g0_crc32(target_s *t, uint32_t *const result, const target_addr_t base, const size_t len)
+{
+	return stm32_crc32(t, &stm32g0_crc_unit, result, base, len);
+}
+
 static bool stm32g0_mass_erase(target_s *t)
 {
 	const uint32_t ctrl = FLASH_CR_MER1 | FLASH_CR_MER2 | FLASH_CR_START;
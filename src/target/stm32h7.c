@@ -131,10 +131,25 @@
 #define ID_STM32H7Bx 0x4800U /* RM0455 */
 #define ID_STM32H72x 0x4830U /* RM0468 */
 
+#define STM32H7_CRC_BASE        0x58024c00U
+#define STM32H7_RCC_AHB4ENR     0x580244e0U
+#define STM32H7_RCC_AHB4ENR_CRC (1U << 19U)
+
+/* The stub runs from ITCM as it's present on every part and never goes through the caches */
+static const stm32_crc_unit_s stm32h7_crc_unit = {
+	.base = STM32H7_CRC_BASE,
+	.rcc_enable_reg = STM32H7_RCC_AHB4ENR,
+	.rcc_enable_bit = STM32H7_RCC_AHB4ENR_CRC,
+	.stub_addr = 0x00000000U,
+	.flags = STM32_CRC_PROGRAMMABLE_INIT | STM32_CRC_PROGRAMMABLE_POLY,
+};
+
 typedef struct stm32h7_flash {
 	target_flash_s target_flash;
 	align_e psize;
 	uint32_t regbase;
+	/* Whether the bank's controller has been set up for programming by the current write operation */
+	bool programming;
 } stm32h7_flash_s;
 
 typedef struct stm32h7_priv {
@@ -160,7 +175,9 @@ static bool stm32h7_attach(target_s *target);
 static void stm32h7_detach(target_s *target);
 static bool stm32h7_flash_erase(target_flash_s *target_flash, target_addr_t addr, size_t len);
 static bool stm32h7_flash_write(target_flash_s *target_flash, target_addr_t dest, const void *src, size_t len);
+static bool stm32h7_flash_done(target_flash_s *target_flash);
 static bool stm32h7_mass_erase(target_s *target);
+static bool stm32h7_crc32(target_s *target, uint32_t *result, target_addr_t base, size_t len);
 
 static void stm32h7_add_flash(target_s *target, uint32_t addr, size_t length, size_t blocksize)
 {
@@ -176,8 +193,11 @@ static void stm32h7_add_flash(target_s *target, uint32_t addr, size_t length, si
 	target_flash->blocksize = blocksize;
 	target_flash->erase = stm32h7_flash_erase;
 	target_flash->write = stm32h7_flash_write;
+	target_flash->done = stm32h7_flash_done;
 	target_flash->writesize = 2048;
 	target_flash->erased = 0xffU;
+	/* Each bank has its own controller, so let operations on one run while the other is busy */
+	target_flash->concurrent = true;
 	if (addr < STM32H7_FLASH_BANK2_BASE)
 		flash->regbase = FPEC1_BASE;
 	else
@@ -195,6 +215,7 @@ bool stm32h7_probe(target_s *target)
 	target->attach = stm32h7_attach;
 	target->detach = stm32h7_detach;
 	target->mass_erase = stm32h7_mass_erase;
+	target->crc32 = stm32h7_crc32;
 	target_add_commands(target, stm32h7_cmd_list, target->driver);
 
 	/* Save private storage */
@@ -306,6 +327,10 @@ static bool stm32h7_flash_unlock(target_s *const target, const uint32_t addr)
 	return !(target_mem_read32(target, regbase + FLASH_CR) & FLASH_CR_LOCK);
 }
 
+/*
+ * Start erasing the sectors in the range, waiting only for each one to finish before starting the next.
+ * The last is left running so the other bank can be worked on meanwhile, stm32h7_flash_done() waits for it.
+ */
 static bool stm32h7_flash_erase(target_flash_s *const target_flash, target_addr_t addr, const size_t len)
 {
 	target_s *target = target_flash->t;
@@ -321,46 +346,56 @@ static bool stm32h7_flash_erase(target_flash_s *const target_flash, target_addr_
 	const uint32_t reg_base = flash->regbase;
 
 	for (size_t begin_sector = addr / FLASH_SECTOR_SIZE; begin_sector <= end_sector; ++begin_sector) {
+		/* Wait for the previous sector to finish and report errors */
+		if (!stm32h7_flash_busy_wait(target, reg_base))
+			return false;
+
 		/* Erase the current Flash sector */
 		const uint32_t ctrl = (psize * FLASH_CR_PSIZE16) | FLASH_CR_SER | (begin_sector * FLASH_CR_SNB_1);
 		target_mem_write32(target, reg_base + FLASH_CR, ctrl);
 		target_mem_write32(target, reg_base + FLASH_CR, ctrl | FLASH_CR_START);
-
-		/* Wait for the operation to complete and report errors */
-		DEBUG_INFO("Erasing, ctrl = %08" PRIx32 " status = %08" PRIx32 "\n",
-			target_mem_read32(target, reg_base + FLASH_CR), target_mem_read32(target, reg_base + FLASH_SR));
-
-		if (!stm32h7_flash_busy_wait(target, reg_base))
-			return false;
+		DEBUG_INFO("Erasing, ctrl = %08" PRIx32 "\n", ctrl);
 	}
-	return true;
+	return !target_check_error(target);
 }
 
+/*
+ * Queue data for programming. The controller stalls the bus while its write buffer is full,
+ * so the data can be written back to back and the bank only has to be waited on in stm32h7_flash_done().
+ */
 static bool stm32h7_flash_write(
 	target_flash_s *const target_flash, const target_addr_t dest, const void *const src, const size_t len)
 {
 	target_s *target = target_flash->t;
-	const stm32h7_flash_s *const flash = (stm32h7_flash_s *)target_flash;
-	/* Unlock the Flash */
-	if (!stm32h7_flash_unlock(target, dest))
-		return false;
+	stm32h7_flash_s *const flash = (stm32h7_flash_s *)target_flash;
+	if (!flash->programming) {
+		/* Unlock the Flash */
+		if (!stm32h7_flash_unlock(target, dest))
+			return false;
 
-	/* Prepare the Flash write operation */
-	const uint32_t ctrl = flash->psize * FLASH_CR_PSIZE16;
-	target_mem_write32(target, flash->regbase + FLASH_CR, ctrl);
-	target_mem_write32(target, flash->regbase + FLASH_CR, ctrl | FLASH_CR_PG);
-	/* does H7 stall?*/
+		/* Prepare the Flash write operation */
+		const uint32_t ctrl = flash->psize * FLASH_CR_PSIZE16;
+		target_mem_write32(target, flash->regbase + FLASH_CR, ctrl);
+		target_mem_write32(target, flash->regbase + FLASH_CR, ctrl | FLASH_CR_PG);
+		flash->programming = true;
+	}
 
 	/* Write the data to the Flash */
 	target_mem_write(target, dest, src, len);
+	return !target_check_error(target);
+}
 
-	/* Wait for the operation to complete and report errors */
-	if (!stm32h7_flash_busy_wait(target, flash->regbase))
-		return false;
+/* Wait for the bank to finish whatever was left running and report errors */
+static bool stm32h7_flash_done(target_flash_s *const target_flash)
+{
+	target_s *target = target_flash->t;
+	stm32h7_flash_s *const flash = (stm32h7_flash_s *)target_flash;
+	const bool result = stm32h7_flash_busy_wait(target, flash->regbase);
 
 	/* Close write windows */
 	target_mem_write32(target, flash->regbase + FLASH_CR, 0);
-	return true;
+	flash->programming = false;
+	return result;
 }
 
 static bool stm32h7_erase_bank(
@@ -397,6 +432,11 @@ static bool stm32h7_check_bank(target_s *const target, const uint32_t reg_base)
 	return !(status & FLASH_SR_ERROR_MASK);
 }
 
+static bool stm32h7_crc32(target_s *const target, uint32_t *const result, const target_addr_t base, const size_t len)
+{
+	return stm32_crc32(target, &stm32h7_crc_unit, result, base, len);
+}
+
 /* Both banks are erased in parallel.*/
 static bool stm32h7_mass_erase(target_s *target)
 {
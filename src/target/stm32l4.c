@@ -63,6 +63,8 @@ static void stm32l4_detach(target_s *t);
 static bool stm32l4_flash_erase(target_flash_s *f, target_addr_t addr, size_t len);
 static bool stm32l4_flash_write(target_flash_s *f, target_addr_t dest, const void *src, size_t len);
 static bool stm32l4_mass_erase(target_s *t);
+static bool stm32l4_protection_read(target_s *t, uint32_t *words);
+static bool stm32l4_protection_write(target_s *t, const uint32_t *words, uint32_t changed_mask);
 
 const command_s stm32l4_cmd_list[] = {
 	{"erase_bank1", stm32l4_cmd_erase_bank1, "Erase entire bank1 flash memory"},
@@ -214,6 +216,8 @@ typedef struct stm32l4_option_bytes_info {
 	const uint8_t word_count;
 } stm32l4_option_bytes_info_s;
 
+static stm32l4_option_bytes_info_s stm32l4_get_opt_bytes_info(uint16_t part_id);
+
 typedef enum stm32l4_flash_reg {
 	FLASH_KEYR,
 	FLASH_OPTKEYR,
@@ -597,6 +601,13 @@ bool stm32l4_probe(target_s *const t)
 		}
 	}
 	t->mass_erase = stm32l4_mass_erase;
+	/* Option byte handling is not implemented for the L5 and WB/WL parts */
+	if (device_id != ID_STM32L55 && device_id != ID_STM32WBXX && device_id != ID_STM32WB1X &&
+		device_id != ID_STM32WLXX) {
+		t->protection_words = stm32l4_get_opt_bytes_info(device_id).word_count;
+		t->protection_read = stm32l4_protection_read;
+		t->protection_write = stm32l4_protection_write;
+	}
 	t->attach = stm32l4_attach;
 	t->detach = stm32l4_detach;
 	target_add_commands(t, stm32l4_cmd_list, device->designator);
@@ -808,7 +819,7 @@ static bool stm32l4_cmd_erase_bank2(target_s *const t, const int argc, const cha
 }
 
 static bool stm32l4_option_write(target_s *const t, const uint32_t *const values, const size_t len,
-	const uint32_t fpec_base, const uint8_t *const opt_reg_offsets)
+	const uint32_t changed_mask, const uint32_t fpec_base, const uint8_t *const opt_reg_offsets)
 {
 	/* Unlock the option registers Flash */
 	stm32l4_flash_unlock(t);
@@ -818,13 +829,15 @@ static bool stm32l4_option_write(target_s *const t, const uint32_t *const values
 	if (!stm32l4_flash_busy_wait(t, NULL))
 		return true;
 
-	/* Write the new option register values and begin the programming operation */
-	for (size_t i = 0; i < len; i++)
-		target_mem_write32(t, fpec_base + opt_reg_offsets[i], values[i]);
+	/* Write the changed option register values and begin the programming operation */
+	for (size_t i = 0; i < len; i++) {
+		if (changed_mask & (1U << i))
+			target_mem_write32(t, fpec_base + opt_reg_offsets[i], values[i]);
+	}
 	stm32l4_flash_write32(t, FLASH_CR, FLASH_CR_OPTSTRT);
-	/* Wait for the operation to complete and report any errors */
+	/* Wait for the operation to complete and report any errors (this function returns true on failure) */
 	if (!stm32l4_flash_busy_wait(t, NULL))
-		return false;
+		return true;
 
 	tc_printf(t, "Scan and attach again\n");
 	/* Ask the device to reload its options bytes */
@@ -882,6 +895,25 @@ static stm32l4_option_bytes_info_s stm32l4_get_opt_bytes_info(const uint16_t par
 	}
 }
 
+static bool stm32l4_protection_read(target_s *const t, uint32_t *const words)
+{
+	const stm32l4_option_bytes_info_s info = stm32l4_get_opt_bytes_info(t->part_id);
+	const uint32_t fpec_base = stm32l4_fpec_base_addr(t);
+	for (size_t i = 0; i < info.word_count; ++i)
+		words[i] = target_mem_read32(t, fpec_base + info.offsets[i]);
+	return true;
+}
+
+static bool stm32l4_protection_write(target_s *const t, const uint32_t *const words, const uint32_t changed_mask)
+{
+	const stm32l4_option_bytes_info_s info = stm32l4_get_opt_bytes_info(t->part_id);
+	if ((words[0] & 0xffU) == 0xccU) {
+		tc_printf(t, "Refusing to set level 2 protection, use level 1 (0xbb) instead\n");
+		return false;
+	}
+	return !stm32l4_option_write(t, words, info.word_count, changed_mask, stm32l4_fpec_base_addr(t), info.offsets);
+}
+
 /*
  * Chip:      L43X/mask  L43x/def   L47x/mask  L47x/def   G47x/mask  G47x/def
  *                                  L49x/mask  L49x/def   G48x/mask  G48x/def
@@ -925,7 +957,7 @@ static bool stm32l4_cmd_option(target_s *t, int argc, const char **argv)
 
 	bool result = false;
 	if (argc == 2 && strcmp(argv[1], "erase") == 0)
-		result = stm32l4_option_write(t, values, word_count, fpec_base, opt_reg_offsets);
+		result = stm32l4_option_write(t, values, word_count, UINT32_MAX, fpec_base, opt_reg_offsets);
 	else if (argc > 2 && strcmp(argv[1], "write") == 0) {
 		const size_t option_words = MIN((size_t)argc - 2U, word_count);
 		for (size_t i = 0; i < option_words; ++i)
@@ -938,7 +970,7 @@ static bool stm32l4_cmd_option(target_s *t, int argc, const char **argv)
 			++values[0];
 			tc_printf(t, "Changing level 2 protection request to level 1!");
 		}
-		result = stm32l4_option_write(t, values, word_count, fpec_base, opt_reg_offsets);
+		result = stm32l4_option_write(t, values, word_count, UINT32_MAX, fpec_base, opt_reg_offsets);
 	} else {
 		tc_printf(t, "usage: monitor option erase\n");
 		tc_printf(t, "usage: monitor option write <value> ...\n");
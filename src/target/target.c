@@ -21,10 +21,17 @@
 #include "general.h"
 #include "target_internal.h"
 #include "gdb_packet.h"
+#include "memtest.h"
+#include "crc32.h"
 
 #include <stdarg.h>
 #include <unistd.h>
 
+#if PC_HOSTED == 1
+#include "freq_profile.h"
+#include "mem_codec.h"
+#endif
+
 target_s *target_list = NULL;
 
 #define STDOUT_READ_BUF_SIZE       64U
@@ -32,10 +39,13 @@ target_s *target_list = NULL;
 
 static bool target_cmd_mass_erase(target_s *target, int argc, const char **argv);
 static bool target_cmd_range_erase(target_s *target, int argc, const char **argv);
+static bool target_cmd_protection(target_s *target, int argc, const char **argv);
 
 const command_s target_cmd_list[] = {
 	{"erase_mass", target_cmd_mass_erase, "Erase whole device Flash"},
 	{"erase_range", target_cmd_range_erase, "Erase a range of memory on a device"},
+	{"protection", target_cmd_protection, "Read or change the option bytes/protection state in one go"},
+	{"memtest", target_cmd_memtest, "Test or fill memory on-target: <fill|walk|addr|march|pattern> <addr> <len>"},
 	{NULL, NULL, NULL},
 };
 
@@ -169,6 +179,9 @@ target_s *target_attach(target_s *target, target_controller_s *controller)
 	}
 
 	target->attached = true;
+#if PC_HOSTED == 1
+	freq_profile_apply(target);
+#endif
 	return target;
 }
 
@@ -278,11 +291,23 @@ int target_mem_read(target_s *t, void *dest, target_addr_t src, size_t len)
 
 int target_mem_write(target_s *t, target_addr_t dest, const void *src, size_t len)
 {
+#if PC_HOSTED == 1
+	/* Large writes of compressible data into RAM go faster expanded in place by the target itself */
+	if (len >= MEM_CODEC_MIN_LENGTH && mem_codec_write(t, dest, src, len))
+		return target_check_error(t);
+#endif
 	if (t->mem_write)
 		t->mem_write(t, dest, src, len);
 	return target_check_error(t);
 }
 
+bool target_crc32(target_s *t, uint32_t *result, target_addr_t base, size_t len)
+{
+	if (t->crc32 && t->crc32(t, result, base, len))
+		return true;
+	return generic_crc32(t, result, base, len);
+}
+
 /* target_mem_access_needs_halt() is true if the target needs to be halted during jtag memory access */
 
 bool target_mem_access_needs_halt(target_s *t)
@@ -460,6 +485,81 @@ static bool target_cmd_range_erase(target_s *const t, const int argc, const char
 	return target_flash_erase(t, addr, length);
 }
 
+static bool target_cmd_protection(target_s *const t, const int argc, const char **const argv)
+{
+	const size_t word_count = target_protection_words(t);
+	if (!word_count) {
+		gdb_out("Protection state access not implemented for target\n");
+		return true;
+	}
+
+	uint32_t words[TARGET_PROTECTION_MAX_WORDS];
+	if (!target_protection_read(t, words, word_count)) {
+		gdb_out("Reading protection state failed\n");
+		return false;
+	}
+
+	if (argc > 1) {
+		if ((size_t)argc - 1U > word_count) {
+			tc_printf(t, "usage: monitor protection [<word>|- ...]\n");
+			tc_printf(t, "\tup to %u words may be given, '-' leaves a word unchanged\n", (unsigned)word_count);
+			return false;
+		}
+		/* Build the complete new state, keeping any word given as '-' as it is now */
+		for (size_t i = 0; i < (size_t)argc - 1U; ++i) {
+			if (strcmp(argv[i + 1U], "-") != 0)
+				words[i] = strtoul(argv[i + 1U], NULL, 0);
+		}
+		if (!target_protection_apply(t, words, word_count)) {
+			gdb_out("Writing protection state failed\n");
+			return false;
+		}
+		if (!target_protection_read(t, words, word_count))
+			return false;
+	}
+
+	for (size_t i = 0; i < word_count; ++i)
+		tc_printf(t, "%2u: 0x%08" PRIx32 "\n", (unsigned)i, words[i]);
+	return true;
+}
+
+/* Option byte and protection state functions */
+size_t target_protection_words(target_s *const t)
+{
+	if (!t->protection_read || !t->protection_write)
+		return 0U;
+	return MIN(t->protection_words, TARGET_PROTECTION_MAX_WORDS);
+}
+
+bool target_protection_read(target_s *const t, uint32_t *const words, const size_t count)
+{
+	if (count != target_protection_words(t) || !count)
+		return false;
+	return t->protection_read(t, words) && !target_check_error(t);
+}
+
+/*
+ * Bring the protection state in line with the `count` words given by reading all the words back
+ * in one go, then asking the target to only program those that differ. When nothing changed,
+ * no unlock/program/reload cycle is run at all.
+ */
+bool target_protection_apply(target_s *const t, const uint32_t *const words, const size_t count)
+{
+	uint32_t current[TARGET_PROTECTION_MAX_WORDS];
+	if (!target_protection_read(t, current, count))
+		return false;
+
+	uint32_t changed_mask = 0U;
+	for (size_t i = 0; i < count; ++i) {
+		if (words[i] != current[i])
+			changed_mask |= 1U << i;
+	}
+	if (!changed_mask)
+		return true;
+	DEBUG_INFO("Protection state update, changed word mask 0x%04" PRIx32 "\n", changed_mask);
+	return t->protection_write(t, words, changed_mask) && !target_check_error(t);
+}
+
 /* Accessor functions */
 size_t target_regs_size(target_s *t)
 {
@@ -131,11 +131,72 @@ static bool flash_done(target_flash_s *flash)
 	return result;
 }
 
+/* Most Flash regions that can run concurrently a target will have, bounded by the biggest dual-bank parts */
+#define FLASH_CONCURRENT_MAX 2U
+
+typedef struct flash_erase_cursor {
+	target_flash_s *flash;
+	target_addr_t addr;
+	target_addr_t end;
+} flash_erase_cursor_s;
+
+/*
+ * Split an erase into the ranges of the regions it spans. Succeeds only if there's more than one
+ * and they can all run concurrently, in which case the erase can alternate between them.
+ */
+static size_t flash_erase_split(target_s *const target, target_addr_t addr, const size_t len,
+	flash_erase_cursor_s cursors[FLASH_CONCURRENT_MAX])
+{
+	const target_addr_t end = addr + len;
+	size_t count = 0;
+	while (addr < end) {
+		target_flash_s *const flash = target_flash_for_addr(target, addr);
+		if (!flash || !flash->concurrent || count == FLASH_CONCURRENT_MAX)
+			return 0;
+		cursors[count].flash = flash;
+		cursors[count].addr = addr & ~(flash->blocksize - 1U);
+		cursors[count].end = MIN(end, flash->start + flash->length);
+		addr = cursors[count++].end;
+	}
+	return count > 1U ? count : 0U;
+}
+
+/* Erase a range spanning several concurrent regions a block from each at a time so they erase side by side */
+static bool flash_erase_interleaved(flash_erase_cursor_s *const cursors, const size_t count)
+{
+	bool result = true; /* Catch false returns with &= */
+	for (bool pending = true; pending && result;) {
+		pending = false;
+		for (size_t i = 0; i < count && result; ++i) {
+			flash_erase_cursor_s *const cursor = &cursors[i];
+			if (cursor->addr >= cursor->end)
+				continue;
+			target_flash_s *const flash = cursor->flash;
+			result &= flash_prepare(flash, FLASH_OPERATION_ERASE);
+			if (result)
+				result &= flash->erase(flash, cursor->addr, flash->blocksize);
+			if (!result)
+				DEBUG_ERROR("Erase failed at %" PRIx32 "\n", cursor->addr);
+			cursor->addr += flash->blocksize;
+			pending |= cursor->addr < cursor->end;
+		}
+	}
+	/* Wait for all the regions to finish */
+	for (size_t i = 0; i < count; ++i)
+		result &= flash_done(cursors[i].flash);
+	return result;
+}
+
 bool target_flash_erase(target_s *target, target_addr_t addr, size_t len)
 {
 	if (!target_enter_flash_mode(target))
 		return false;
 
+	flash_erase_cursor_s cursors[FLASH_CONCURRENT_MAX];
+	const size_t concurrent_regions = flash_erase_split(target, addr, len, cursors);
+	if (concurrent_regions)
+		return flash_erase_interleaved(cursors, concurrent_regions);
+
 	target_flash_s *active_flash = target_flash_for_addr(target, addr);
 	if (!active_flash)
 		return false;
@@ -258,7 +319,9 @@ bool target_flash_write(target_s *target, target_addr_t dest, const void *src, s
 			active_flash = flash;
 		else if (flash->buf) {
 			result &= flash_buffered_flush(flash);
-			result &= flash_done(flash);
+			/* Let regions with their own controller carry on while we move on, target_flash_complete() finishes them */
+			if (!flash->concurrent)
+				result &= flash_done(flash);
 		}
 	}
 	if (!active_flash || !result)
@@ -272,7 +335,8 @@ bool target_flash_write(target_s *target, target_addr_t dest, const void *src, s
 		/* Terminate flash operations if we're not in the same target flash */
 		if (flash != active_flash) {
 			result &= flash_buffered_flush(active_flash);
-			result &= flash_done(active_flash);
+			if (!active_flash->concurrent)
+				result &= flash_done(active_flash);
 			active_flash = flash;
 		}
 		if (!flash->buf)
@@ -61,6 +61,7 @@ struct target_flash {
 	size_t writebufsize;         /* Size of write buffer, this is calculated and not set in target code */
 	uint8_t erased;              /* Byte erased state */
 	uint8_t operation;           /* Current Flash operation (none means it's idle/unprepared) */
+	bool concurrent;             /* Has its own controller, erase/write may return with the operation still running */
 	flash_prepare_func prepare;  /* Prepare for flash operations */
 	flash_erase_func erase;      /* Erase a range of flash */
 	flash_write_func write;      /* Write to flash */
@@ -140,6 +141,25 @@ struct target {
 	bool (*exit_flash_mode)(target_s *target);
 	bool flash_mode;
 
+	/*
+	 * Protection functions - the option bytes/protection state is modelled as an array of
+	 * `protection_words` 32-bit words. protection_write is handed the complete new set along with
+	 * a mask of the words which differ from what protection_read returned, and must program
+	 * just those words, reloading the device's option state once at the end.
+	 */
+	size_t protection_words;
+	bool (*protection_read)(target_s *target, uint32_t *words);
+	bool (*protection_write)(target_s *target, const uint32_t *words, uint32_t changed_mask);
+
+	/*
+	 * Checksum function - computes the CRC-32 GDB's qCRC packet expects over a range using the target's own
+	 * CRC hardware. Returns false if the hardware can't be used for this range, in which case the CRC is
+	 * computed by reading the range back instead.
+	 */
+	bool (*crc32)(target_s *target, uint32_t *result, target_addr_t base, size_t len);
+	/* Same again for targets whose hardware computes the IEEE 802.3 (zlib) CRC-32 instead, used for verification */
+	bool (*crc32_ieee)(target_s *target, uint32_t *result, target_addr_t base, size_t len);
+
 	/* Target-defined options */
 	uint32_t target_options;
 